@@ -0,0 +1,114 @@
+// c++
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+// ROOT
+#include "TChain.h"
+
+// CMS2
+#include "CMS2/NtupleMacrosHeader/interface/CMS2.h"
+#include "AnalysisTools/CMS2Tools/interface/CMS2Wrapper.h"
+
+// Tools
+#include "AnalysisTools/CMS2Tools/interface/LumiIndex.h"
+#include "AnalysisTools/CMS2Tools/interface/EventIndex.h"
+#include "AnalysisTools/RootTools/interface/MiscTools.h"
+#include "AnalysisTools/LanguageTools/interface/OSTools.h"
+
+// BOOST
+#include <boost/program_options.hpp>
+
+// ------------------------------------------------------------------------------------ //
+// Make the indexes of a CMS2 chain in one pass over it: 
+// the (run, lumi) --> (file, entries) index for at::set_lumi_index_file and/or
+// the (run, lumi, event) --> (file, entry) index for at::set_event_index_file
+// ------------------------------------------------------------------------------------ //
+
+int main(int argc, char* argv[])
+try
+{
+    // inputs
+    // -----------------------------------------------//
+
+    std::string input_files = "";
+    std::string lumi_index_file  = "";
+    std::string event_index_file = "";
+    std::string tree_name   = "Events";
+    bool verbose            = false;
+
+    namespace po = boost::program_options;
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help"       , "print this menu")
+        ("input"      , po::value<std::string>(&input_files)->required(), "REQUIRED: comma seperated list of input files (globs allowed)"    )
+        ("lumi-index" , po::value<std::string>(&lumi_index_file)        , "name of the lumi index file (at least one of the two is required)")
+        ("event-index", po::value<std::string>(&event_index_file)       , "name of the event index file"                                     )
+        ("tree"       , po::value<std::string>(&tree_name)              , "tree name (default is Events)"                                   )
+        ("verbose"    , po::value<bool>(&verbose)                       , "print each file as it is indexed"                                )
+        ;
+
+    // parse it
+    try
+    {
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) 
+        {
+            std::cout << desc << "\n";
+            return 1;
+        }
+
+        po::notify(vm);
+
+        if (lumi_index_file.empty() && event_index_file.empty())
+        {
+            throw std::invalid_argument("at least one of --lumi-index or --event-index is required");
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\nexiting" << std::endl;
+        std::cout << desc << "\n";
+        return 1;
+    }
+
+    // build the indexes
+    // -----------------------------------------------//
+
+    std::cout << "[cms2tools_index] indexing " << input_files << std::endl;
+    TChain* const chain = rt::CreateTChainFromCommaSeperatedList(input_files, tree_name);
+    at::LumiIndex lumi_index;
+    at::EventIndex event_index;
+    at::BuildIndexes
+    (
+        *chain, 
+        cms2, 
+        (lumi_index_file.empty()  ? NULL : &lumi_index ), 
+        (event_index_file.empty() ? NULL : &event_index), 
+        verbose
+    );
+    if (not lumi_index_file.empty())
+    {
+        lt::mkdir(lt::dirname(lumi_index_file), /*force=*/true);
+        lumi_index.Write(lumi_index_file);
+        std::cout << "[cms2tools_index] wrote " << lumi_index_file << std::endl; 
+    }
+    if (not event_index_file.empty())
+    {
+        lt::mkdir(lt::dirname(event_index_file), /*force=*/true);
+        event_index.Write(event_index_file);
+        std::cout << "[cms2tools_index] wrote " << event_index_file << std::endl; 
+    }
+    delete chain;
+
+    // done
+    return 0;
+}
+catch (std::exception& e)
+{
+    std::cerr << "[cms2tools_index] Error: failed..." << std::endl;
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,55 @@
+#ifndef AT_BLOOMFILTER_H
+#define AT_BLOOMFILTER_H
+
+// c++
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+namespace at
+{
+    // A simple Bloom filter over 64 bit hashes (k bit positions from double hashing).
+    // Insert is thread safe but two threads inserting the same key at the same 
+    // time may both be told it is new, so use a single thread when that matters.
+    class BloomFilter
+    {
+        public:
+
+            // sized for expected_size keys at the given false positive rate
+            BloomFilter(const size_t expected_size, const double false_positive_rate = 0.01);
+
+            // set the bits for the hash and return true if they were all set already (possibly seen)
+            bool Insert(const uint64_t hash);
+
+            // are all the bits for the hash set? 
+            bool Contains(const uint64_t hash) const;
+
+            // number of keys inserted
+            size_t NumInserted() const;
+
+            // false positive rate expected from the current fill of the bits
+            double EstimatedFalsePositiveRate() const;
+
+            // size of the bit array
+            size_t NumBits() const;
+            unsigned int NumHashes() const;
+
+            // memory used in bytes
+            size_t MemoryUsage() const;
+
+        private:
+
+            // non-copyable
+            BloomFilter(const BloomFilter&);
+            BloomFilter& operator=(const BloomFilter&);
+
+            std::vector<std::atomic<uint64_t> > m_words;
+            size_t m_num_bits;
+            unsigned int m_num_hashes;
+            std::atomic<size_t> m_num_inserted;
+    };
+
+} // namespace at
+
+#endif // AT_BLOOMFILTER_H
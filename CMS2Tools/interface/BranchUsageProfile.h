@@ -0,0 +1,80 @@
+#ifndef AT_BRANCHUSAGEPROFILE_H
+#define AT_BRANCHUSAGEPROFILE_H
+
+// c++
+#include <string>
+#include <vector>
+#include <set>
+#include <iosfwd>
+
+// ROOT
+class TTree;
+
+namespace at
+{
+    // The (top level) branches of a tree that an analysis reads.
+    // Learned from the branches that were read (TBranch::GetReadEntry) and saved as a 
+    // text file (one branch name per line) so that later jobs only read and cache those.
+    class BranchUsageProfile
+    {
+        public:
+
+            BranchUsageProfile();
+
+            // read from a file made with Write
+            explicit BranchUsageProfile(const std::string& file_name);
+
+            // read/write the text file (throws on failure)
+            void Read(const std::string& file_name);
+            void Write(const std::string& file_name) const;
+
+            // add the branches of the tree that were read since it was opened 
+            // (branches read while disabled by Prune are remembered as missed)
+            void Learn(TTree& tree);
+
+            // same as Learn but throws if a branch was read while disabled by Prune 
+            // (its values were not loaded)
+            void Verify(TTree& tree);
+
+            // disable the branches not in the profile and cache only the ones in it 
+            // (call after the ntuple class's Init and the TTreeCache set up)
+            void Prune(TTree& tree) const;
+
+            // add the branches of another profile
+            void Merge(const BranchUsageProfile& other);
+
+            // the branches in the profile
+            const std::set<std::string>& GetBranchNames() const;
+            std::vector<std::string> GetBranchNameList() const;
+            size_t Size() const;
+            bool Empty() const;
+
+            // branches that were read while pruned (the analysis changed: relearn the profile)
+            const std::set<std::string>& GetMissedBranchNames() const;
+
+            // summary line for the ScanChain functions
+            void Print(std::ostream& out) const;
+
+        private:
+
+            std::set<std::string> m_branch_names;
+            std::set<std::string> m_missed_branch_names;
+    };
+
+    // The profile used by the ScanChain functions (empty file name --> read every branch as usual):
+    // if the file exists only its branches are read and cached, otherwise the branches that are 
+    // read are recorded and written to the file at the end of the job.
+    // learn_entries > 0: while recording also prune after that many entries of the first file 
+    // (faster; serial ScanChain only).
+    // A pruned branch that is read anyway (not in the profile, or first read after the window) 
+    // is not loaded: the job stops with an error within 1024 entries.
+    void set_branch_usage_profile(const std::string& file_name, const long learn_entries = 0);
+    const std::string& get_branch_usage_file();
+    long get_branch_usage_learn_entries();
+
+    // read the ScanChain profile into profile (false if none is set or the file doesn't exist yet)
+    bool LoadBranchUsageProfile(BranchUsageProfile& profile);
+
+} // namespace at
+
+#endif // AT_BRANCHUSAGEPROFILE_H
@@ -1,6 +1,10 @@
 #ifndef AT_DORKYEVENTIDENTFIER_H
 #define AT_DORKYEVENTIDENTFIER_H
 
+// c++
+#include <cstddef>
+#include <iosfwd>
+
 namespace at
 {
     struct DorkyEventIdentifier 
@@ -11,8 +15,46 @@ namespace at
         bool operator == (const DorkyEventIdentifier &) const;
     };
 
+    // returns true if the id has been seen before (thread safe)
+    // (see DuplicateEventFilter.h to reserve space up front)
     bool is_duplicate(const DorkyEventIdentifier &id);
 
+    // how at::is_duplicate finds the duplicates
+    struct DuplicateFilterMode
+    {
+        enum value_type
+        {
+            EXACT,    // 0: every id is kept in the exact set (DuplicateEventFilter)
+            TWO_TIER, // 1: a pre-scan through a Bloom filter picks the candidates and only
+                      //    those are kept in the exact set (TwoTierDuplicateFilter)
+            static_size
+        };
+    };
+
+    // set the mode of at::is_duplicate (ScanChain runs the pre-scan for TWO_TIER)
+    void set_duplicate_filter_mode(const DuplicateFilterMode::value_type mode, const double false_positive_rate = 0.01);
+    DuplicateFilterMode::value_type get_duplicate_filter_mode();
+
+    // the two tier filter for a pre-scan of the TWO_TIER mode: the first one makes it (sized for expected_size ids),
+    // the later ones extend it so duplicates across ScanChain calls are still found (past expected_size only 
+    // the false positive rate goes up)
+    class TwoTierDuplicateFilter;
+    TwoTierDuplicateFilter& begin_duplicate_prescan(const size_t expected_size);
+
+    // forget every id at::is_duplicate has seen (e.g. between independent ScanChain calls)
+    void reset_duplicate_filter();
+
+    // the current two tier filter (NULL before begin_duplicate_prescan)
+    TwoTierDuplicateFilter* get_two_tier_duplicate_filter();
+
+    // memory used by the at::is_duplicate filter of the current mode in bytes
+    size_t get_duplicate_filter_memory_usage();
+
+    // write/read the ids at::is_duplicate has seen in the current mode (e.g. for a checkpoint)
+    // (TWO_TIER: after the pre-scan)
+    void save_duplicate_state(std::ostream& out);
+    void load_duplicate_state(std::istream& in);
+
 } // namespace at
 
 #endif // AT_DORKYEVENTIDENTFIER_H
@@ -0,0 +1,84 @@
+#ifndef AT_DUPLICATEEVENTFILTER_H
+#define AT_DUPLICATEEVENTFILTER_H
+
+// c++
+#include <vector>
+#include <set>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+namespace at
+{
+    struct DorkyEventIdentifier;
+
+    // Concurrent set of (run, lumi, event) used to remove duplicate events.
+    // The ids are packed into a 64 bit key (20 bits run, 12 bits lumi, 32 bits event)
+    // and stored in open addressing hash tables split into shards by the hash.  
+    // Inserts are lock free (CAS on the slot); a shard only blocks its users while it grows.
+    // The rare ids that do not fit the 64 bit key (e.g. lumi >= 4096) go into a 
+    // mutex guarded set of the full (run, lumi, event).
+    class DuplicateEventFilter
+    {
+        public:
+
+            // expected_size: number of events to reserve space for (0 --> grow as needed)
+            explicit DuplicateEventFilter(const size_t expected_size = 0);
+            ~DuplicateEventFilter();
+
+            // insert the id and return true if it was already in the set (thread safe)
+            bool Insert(const DorkyEventIdentifier& id);
+            bool Insert(const unsigned int run, const unsigned int lumi, const unsigned int event);
+
+            // is the id in the set? (thread safe)
+            bool Contains(const DorkyEventIdentifier& id) const;
+            bool Contains(const unsigned int run, const unsigned int lumi, const unsigned int event) const;
+
+            // reserve space for this many events (not thread safe)
+            void Reserve(const size_t expected_size);
+
+            // remove all the events (not thread safe)
+            void Clear();
+
+            // number of events in the set
+            size_t Size() const;
+
+            // memory used by the tables in bytes
+            size_t MemoryUsage() const;
+
+            // write/read the ids as binary (e.g. for a checkpoint); Load replaces the contents
+            // (not thread safe, throws on failure)
+            void Save(std::ostream& out) const;
+            void Load(std::istream& in);
+
+        private:
+
+            // non-copyable
+            DuplicateEventFilter(const DuplicateEventFilter&);
+            DuplicateEventFilter& operator=(const DuplicateEventFilter&);
+
+            struct Shard;
+            std::vector<std::unique_ptr<Shard> > m_shards;
+
+            // ids that don't fit in 64 bits
+            struct WideKey
+            {
+                unsigned long run, lumi, event;
+                bool operator < (const WideKey& rhs) const;
+            };
+            std::set<WideKey> m_wide_keys;
+            mutable std::mutex m_wide_mutex;
+    };
+
+    // the filter behind at::is_duplicate
+    DuplicateEventFilter& GetDuplicateEventFilter();
+
+    // reserve space in the at::is_duplicate filter (e.g. chain->GetEntries() for a data chain)
+    void reserve_duplicate_filter(const size_t expected_size);
+
+} // namespace at
+
+#endif // AT_DUPLICATEEVENTFILTER_H
@@ -0,0 +1,82 @@
+#ifndef AT_ENTRYRANGESCHEDULER_H
+#define AT_ENTRYRANGESCHEDULER_H
+
+// c++
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+// ROOT
+class TTree;
+class TChain;
+
+namespace at
+{
+    // how a chain is split into work for the workers of ScanChainParallel
+    struct ScanSplitMode
+    {
+        enum value_type
+        {
+            FILE,    // 0: one range per file 
+            CLUSTER, // 1: ranges aligned to the basket clusters of each tree 
+            static_size
+        };
+    };
+
+    // a range of entries [begin, end) of the tree in one file of a chain
+    struct EntryRange
+    {
+        size_t file_index;
+        long long begin;
+        long long end;
+    };
+
+    // one range per file of the chain (uses the chain's tree offsets, no files are opened)
+    std::vector<EntryRange> GetFileRanges(TChain& chain);
+
+    // split the tree into ranges aligned to its basket clusters.
+    // consecutive clusters are grouped until a range has at least min_entries
+    // so no cluster (and no basket written with AutoFlush) is shared by two ranges.
+    std::vector<EntryRange> GetClusterAlignedRanges(TTree& tree, const size_t file_index, const long long min_entries = 1);
+
+    // same as above for every file in the chain (opens each file once; a file that can't be opened
+    // is one range if the file fault policy skips bad files, see FileFaultPolicy.h)
+    std::vector<EntryRange> GetClusterAlignedRanges(TChain& chain, const long long min_entries = 1);
+
+    // the parts of the ranges that are inside the owned ranges (e.g. from a LumiIndex);
+    // both sorted by file and entry without overlaps
+    std::vector<EntryRange> IntersectRanges(const std::vector<EntryRange>& ranges, const std::vector<EntryRange>& owned);
+
+    // Hands out EntryRanges to a fixed number of workers.
+    // Each worker starts with a contiguous block of the ranges (balanced by number of entries)
+    // and takes them front to back so it reads its files sequentially.  
+    // When a worker runs out it steals from the back of another worker's queue. 
+    class EntryRangeScheduler
+    {
+        public:
+
+            EntryRangeScheduler(const std::vector<EntryRange>& ranges, const size_t num_workers);
+
+            // get the next range for this worker (false --> no work is left)
+            bool Next(const size_t worker, EntryRange& range);
+
+            // number of ranges taken from another worker's queue
+            size_t NumSteals() const;
+
+        private:
+
+            struct WorkQueue
+            {
+                std::mutex mutex;
+                std::deque<EntryRange> ranges;
+            };
+
+            std::vector<std::unique_ptr<WorkQueue> > m_queues;
+            std::atomic<size_t> m_num_steals;
+    };
+
+} // namespace at
+
+#endif // AT_ENTRYRANGESCHEDULER_H
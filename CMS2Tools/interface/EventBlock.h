@@ -0,0 +1,97 @@
+#ifndef AT_EVENTBLOCK_H
+#define AT_EVENTBLOCK_H
+
+// c++
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// ROOT
+class TTree;
+class TLeaf;
+
+namespace at
+{
+    // A block of accepted entries of one file with the values of selected branches
+    // stored as columns, for analyzers that work on many events at once.
+    // An analyzer opts in by providing Analyze(const EventBlock&) and
+    // GetBlockBranchNames() (the branches to put in the columns); the ScanChain
+    // functions then call it once per block instead of Analyze(entry).
+    //
+    // Each column is jagged: the values of event i are
+    // [Offsets(c)[i], Offsets(c)[i+1]) in Values(c), so a scalar branch has one value
+    // per event and an array or vector branch has one value per element.
+    // The values are stored as doubles (the leaf's GetValue) so only numeric branches 
+    // (numbers and arrays or vectors of numbers) can be columns.
+    class EventBlock
+    {
+        public:
+
+            // capacity: maximum number of events in the block
+            EventBlock(const std::vector<std::string>& branch_names, const size_t capacity);
+
+            // read the columns from this tree from now on 
+            // (throws std::invalid_argument if a branch is missing or not numeric)
+            void SetTree(TTree& tree, const std::string& file_name);
+
+            // add the entry of the tree and read its column values 
+            // (a branch already read for the entry is not read again)
+            void Add(const long entry);
+
+            // remove the events (the tree is kept)
+            void Clear();
+
+            // number of events
+            size_t Size() const {return m_entries.size();}
+            bool Empty() const {return m_entries.empty();}
+            bool Full() const {return m_entries.size() >= m_capacity;}
+            size_t Capacity() const {return m_capacity;}
+
+            // the entries in the tree of the events
+            const std::vector<long>& Entries() const {return m_entries;}
+
+            // the tree and file of the events
+            TTree* Tree() const {return m_tree;}
+            const std::string& FileName() const {return m_file_name;}
+
+            // columns
+            size_t NumColumns() const {return m_branch_names.size();}
+            const std::vector<std::string>& GetBranchNames() const {return m_branch_names;}
+
+            // index of the column of the branch (throws std::invalid_argument if it is not in the block)
+            size_t Column(const std::string& branch_name) const;
+
+            // the values of the column and where each event starts in them (Size() + 1 offsets)
+            const std::vector<double>& Values(const size_t column) const {return m_values.at(column);}
+            const std::vector<size_t>& Offsets(const size_t column) const {return m_offsets.at(column);}
+
+            // the values of the column for one event
+            const double* Begin(const size_t column, const size_t event) const;
+            const double* End(const size_t column, const size_t event) const;
+            size_t NumValues(const size_t column, const size_t event) const;
+
+        private:
+
+            size_t m_capacity;
+            std::vector<std::string> m_branch_names;
+            TTree* m_tree;
+            std::string m_file_name;
+            std::vector<TLeaf*> m_leaves;
+            std::vector<long> m_entries;
+            std::vector<std::vector<double> > m_values;
+            std::vector<std::vector<size_t> > m_offsets;
+    };
+
+    // does the analyzer have Analyze(const EventBlock&) and GetBlockBranchNames()?
+    template <typename Analyzer>
+    struct HasEventBlockAnalyze;
+
+    // the number of events in the blocks of the ScanChain functions (default is 256)
+    void set_event_block_size(const size_t block_size);
+    size_t get_event_block_size();
+
+} // namespace at
+
+#include "AnalysisTools/CMS2Tools/src/EventBlock.impl.h"
+
+#endif // AT_EVENTBLOCK_H
@@ -0,0 +1,139 @@
+#ifndef AT_EVENTINDEX_H
+#define AT_EVENTINDEX_H
+
+// c++
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <iosfwd>
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/EntryRangeScheduler.h"
+#include "AnalysisTools/CMS2Tools/interface/LumiIndex.h"
+
+// ROOT
+class TChain;
+
+namespace at
+{
+    // Map of (run, lumi, event) --> (file, entry) for a chain.
+    // Built once per dataset (see cms2tools_index) and saved as a binary sidecar file
+    // so that picking a few events only opens the files that have them and reads only their entries.
+    // A read index keeps only the file list in memory: the locations are fixed size records sorted by
+    // (run, lumi, event) so they are binary searched in the file and only the matching ones are read.
+    class EventIndex
+    {
+        public:
+
+            // where an event is in the chain
+            struct Location
+            {
+                unsigned int run;
+                unsigned int lumi;
+                unsigned int event;
+                unsigned int file_index;
+                long long entry;
+            };
+
+            EventIndex();
+
+            // read from a file made with Write
+            explicit EventIndex(const std::string& file_name);
+
+            ~EventIndex();
+
+            // build the index from the chain (reads only the event id of every entry, see BuildIndexes)
+            template <typename NtupleClass>
+            void Build(TChain& chain, NtupleClass& ntuple_class, const bool verbose = false);
+
+            // build the index one file at a time (what Build does): BeginBuild, then for each file 
+            // AddFile and AddEntry for each of its entries, then EndBuild to sort the events
+            void BeginBuild(const std::string& tree_name);
+            void AddFile(const std::string& file_name, const long long num_entries);
+            void AddEntry(const unsigned int run, const unsigned int lumi, const unsigned int event, const long long entry);
+            void EndBuild();
+
+            // read/write the binary file (throws on failure)
+            // Read only reads the header; the file is kept open for the lookups
+            void Read(const std::string& file_name);
+            void Write(const std::string& file_name) const;
+
+            // is this file in the index?
+            bool Contains(const std::string& file_name) const;
+
+            // number of entries of the file (throws if the file is not in the index)
+            long long GetEntries(const std::string& file_name) const;
+
+            // the locations of the event (more than one if it is duplicated)
+            std::vector<Location> Find(const unsigned int run, const unsigned int lumi, const unsigned int event) const;
+
+            // the locations that pass the selection sorted by (file, entry) (-1 --> any run, lumi or event)
+            // a selection with a run is a range lookup, otherwise every event in the index is checked
+            std::vector<Location> Select(const int run, const int lumi, const int event) const;
+
+            // the entries of the file that pass the selection (adjacent entries are merged)
+            // file_index is the index of the file in the chain (throws if the file is not in the index; thread safe)
+            std::vector<EntryRange> GetRanges(const std::string& file_name, const size_t file_index, const int run, const int lumi, const int event) const;
+
+            // clear the index
+            void Clear();
+
+            // number of events in the index
+            size_t Size() const {return m_num_locations;}
+
+            // list of file names
+            const std::vector<std::string>& GetFileNames() const {return m_file_names;}
+
+        private:
+
+            // non-copyable
+            EventIndex(const EventIndex&);
+            EventIndex& operator=(const EventIndex&);
+
+            size_t FileIndex(const std::string& file_name) const;
+
+            // the locations [first, first + count) (fewer at the end of the index; thread safe)
+            void ReadLocations(const size_t first, const size_t count, std::vector<Location>& locations) const;
+
+            // the first location that is not less than value
+            size_t LowerBound(const Location& value) const;
+
+            std::string m_tree_name;
+            std::vector<std::string> m_file_names;
+            std::vector<long long> m_file_entries;
+            std::map<std::string, size_t> m_file_map;
+
+            // sorted by (run, lumi, event, file, entry)
+            // in memory for a built index, in the file (from m_locations_offset on) for a read one
+            std::vector<Location> m_locations;
+            size_t m_num_locations;
+            std::string m_file_name;
+            long long m_locations_offset;
+            std::unique_ptr<std::ifstream> m_in;
+            mutable std::mutex m_in_mutex;
+
+            // the last selection asked for in GetRanges (ScanChain asks once per file)
+            mutable std::mutex m_selected_mutex;
+            mutable int m_selected_run;
+            mutable int m_selected_lumi;
+            mutable int m_selected_event;
+            mutable std::vector<std::vector<EntryRange> > m_selected_ranges;
+    };
+
+    // the index used by the ScanChain functions to pick events by (run, lumi, event) (empty file name --> no index)
+    void set_event_index_file(const std::string& file_name);
+    const EventIndex* get_event_index();
+
+    // the entries of the file that the ScanChain functions read for the evt_run/evt_lumi/evt_event arguments:
+    // the ones from the event index if there is a selection and the index has the file, otherwise all of them.
+    // num_entries: the entries of the file as the chain counts them (-1 --> not checked); a file with a 
+    // different number in the index was changed since it was indexed so all of its entries are read (with a warning)
+    OwnedEntryCursor GetSelectedEntries(const std::string& file_name, const int evt_run, const int evt_lumi, const int evt_event, const long long num_entries = -1);
+
+} // namespace at
+
+#include "AnalysisTools/CMS2Tools/src/EventIndex.impl.h"
+
+#endif // AT_EVENTINDEX_H
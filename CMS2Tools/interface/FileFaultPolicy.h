@@ -0,0 +1,107 @@
+#ifndef AT_FILEFAULTPOLICY_H
+#define AT_FILEFAULTPOLICY_H
+
+// c++
+#include <string>
+#include <vector>
+#include <mutex>
+#include <iosfwd>
+
+// ROOT
+class TFile;
+class TTree;
+
+namespace at
+{
+    // what the ScanChain functions do with a file that can't be opened or has no valid tree
+    struct FileFaultPolicy
+    {
+        enum value_type
+        {
+            FAIL,  // throw std::runtime_error (the job stops)
+            SKIP,  // skip the file and its entries
+            RETRY, // try to open it again (waiting longer each time), then skip it
+            static_size
+        };
+    };
+
+    // the policy (default is FAIL)
+    // num_retries: number of retries for RETRY
+    // backoff: seconds before the first retry (doubled before each of the next ones)
+    void set_file_fault_policy(const FileFaultPolicy::value_type policy, const unsigned int num_retries = 3, const double backoff = 5.0);
+    FileFaultPolicy::value_type get_file_fault_policy();
+    unsigned int get_file_fault_retries();
+    double get_file_fault_backoff();
+
+    // Open the file and get its tree, retrying as the fault policy says.
+    // Returns the error of the last attempt (empty if the file and tree are good: the caller owns the file).
+    // root_mutex (if any) is held around each attempt (TFile::Open modifies ROOT's global lists) but not while waiting.
+    std::string OpenFileAndTree
+    (
+        const std::string& file_name,
+        const std::string& tree_name,
+        TFile*& file,
+        TTree*& tree,
+        unsigned int& num_attempts,
+        std::mutex* const root_mutex = NULL
+    );
+
+    // The files a job gave up on (thread safe).
+    class BadFileReport
+    {
+        public:
+
+            struct BadFile
+            {
+                std::string file_name;
+                long long lost_entries; // entries of the file the job did not read (-1 --> unknown)
+                unsigned int attempts;
+                std::string error;
+            };
+
+            BadFileReport();
+
+            // add a file (or more lost entries of a file already in the report; -1 --> unknown)
+            void Add(const std::string& file_name, const long long lost_entries, const unsigned int attempts, const std::string& error);
+
+            // is the file in the report?
+            bool Contains(const std::string& file_name) const;
+
+            // number of files and the entries lost with them (the ones that are known)
+            size_t Size() const;
+            long long LostEntries() const;
+
+            // number of files with an unknown number of lost entries
+            size_t NumUnknownEntries() const;
+            std::vector<BadFile> GetBadFiles() const;
+
+            // print the list
+            void Print(std::ostream& out) const;
+
+            // write the list ("<file name> <lost entries> <attempts> <error>" per line, '#' comments)
+            void Write(const std::string& file_name) const;
+
+            // read a list made with Write (replaces the contents; throws on failure)
+            void Read(const std::string& file_name);
+
+        private:
+
+            // not copyable
+            BadFileReport(const BadFileReport&);
+            BadFileReport& operator=(const BadFileReport&);
+
+            std::vector<BadFile> m_bad_files;
+            mutable std::mutex m_mutex;
+    };
+
+    // the entries of a bad file that the chain could not count (TChain gives a file it can't open 0 entries):
+    // from the lumi or event index if either has the file, otherwise -1 (unknown)
+    long long GetBadFileEntries(const std::string& file_name);
+
+    // where the ScanChain functions write the list of the files they skipped (empty --> not written)
+    void set_bad_file_report(const std::string& file_name);
+    const std::string& get_bad_file_report();
+
+} // namespace at
+
+#endif // AT_FILEFAULTPOLICY_H
@@ -0,0 +1,110 @@
+#ifndef AT_FILEPREFETCHER_H
+#define AT_FILEPREFETCHER_H
+
+// c++
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// ROOT
+class TFile;
+class TTree;
+
+namespace at
+{
+    // Opens the files of a scan ahead of the event loop in a background thread 
+    // so that the file transitions (TFile::Open, reading the tree and the first baskets 
+    // over xrootd) overlap with the analysis of the current file.
+    class FilePrefetcher
+    {
+        public:
+
+            // a file ready to be read (close it with FilePrefetcher::Close)
+            struct PrefetchedFile
+            {
+                std::string file_name;
+                TFile* file;
+                TTree* tree;
+                bool cache_ready; // the TTreeCache is already set up
+                long long cache_size; // bytes of the TTreeCache budget the file holds (given back by Close)
+            };
+
+            // file_names: the files in the order Next returns them
+            // tree_name: name of the tree in each file
+            // use_caches: set up the TTreeCache of each file, sized with SetTreeCache from the shared 
+            //             memory budget (false --> leave the cache to the caller)
+            // depth: number of files opened ahead (0 --> Next opens the file, no thread)
+            FilePrefetcher
+            (
+                const std::vector<std::string>& file_names, 
+                const std::string& tree_name, 
+                const std::vector<bool>& use_caches,
+                const size_t depth
+            );
+
+            // closes the files that were not taken
+            ~FilePrefetcher();
+
+            // the next file (waits for it if it is not open yet)
+            // throws std::runtime_error if the file or tree is invalid (after the retries of the file fault policy)
+            // and std::out_of_range if there are no files left
+            PrefetchedFile Next();
+
+            // close a file returned by Next (TFile::Close is not safe while the background thread opens a file)
+            void Close(PrefetchedFile& prefetched_file);
+
+            // cache these branches in the files set up from now on (e.g. the branches the cache learned 
+            // in the first file) and read their first cluster in the background; empty --> cache learning as usual
+            void SetCachedBranches(const std::vector<std::string>& branch_names);
+
+            // the branches in the TTreeCache of a file (empty if it has no cache or is still learning)
+            static std::vector<std::string> GetCachedBranches(TFile& file, TTree& tree);
+
+            // time (s) Next spent waiting for files
+            double WaitTime() const;
+
+        private:
+
+            // non-copyable
+            FilePrefetcher(const FilePrefetcher&);
+            FilePrefetcher& operator=(const FilePrefetcher&);
+
+            // background thread: open files until depth of them are waiting
+            void OpenAhead();
+
+            // open the file and set up the cache (error is set if it fails)
+            PrefetchedFile Open(const size_t index, const std::vector<std::string>& branch_names, std::string& error);
+
+            std::vector<std::string> m_file_names;
+            std::string m_tree_name;
+            std::vector<bool> m_use_caches;
+            size_t m_depth;
+
+            // the opened files (by index) and their errors
+            std::vector<PrefetchedFile> m_files;
+            std::vector<std::string> m_errors;
+            std::vector<bool> m_ready;
+            size_t m_next_open;
+            size_t m_next_taken;
+            std::vector<std::string> m_branch_names;
+            bool m_stop;
+            double m_wait_time;
+
+            // guards the state above and ROOT's global lists (TFile::Open/Close)
+            mutable std::mutex m_mutex;
+            std::mutex m_root_mutex;
+            std::condition_variable m_opened;
+            std::condition_variable m_taken;
+            std::thread m_thread;
+    };
+
+    // number of files the ScanChain functions open ahead (default 1, 0 --> no prefetching)
+    void set_file_prefetch_depth(const size_t depth);
+    size_t get_file_prefetch_depth();
+
+} // namespace at
+
+#endif // AT_FILEPREFETCHER_H
@@ -0,0 +1,86 @@
+#ifndef AT_GOODRUNLIST_H
+#define AT_GOODRUNLIST_H
+
+// c++
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace at
+{
+    // format of the good run list file
+    struct GoodRunFileType
+    {
+        enum value_type
+        {
+            TEXT, // one "run [lumi_min lumi_max]" per line ('#' comments)
+            JSON, // certification JSON: {"run": [[lumi_min, lumi_max], ...], ...}
+            static_size
+        };
+    };
+
+    // Immutable list of the good (run, lumi) ranges.
+    // Everything is set in the constructor so a list can be shared between
+    // threads (or held per analyzer) and queried without locking.
+    // An empty list accepts every (run, lumi).
+    class GoodRunList
+    {
+        public:
+
+            // empty list (accepts everything)
+            GoodRunList();
+
+            // load the list from a file (throws std::runtime_error if it can't be read)
+            GoodRunList(const std::string& file_name, const GoodRunFileType::value_type file_type);
+
+            // load the list from a file, the type is taken from the extension (.json --> JSON, otherwise TEXT)
+            explicit GoodRunList(const std::string& file_name);
+
+            // is this (run, lumi) in the list? (thread safe)
+            bool Contains(const unsigned int run, const unsigned int lumi_block) const;
+            bool operator () (const unsigned int run, const unsigned int lumi_block) const {return Contains(run, lumi_block);}
+
+            // is this run in the list at all? (thread safe)
+            bool ContainsRun(const unsigned int run) const;
+
+            // number of lumi ranges
+            size_t Size() const {return m_lumi_min.size();}
+            bool Empty() const {return m_lumi_min.empty();}
+
+            // number of runs
+            size_t NumRuns() const {return m_runs.size();}
+
+            // first/last run and the lumi limits of the first/last range (-1 if empty)
+            int MinRun() const;
+            int MaxRun() const;
+            int MinRunMinLumi() const;
+            int MaxRunMaxLumi() const;
+
+            // file the list was read from (empty if none)
+            const std::string& FileName() const {return m_file_name;}
+
+        private:
+
+            // index of the run in m_runs (m_runs.size() if not found)
+            size_t FindRun(const unsigned int run) const;
+
+            // identifies this list in the per thread lookup cache
+            unsigned long m_id;
+
+            std::string m_file_name;
+
+            // flat sorted index of the ranges (structure of arrays):
+            // the ranges of m_runs[i] are [m_offsets[i], m_offsets[i+1]) in m_lumi_min/m_lumi_max
+            // (lumi_max == -1 --> no upper limit)
+            std::vector<unsigned int> m_runs;
+            std::vector<unsigned int> m_offsets;
+            std::vector<long long> m_lumi_min;
+            std::vector<long long> m_lumi_max;
+    };
+
+    // the list behind the goodrun() free functions (empty until one is loaded)
+    const GoodRunList& GetDefaultGoodRunList();
+
+} // namespace at
+
+#endif // AT_GOODRUNLIST_H
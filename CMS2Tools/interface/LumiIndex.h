@@ -0,0 +1,137 @@
+#ifndef AT_LUMIINDEX_H
+#define AT_LUMIINDEX_H
+
+// c++
+#include <string>
+#include <vector>
+#include <map>
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/EntryRangeScheduler.h"
+#include "AnalysisTools/CMS2Tools/interface/RunLumiPartition.h"
+
+// ROOT
+class TChain;
+
+namespace at
+{
+    class LumiIndex;
+    class EventIndex;
+
+    // build a lumi index and an event index of the chain in one pass (either can be NULL)
+    // reads only the event id of every entry (see LoadEventId; defined in EventIndex.impl.h)
+    template <typename NtupleClass>
+    void BuildIndexes(TChain& chain, NtupleClass& ntuple_class, LumiIndex* const lumi_index, EventIndex* const event_index, const bool verbose = false);
+
+    // Map of (run, lumi) --> (file, entry range) for a chain.
+    // Built once per dataset (see cms2tools_index) and saved as a text file so that a 
+    // shard of a RunLumiPartition only reads the entries (and the baskets) it owns.
+    // MC files have no blocks: every shard owns all of their entries.
+    class LumiIndex
+    {
+        public:
+
+            // consecutive entries of a file with the same (run, lumi)
+            struct Block
+            {
+                unsigned int run;
+                unsigned int lumi;
+                long long begin;
+                long long end;
+            };
+
+            LumiIndex();
+
+            // read from a file made with Write 
+            explicit LumiIndex(const std::string& file_name);
+
+            // build the index from the chain (reads the run and lumi of every entry, see BuildIndexes)
+            template <typename NtupleClass>
+            void Build(TChain& chain, NtupleClass& ntuple_class, const bool verbose = false);
+
+            // build the index one file at a time (what Build does): BeginBuild, then for each file 
+            // AddFile and AddEntry for each of its entries in order (none for an MC file)
+            void BeginBuild(const std::string& tree_name);
+            void AddFile(const std::string& file_name, const long long num_entries, const bool is_mc);
+            void AddEntry(const unsigned int run, const unsigned int lumi, const long long entry);
+
+            // read/write the text file (throws on failure)
+            void Read(const std::string& file_name);
+            void Write(const std::string& file_name) const;
+
+            // is this file in the index?
+            bool Contains(const std::string& file_name) const;
+
+            // number of entries of the file (throws if the file is not in the index)
+            long long GetEntries(const std::string& file_name) const;
+
+            // is this an MC file? (throws if the file is not in the index)
+            bool IsMC(const std::string& file_name) const;
+
+            // entry ranges of the file owned by the partition (adjacent blocks are merged; the whole file for MC)
+            // file_index is the index of the file in the chain (throws if the file is not in the index)
+            std::vector<EntryRange> GetRanges(const std::string& file_name, const size_t file_index, const RunLumiPartition& partition) const;
+
+            // same as above for every file in the list
+            std::vector<EntryRange> GetRanges(const std::vector<std::string>& file_names, const RunLumiPartition& partition) const;
+
+            // clear the index
+            void Clear();
+
+            // list of file names and blocks
+            const std::vector<std::string>& GetFileNames() const;
+            const std::vector<Block>& GetBlocks(const std::string& file_name) const;
+
+        private:
+
+            size_t FileIndex(const std::string& file_name) const;
+            void AddBlock(const size_t file_index, const unsigned int run, const unsigned int lumi, const long long entry);
+
+            std::string m_tree_name;
+            std::vector<std::string> m_file_names;
+            std::vector<long long> m_file_entries;
+            std::vector<bool> m_file_is_mc;
+            std::vector<std::vector<Block> > m_blocks;
+            std::map<std::string, size_t> m_file_map;
+    };
+
+    // Walks the owned entries of one file in entry order.
+    class OwnedEntryCursor
+    {
+        public:
+
+            // every entry is owned
+            OwnedEntryCursor();
+
+            // only the entries in the (sorted) ranges of a file with num_entries are owned
+            OwnedEntryCursor(const std::vector<EntryRange>& ranges, const long long num_entries);
+
+            // first owned entry >= entry (the number of entries of the file if there is none)
+            long long NextOwned(const long long entry);
+
+            // true if no entry is owned 
+            bool Empty() const;
+
+            // number of entries in the file (-1 if every entry is owned)
+            long long NumEntries() const;
+
+        private:
+
+            std::vector<EntryRange> m_ranges;
+            long long m_num_entries;
+            size_t m_current;
+    };
+
+    // the index used by the ScanChain functions with a RunLumiPartition (empty file name --> no index)
+    void set_lumi_index_file(const std::string& file_name);
+    const LumiIndex* get_lumi_index();
+
+    // the entries of the file that the ScanChain functions read: the ranges owned by the 
+    // current RunLumiPartition if the lumi index has the file, otherwise all of them
+    OwnedEntryCursor GetOwnedEntries(const std::string& file_name);
+
+} // namespace at
+
+#include "AnalysisTools/CMS2Tools/src/LumiIndex.impl.h"
+
+#endif // AT_LUMIINDEX_H
@@ -0,0 +1,52 @@
+#ifndef AT_LUMIPREFILTER_H
+#define AT_LUMIPREFILTER_H
+
+// c++
+#include <string>
+#include <vector>
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/EntryRangeScheduler.h"
+#include "AnalysisTools/CMS2Tools/interface/LumiIndex.h"
+#include "AnalysisTools/CMS2Tools/interface/GoodRunList.h"
+
+// ROOT
+class TTree;
+
+namespace at
+{
+    // Two phase read: load only what Run, LumiBlock, Event and IsRealData need for the entry.
+    // An ntuple class opts in by providing GetEventIdEntry(ntuple_class, entry) next to its 
+    // GetEntry; otherwise this is the full GetEntry (e.g. CMS2, whose GetEntry already 
+    // reads a branch only when it is accessed).
+    // Returns true if the rest of the entry still has to be loaded with GetEntry.
+    template <typename NtupleClass>
+    bool LoadEventId(NtupleClass& ntuple_class, const long entry);
+
+    // does the ntuple class provide GetEventIdEntry?
+    template <typename NtupleClass>
+    struct HasEventIdEntry;
+
+    // The entry ranges of the tree without the clusters that only hold data from (run, lumi)s
+    // that fail the good run list, so their baskets are never read.
+    // The (run, lumi)s come from the lumi index if it has the file, otherwise from the event id
+    // branches (only if the ntuple class has GetEventIdEntry; a full read of the file would cost more than it saves).
+    // Call it before the TTreeCache is set up so the cache does not learn only the id branches.
+    // Every entry is kept for MC or an empty good run list.
+    template <typename NtupleClass>
+    OwnedEntryCursor GetGoodLumiClusters
+    (
+        TTree& tree, 
+        NtupleClass& ntuple_class, 
+        const std::string& file_name, 
+        const GoodRunList& good_runs
+    );
+
+    // the ranges of the tree's clusters that have at least one entry not flagged as bad
+    std::vector<EntryRange> GetGoodClusterRanges(TTree& tree, const std::vector<bool>& bad_entries);
+
+} // namespace at
+
+#include "AnalysisTools/CMS2Tools/src/LumiPreFilter.impl.h"
+
+#endif // AT_LUMIPREFILTER_H
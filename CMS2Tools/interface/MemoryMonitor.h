@@ -0,0 +1,112 @@
+#ifndef AT_MEMORYMONITOR_H
+#define AT_MEMORYMONITOR_H
+
+// c++
+#include <string>
+#include <vector>
+#include <utility>
+#include <iosfwd>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+namespace at
+{
+    // resident memory of the process now and its peak in bytes
+    // (GetResidentMemory falls back to the peak without /proc)
+    long long GetResidentMemory();
+    long long GetPeakResidentMemory();
+
+    // what the memory of a ScanChain job is spent on
+    struct MemoryComponent
+    {
+        enum value_type
+        {
+            TREE_CACHE, // the TTreeCaches of the open files (get_tree_cache_in_use)
+            DUPLICATES, // the at::is_duplicate filter (get_duplicate_filter_memory_usage)
+            ANALYZER,   // what the analyzers report with MemoryUsage() (e.g. TH1Container::MemoryUsage)
+            OTHER,      // the rest of the resident memory (ROOT, the ntuple, the libraries, ...)
+            static_size
+        };
+    };
+
+    // does the analyzer have a "size_t MemoryUsage() const" hook?
+    template <typename Analyzer>
+    struct HasMemoryUsageHook;
+
+    // the analyzer's MemoryUsage() (0 if it doesn't have the hook)
+    template <typename Analyzer>
+    size_t GetAnalyzerMemoryUsage(const Analyzer& analyzer);
+
+    // Samples the resident memory of a ScanChain job and splits it into the MemoryComponents.
+    // Above the soft limit it warns and halves the TTreeCache budget (the files opened from then
+    // on get smaller caches); the caller shrinks the cache of the file it has open (ShrinkTreeCache).
+    // The budget is put back when the monitor (i.e. the job) is done.
+    class MemoryMonitor
+    {
+        public:
+
+            // num_slots: number of analyzers (one per worker)
+            // interval: seconds between samples
+            // soft_limit: resident bytes above which it warns and shrinks (<= 0 --> no limit)
+            MemoryMonitor(const size_t num_slots, const double interval, const long long soft_limit);
+
+            // puts back the TTreeCache budget 
+            ~MemoryMonitor();
+
+            // is a sample due? (thread safe; reads the clock so call it every so many events)
+            bool Due() const;
+
+            // the memory the analyzer of the slot reported last (thread safe)
+            void SetAnalyzerMemory(const size_t slot, const size_t bytes);
+
+            // take a sample (thread safe)
+            // returns true if the resident memory has just gone over the soft limit
+            bool Sample();
+
+            // the sample with the highest resident memory
+            long NumSamples() const;
+            long long PeakResident() const;
+            long long PeakComponent(const MemoryComponent::value_type component) const;
+
+            // number of times the soft limit was crossed
+            unsigned int NumShrinks() const;
+
+            // print a summary table
+            void Print(std::ostream& out) const;
+
+            // the values for the machine readable report (see WriteScanReport)
+            void AppendReportValues(std::vector<std::pair<std::string, double> >& values) const;
+
+        private:
+
+            // not copyable
+            MemoryMonitor(const MemoryMonitor&);
+            MemoryMonitor& operator=(const MemoryMonitor&);
+
+            long long m_interval;
+            long long m_soft_limit;
+            long long m_tree_cache_budget; // when the job started
+            std::atomic<long long> m_next_time;
+            std::vector<size_t> m_analyzer_bytes;
+            long m_num_samples;
+            unsigned int m_num_shrinks;
+            bool m_over_limit;
+            long long m_peak[MemoryComponent::static_size];
+            long long m_max[MemoryComponent::static_size];
+            long long m_peak_resident;
+            mutable std::mutex m_mutex;
+    };
+
+    // memory sampling of the ScanChain functions
+    // interval: seconds between samples (default is 60)
+    // soft_limit: resident bytes above which the job warns and shrinks its TTreeCaches (default is 0: no limit)
+    void set_memory_monitor(const double interval, const long long soft_limit = 0);
+    double get_memory_monitor_interval();
+    long long get_memory_soft_limit();
+
+} // namespace at
+
+#include "AnalysisTools/CMS2Tools/src/MemoryMonitor.impl.h"
+
+#endif // AT_MEMORYMONITOR_H
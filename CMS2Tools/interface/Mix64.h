@@ -0,0 +1,23 @@
+#ifndef AT_MIX64_H
+#define AT_MIX64_H
+
+// c++
+#include <stdint.h>
+
+namespace at
+{
+    namespace detail
+    {
+        // the splitmix64 finalizer (hash of a 64 bit key; used by the duplicate filters and the run/lumi partition)
+        inline uint64_t Mix64(uint64_t key)
+        {
+            key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+            key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+            return key ^ (key >> 31);
+        }
+
+    } // namespace detail
+
+} // namespace at
+
+#endif // AT_MIX64_H
@@ -0,0 +1,86 @@
+#ifndef AT_PROGRESSREPORTER_H
+#define AT_PROGRESSREPORTER_H
+
+// c++
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace at
+{
+    // how the ScanChain functions report their progress
+    struct ProgressMode
+    {
+        enum value_type
+        {
+            AUTO,     // TERMINAL if stdout is a terminal, otherwise LOG
+            TERMINAL, // one line rewritten in place
+            LOG,      // one "key=value" line per report for batch logs
+            NONE,     // no progress report
+            static_size
+        };
+    };
+
+    // Reports the progress of an event loop from a background thread.
+    // The loop only stores its event count in an atomic counter; every interval the
+    // thread reads it and prints the fraction done, the events/s, the MB/s read
+    // (TFile::GetFileBytesRead) and the estimated time left.
+    class ProgressReporter
+    {
+        public:
+
+            // num_events: the counter the event loop updates (must outlive the reporter)
+            // num_events_chain: the number of events the loop will process
+            // name: printed in the LOG lines (e.g. "at::ScanChain")
+            // interval: seconds between reports (<= 0 --> 1 s for TERMINAL, 60 s for LOG)
+            ProgressReporter
+            (
+                const std::atomic<long>& num_events,
+                const long num_events_chain,
+                const std::string& name,
+                const ProgressMode::value_type mode,
+                const double interval
+            );
+
+            // stops the thread
+            ~ProgressReporter();
+
+            // print the last report and stop the thread
+            void Stop();
+
+            // the mode after AUTO is resolved
+            ProgressMode::value_type Mode() const {return m_mode;}
+
+        private:
+
+            // not copyable
+            ProgressReporter(const ProgressReporter&);
+            ProgressReporter& operator=(const ProgressReporter&);
+
+            void Run();
+            void Report();
+
+            const std::atomic<long>& m_num_events;
+            long m_num_events_chain;
+            std::string m_name;
+            ProgressMode::value_type m_mode;
+            std::chrono::duration<double> m_interval;
+            std::chrono::steady_clock::time_point m_start;
+            long long m_start_bytes;
+            bool m_stop;
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::thread m_thread;
+    };
+
+    // the progress report of the ScanChain functions (default: AUTO, interval <= 0 --> the mode's default)
+    void set_scan_progress(const ProgressMode::value_type mode, const double interval = -1.0);
+    ProgressMode::value_type get_scan_progress_mode();
+    double get_scan_progress_interval();
+
+} // namespace at
+
+#endif // AT_PROGRESSREPORTER_H
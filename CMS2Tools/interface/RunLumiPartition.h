@@ -0,0 +1,51 @@
+#ifndef AT_RUNLUMIPARTITION_H
+#define AT_RUNLUMIPARTITION_H
+
+// c++
+#include <string>
+
+namespace at
+{
+    // Splits a data pass into shards (e.g. batch jobs) so that every (run, lumi) is owned
+    // by exactly one shard.  Duplicate events share the (run, lumi) so each shard's 
+    // at::is_duplicate sees all the copies of the events it owns.
+    struct RunLumiPartition
+    {
+        struct Scheme
+        {
+            enum value_type
+            {
+                NONE, // 0: one shard owns everything
+                RUN,  // 1: whole runs are owned by a shard (run % num_shards)
+                LUMI, // 2: lumi sections are spread over the shards (hash of run and lumi)
+                static_size
+            };
+        };
+
+        // default is no partitioning
+        RunLumiPartition();
+
+        // throws if shard >= num_shards
+        RunLumiPartition(const Scheme::value_type scheme, const unsigned int shard, const unsigned int num_shards);
+
+        // does this shard own the (run, lumi)?
+        bool Owns(const unsigned int run, const unsigned int lumi) const;
+
+        // "none", "run:<shard>/<num_shards>" or "lumi:<shard>/<num_shards>"
+        std::string ToString() const;
+
+        Scheme::value_type scheme;
+        unsigned int shard;
+        unsigned int num_shards;
+    };
+
+    // parse "none", "run:<shard>/<num_shards>" or "lumi:<shard>/<num_shards>" (throws if invalid)
+    RunLumiPartition ParseRunLumiPartition(const std::string& str);
+
+    // the partition used by the ScanChain functions (default is none)
+    void set_run_lumi_partition(const RunLumiPartition& partition);
+    const RunLumiPartition& get_run_lumi_partition();
+
+} // namespace at
+
+#endif // AT_RUNLUMIPARTITION_H
@@ -4,6 +4,9 @@
 // C++
 #include <string>
 
+// tools
+#include "AnalysisTools/CMS2Tools/interface/EntryRangeScheduler.h"
+
 // ROOT
 class TChain;
 
@@ -13,6 +16,9 @@ namespace at
     int ScanChainTestAnalysis(long event);
 
     // Peform an analysis on a chain.
+    // Reads each entry (with the goodrun list and duplicate checks for data) and calls 
+    // analyzer.Analyze(entry) for the ones that pass; BeginJob and EndJob wrap the loop.
+    // The optional features are set up with the set_* functions of their own headers.
     template <typename NtupleClass, typename Analyzer>
     int ScanChain
     (
@@ -45,6 +51,53 @@ namespace at
         const int evt_event = -1
      );
 
+    // Peform an analysis on a chain using a pool of worker threads.
+    // The chain is split into ranges of entries which a work stealing scheduler hands 
+    // out to the workers (see EntryRangeScheduler.h).  split_mode FILE makes one range 
+    // per file; CLUSTER splits each tree on its basket cluster boundaries so that one 
+    // large file can keep all the workers busy without any basket being read twice.
+    // Each worker owns its own NtupleClass and a copy of the analyzer that is 
+    // copy constructed after analyzer.BeginJob() (the first worker uses the analyzer
+    // and ntuple_class passed in).  When the workers are done, the copies are combined 
+    // with analyzer.Merge(const Analyzer&) before analyzer.EndJob() is called, or all at once with 
+    // analyzer.Merge(const std::vector<const Analyzer*>&) if it has that (e.g. to merge the 
+    // TH1Container replicas of the copies in parallel with TH1Container::Merge).
+    // NOTE: the analyzer must read the event through the NtupleClass of its worker 
+    //       and not through global ntuple objects (e.g. the global cms2). 
+    // num_threads == 0 --> one thread per core.
+    template <typename NtupleClass, typename Analyzer>
+    int ScanChainParallel
+    (
+        TChain* const chain, 
+        Analyzer& analyze, 
+        NtupleClass& ntuple_class,
+        const unsigned int num_threads = 0,
+        const ScanSplitMode::value_type split_mode = ScanSplitMode::FILE,
+        const long num_events = -1, 
+        const std::string& goodrun_file_name = "",
+        const bool fast = true,
+        const bool verbose = false,
+        const int evt_run = -1,
+        const int evt_lumi = -1,
+        const int evt_event = -1
+     );
+
+    // Run the pre-scan of the TWO_TIER duplicate filter (see DorkyEventIdentifier.h) over the 
+    // data entries the event loop can read (the first num_events, owned and selected). 
+    // The ScanChain functions call this when that mode is set.
+    template <typename NtupleClass>
+    void PreScanDuplicates
+    (
+        TChain* const chain, 
+        NtupleClass& ntuple_class,
+        const bool use_goodrun,
+        const bool verbose = false,
+        const long num_events = -1,
+        const int evt_run = -1,
+        const int evt_lumi = -1,
+        const int evt_event = -1
+    );
+
 } // namespace at
 
 #include "AnalysisTools/CMS2Tools/src/ScanChain.impl.h"
@@ -0,0 +1,111 @@
+#ifndef AT_SCANCHECKPOINT_H
+#define AT_SCANCHECKPOINT_H
+
+// c++
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+namespace at
+{
+    class BadFileReport;
+
+    // where a ScanChain job is and what it has counted so far
+    struct ScanCheckpoint
+    {
+        size_t file_index;          // index of the file in the chain
+        long long entry;            // next entry of the file to process
+        long num_events_total;
+        unsigned long bad_events;
+        unsigned long duplicates;
+        unsigned long not_owned;
+    };
+
+    // does the analyzer have the Checkpoint(const std::string&) and Restore(const std::string&) hooks?
+    template <typename Analyzer>
+    struct HasCheckpointHooks;
+
+    // Periodic checkpoints of a ScanChain job so that it can resume after it died.
+    // A checkpoint is the text file (the position and the counts) and the state files it names:
+    // the ids seen by at::is_duplicate, the files skipped so far (BadFileReport) and whatever 
+    // analyzer.Checkpoint(file_name) writes (e.g. its histograms), which analyzer.Restore(file_name) 
+    // reads back after BeginJob.
+    // The state files of each checkpoint get a new number and the text file is replaced
+    // with a rename so that a job that dies while writing keeps the previous checkpoint.
+    class ScanCheckpointer
+    {
+        public:
+
+            // file_name: the checkpoint text file (empty --> no checkpoints)
+            // interval: seconds between checkpoints
+            ScanCheckpointer(const std::string& file_name, const double interval);
+
+            bool Enabled() const {return !m_file_name.empty();}
+
+            // start a job over these files: reads the checkpoint if there is one and returns true
+            // (throws std::runtime_error if the checkpoint was made for another chain)
+            bool Begin(const std::vector<std::string>& file_names);
+
+            // the checkpoint read by Begin
+            const ScanCheckpoint& Last() const {return m_last;}
+
+            // is it time for a checkpoint? (looks at the clock every 1024 calls)
+            bool Due()
+            {
+                if (m_file_name.empty() || (++m_num_calls & 0x3ff) != 0)
+                {
+                    return false;
+                }
+                return std::chrono::steady_clock::now() >= m_next_time;
+            }
+
+            // write a checkpoint of the position, at::is_duplicate, the skipped files and the analyzer
+            template <typename Analyzer>
+            void Save(const ScanCheckpoint& position, Analyzer& analyzer, const BadFileReport& bad_files);
+
+            // read the state of the checkpoint read by Begin into at::is_duplicate, the skipped files and the analyzer
+            template <typename Analyzer>
+            void Restore(Analyzer& analyzer, BadFileReport& bad_files) const;
+
+            // the job is done: remove the checkpoint files
+            void Remove();
+
+            // number of checkpoints written
+            unsigned int NumSaved() const {return m_num_saved;}
+
+        private:
+
+            // names of the state files of checkpoint number generation
+            std::string AnalyzerFileName(const unsigned int generation) const;
+            std::string DuplicatesFileName(const unsigned int generation) const;
+            std::string BadFilesFileName(const unsigned int generation) const;
+
+            // write the duplicate state, the skipped files and the text file, remove the previous state files
+            void SaveDuplicates(const unsigned int generation) const;
+            void SaveBadFiles(const unsigned int generation, const BadFileReport& bad_files) const;
+            void Commit(const ScanCheckpoint& position, const unsigned int generation);
+            void RestoreDuplicates() const;
+            void RestoreBadFiles(BadFileReport& bad_files) const;
+
+            std::string m_file_name;
+            std::chrono::steady_clock::duration m_interval;
+            std::chrono::steady_clock::time_point m_next_time;
+            unsigned long m_num_calls;
+            unsigned int m_num_saved;
+            unsigned int m_generation;
+            std::vector<std::string> m_file_names;
+            ScanCheckpoint m_last;
+    };
+
+    // checkpoints of the serial ScanChain functions (empty file name --> none; the default)
+    // the analyzer needs the Checkpoint/Restore hooks; interval in seconds
+    void set_scan_checkpoint(const std::string& file_name, const double interval = 600.0);
+    const std::string& get_scan_checkpoint_file();
+    double get_scan_checkpoint_interval();
+
+} // namespace at
+
+#include "AnalysisTools/CMS2Tools/src/ScanCheckpoint.impl.h"
+
+#endif // AT_SCANCHECKPOINT_H
@@ -0,0 +1,135 @@
+#ifndef AT_SCANSTAGETIMER_H
+#define AT_SCANSTAGETIMER_H
+
+// c++
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <iosfwd>
+#include <cstddef>
+
+namespace at
+{
+    // stages of the ScanChain event loop that are timed
+    struct ScanStage
+    {
+        enum value_type
+        {
+            FILE_OPEN,  // waiting for the next file, Init and the cache set up
+            READ_ID,    // LoadTree and loading the event id (LoadEventId)
+            FILTER,     // partition, run/lumi/event selection, good run and duplicate checks
+            GET_ENTRY,  // loading the rest of the entry
+            ANALYZE,    // Analyzer::Analyze
+            FILE_CLOSE, // closing the file
+            static_size
+        };
+    };
+
+    // name of the stage (e.g. "get_entry")
+    const char* GetScanStageName(const ScanStage::value_type stage);
+
+    // Time spent in each stage of a scan.
+    // The loop calls Enter(stage) at each stage boundary; the time since the previous call is 
+    // added to the previous stage (one clock read per boundary).  One timer per thread,
+    // they are combined with Merge at the end.  Uses std::chrono::steady_clock.
+    class ScanStageTimer
+    {
+        public:
+
+            typedef std::chrono::steady_clock clock_type;
+
+            // histograms: fill a latency histogram of each stage (log2 bins in ns)
+            explicit ScanStageTimer(const bool histograms = false);
+
+            // start the stage (ends the current one)
+            void Enter(const ScanStage::value_type stage)
+            {
+                const clock_type::time_point now = clock_type::now();
+                if (m_current != ScanStage::static_size)
+                {
+                    Add(m_current, now - m_mark);
+                }
+                m_current = stage;
+                m_mark    = now;
+            }
+
+            // end the current stage
+            void Stop();
+
+            // add the times of another timer
+            void Merge(const ScanStageTimer& other);
+
+            // total time (s) and number of times the stage was entered
+            double Seconds(const ScanStage::value_type stage) const;
+            unsigned long Count(const ScanStage::value_type stage) const;
+            double TotalSeconds() const;
+
+            // latency histogram of the stage: bin i counts the durations in [2^i, 2^(i+1)) ns
+            // (empty if the histograms are off)
+            std::vector<unsigned long> Histogram(const ScanStage::value_type stage) const;
+            static const size_t num_histogram_bins = 40;
+
+            // table of the stages
+            void Print(std::ostream& out) const;
+
+            // JSON object of the stages
+            void WriteJson(std::ostream& out) const;
+
+        private:
+
+            void Add(const ScanStage::value_type stage, const clock_type::duration& duration);
+
+            bool m_histograms;
+            ScanStage::value_type m_current;
+            clock_type::time_point m_mark;
+            std::vector<clock_type::duration> m_durations;
+            std::vector<unsigned long> m_counts;
+            std::vector<unsigned long> m_histogram_bins;
+    };
+
+    // The timer of a loop whose stages are not timed (no scan report, see set_scan_report_file):
+    // the same interface as ScanStageTimer without reading the clock.
+    class NoStageTimer
+    {
+        public:
+
+            explicit NoStageTimer(const bool /*histograms*/ = false) {}
+            void Enter(const ScanStage::value_type /*stage*/) {}
+            void Stop() {}
+
+            // one line saying the stages were not timed
+            void Print(std::ostream& out) const;
+    };
+
+    // Write the machine readable report of a scan as JSON:
+    // {"function": ..., <values>, "stages": {...}}
+    void WriteScanReport
+    (
+        const std::string& file_name, 
+        const std::string& function_name,
+        const std::vector<std::pair<std::string, double> >& values,
+        const ScanStageTimer& timer
+    );
+
+    // same as above without the stages
+    void WriteScanReport
+    (
+        const std::string& file_name, 
+        const std::string& function_name,
+        const std::vector<std::pair<std::string, double> >& values,
+        const NoStageTimer& timer
+    );
+
+    // the report written by the ScanChain functions at the end of a job (empty --> none)
+    // the serial ScanChain only times its stages when there is a report
+    void set_scan_report_file(const std::string& file_name);
+    const std::string& get_scan_report_file();
+
+    // fill the latency histograms of the ScanChain functions' timers (off by default)
+    void set_scan_timing_histograms(const bool histograms);
+    bool get_scan_timing_histograms();
+
+} // namespace at
+
+#endif // AT_SCANSTAGETIMER_H
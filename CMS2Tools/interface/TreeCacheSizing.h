@@ -0,0 +1,98 @@
+#ifndef AT_TREECACHESIZING_H
+#define AT_TREECACHESIZING_H
+
+// c++
+#include <string>
+#include <vector>
+#include <utility>
+#include <iosfwd>
+
+// ROOT
+class TFile;
+class TTree;
+
+namespace at
+{
+    // compressed bytes per entry (what the TTreeCache holds) of the branches that will be read:
+    // the named branches or, if there are none, every enabled top level branch
+    double GetBytesPerEntry(TTree& tree, const std::vector<std::string>& branch_names);
+
+    // number of entries in a cluster of the tree (the whole tree if it was not written in clusters)
+    long long GetClusterEntries(TTree& tree);
+
+    // The TTreeCache size the tree wants: the baskets of get_tree_cache_clusters() clusters of the
+    // branches that will be read (see GetBytesPerEntry), but at least 1 MB.
+    long long GetTreeCacheSize(TTree& tree, const std::vector<std::string>& branch_names);
+
+    // Set up the TTreeCache of the tree with the size from GetTreeCacheSize, taken from the memory
+    // budget shared by all the open files (a file gets at most half of what is left, so the files
+    // opened ahead still get some, or one cluster if that fits in what is left; never less than 1 MB).
+    // Returns the bytes taken from the budget; give them back with ReleaseTreeCache when the file is closed.
+    long long SetTreeCache(TTree& tree, const std::vector<std::string>& branch_names);
+    void ReleaseTreeCache(const long long cache_size);
+
+    // Halve the TTreeCache of an open tree (not below 1 MB) and give the bytes back to the budget
+    // (e.g. when the job is over its memory soft limit, see MemoryMonitor.h).
+    // cache_size: what SetTreeCache returned for it; returns the new size.
+    long long ShrinkTreeCache(TTree& tree, const long long cache_size);
+
+    // I/O statistics of the files read by a job (collected before each file is closed)
+    class TreeCacheStats
+    {
+        public:
+
+            TreeCacheStats();
+
+            // add a file about to be closed (cache_size: what SetTreeCache returned for it)
+            void Add(TFile& file, TTree& tree, const long long cache_size);
+
+            // add the files of another job (e.g. another worker)
+            void Merge(const TreeCacheStats& other);
+
+            // totals
+            long NumFiles() const {return m_num_files;}
+            long long ReadCalls() const {return m_read_calls;}
+            long long BytesRead() const {return m_bytes_read;}
+            long long MaxCacheSize() const {return m_max_cache_size;}
+
+            // mean cache size and mean TTreeCache efficiency (fraction of the baskets read through the cache)
+            // of the files with a cache (0 if there are none)
+            double MeanCacheSize() const;
+            double MeanEfficiency() const;
+
+            // print a summary table
+            void Print(std::ostream& out) const;
+
+            // the values for the machine readable report (see WriteScanReport)
+            void AppendReportValues(std::vector<std::pair<std::string, double> >& values) const;
+
+        private:
+
+            long m_num_files;
+            long m_num_cached_files;
+            long long m_read_calls;
+            long long m_bytes_read;
+            long long m_max_cache_size;
+            double m_sum_cache_size;
+            double m_sum_efficiency;
+    };
+
+    // the memory shared by the TTreeCaches of the open files (default is 512 MB)
+    void set_tree_cache_budget(const long long bytes);
+    long long get_tree_cache_budget();
+
+    // the bytes the open files hold now
+    long long get_tree_cache_in_use();
+
+    // the number of clusters a TTreeCache holds (default is 1)
+    void set_tree_cache_clusters(const int clusters);
+    int get_tree_cache_clusters();
+
+    // the number of entries the TTreeCache learns the branches from when there is no
+    // branch list to give it (default is 10)
+    void set_tree_cache_learn_entries(const int entries);
+    int get_tree_cache_learn_entries();
+
+} // namespace at
+
+#endif // AT_TREECACHESIZING_H
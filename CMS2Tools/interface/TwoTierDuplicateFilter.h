@@ -0,0 +1,113 @@
+#ifndef AT_TWOTIERDUPLICATEFILTER_H
+#define AT_TWOTIERDUPLICATEFILTER_H
+
+// c++
+#include <iosfwd>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <utility>
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/BloomFilter.h"
+#include "AnalysisTools/CMS2Tools/interface/DuplicateEventFilter.h"
+
+namespace at
+{
+    struct DorkyEventIdentifier;
+
+    // Two tier duplicate removal for very large data passes.
+    // PreScan: every id is put through a Bloom filter (from one thread).  The ids that the 
+    //   filter flags as possibly seen are kept as candidates.  Every id that occurs more than 
+    //   once ends up a candidate since a Bloom filter has no false negatives.
+    // IsDuplicate: an id that is not a candidate only occurs once.  Only the candidates go 
+    //   into the exact set so the answer is the same as the DuplicateEventFilter's.
+    // The pre-scan must see every id that IsDuplicate is asked about.
+    // Successive pre-scans (one per ScanChain call) extend the filter.  An id that a later 
+    //   pre-scan flags for the first time may have been passed by the second pass already 
+    //   (it was not a candidate then) so the earlier pre-scans are reread for those (Recheck).
+    class TwoTierDuplicateFilter
+    {
+        public:
+
+            TwoTierDuplicateFilter(const size_t expected_size, const double false_positive_rate = 0.01);
+
+            // what a pre-scan read: the first entries of each file with the run/lumi/event selection
+            struct PreScanPass
+            {
+                std::string tree_name;
+                std::vector<std::pair<std::string, long> > files; // (file name, # of entries)
+                int evt_run;
+                int evt_lumi;
+                int evt_event;
+            };
+
+            // start a pre-scan; returns true if it extends the filter of earlier pre-scans 
+            bool BeginPreScan();
+
+            // first pass: put the id through the Bloom filter (not thread safe)
+            void PreScan(const DorkyEventIdentifier& id);
+
+            // number of ids flagged for the first time by a pre-scan that extends the filter
+            size_t NumToRecheck() const;
+
+            // an id reread from an earlier pre-scan: if the current pre-scan flagged it for 
+            // the first time the second pass has seen it before (not thread safe)
+            void Recheck(const DorkyEventIdentifier& id);
+
+            // finish the pre-scan (it is reread if a later one needs a recheck)
+            void EndPreScan(const PreScanPass& pass);
+
+            // the finished pre-scans
+            const std::vector<PreScanPass>& GetPreScanPasses() const;
+
+            // second pass: returns true if the id has been seen before (thread safe)
+            bool IsDuplicate(const DorkyEventIdentifier& id);
+
+            // number of ids pre-scanned
+            size_t NumPreScanned() const;
+
+            // number of pre-scanned ids flagged as possibly seen 
+            size_t NumFlagged() const;
+
+            // number of distinct candidates 
+            size_t NumCandidates() const;
+
+            // false positive rate expected from the fill of the Bloom filter
+            double EstimatedFalsePositiveRate() const;
+
+            // false positive rate measured from the number of duplicates the second pass found:
+            // (flagged - duplicates) / (pre-scanned - duplicates) 
+            // (only meaningful if the second pass saw all the pre-scanned ids)
+            double MeasuredFalsePositiveRate(const size_t num_duplicates) const;
+
+            // memory used by the Bloom filter and the exact sets in bytes
+            size_t MemoryUsage() const;
+
+            // print a summary 
+            void Print(std::ostream& out, const size_t num_duplicates) const;
+
+            // write/read the state of the second pass (the ids seen so far; the candidates 
+            // come from rerunning the pre-scan)
+            void SaveSecondPass(std::ostream& out) const;
+            void LoadSecondPass(std::istream& in);
+
+        private:
+
+            // non-copyable
+            TwoTierDuplicateFilter(const TwoTierDuplicateFilter&);
+            TwoTierDuplicateFilter& operator=(const TwoTierDuplicateFilter&);
+
+            BloomFilter m_bloom;
+            DuplicateEventFilter m_candidates;
+            DuplicateEventFilter m_exact;
+            DuplicateEventFilter m_recheck;
+            std::vector<PreScanPass> m_passes;
+            bool m_extending;
+            std::atomic<size_t> m_num_prescanned;
+            std::atomic<size_t> m_num_flagged;
+    };
+
+} // namespace at
+
+#endif // AT_TWOTIERDUPLICATEFILTER_H
@@ -0,0 +1,116 @@
+#include "AnalysisTools/CMS2Tools/interface/BloomFilter.h"
+
+// c++
+#include <cmath>
+#include <stdexcept>
+
+namespace at
+{
+    namespace
+    {
+        // remix the hash to get the second hash for double hashing
+        inline uint64_t remix(uint64_t key)
+        {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdull;
+            key ^= key >> 33;
+            return key | 1;
+        }
+
+        inline unsigned int popcount(const uint64_t word)
+        {
+            return __builtin_popcountll(word);
+        }
+
+    } // anonymous namespace
+
+    // sized for expected_size keys at the given false positive rate
+    BloomFilter::BloomFilter(const size_t expected_size, const double false_positive_rate)
+        : m_words()
+        , m_num_bits(0)
+        , m_num_hashes(0)
+        , m_num_inserted(0)
+    {
+        if (false_positive_rate <= 0.0 || false_positive_rate >= 1.0)
+        {
+            throw std::invalid_argument("[at::BloomFilter] Error: false positive rate must be in (0, 1)");
+        }
+
+        // m = -n ln(p) / ln(2)^2, k = m/n ln(2)
+        const double ln2 = std::log(2.0);
+        const double n   = (expected_size > 0 ? static_cast<double>(expected_size) : 1.0);
+        const double m   = std::ceil(-n * std::log(false_positive_rate) / (ln2 * ln2));
+        const size_t num_words = static_cast<size_t>(m / 64.0) + 1;
+        m_num_bits   = 64 * num_words;
+        m_num_hashes = static_cast<unsigned int>(std::floor(m_num_bits / n * ln2 + 0.5));
+        if (m_num_hashes < 1 ) {m_num_hashes = 1; }
+        if (m_num_hashes > 16) {m_num_hashes = 16;}
+        std::vector<std::atomic<uint64_t> >(num_words).swap(m_words);
+        for (size_t i = 0; i != m_words.size(); ++i) {m_words[i].store(0, std::memory_order_relaxed);}
+    }
+
+    // set the bits for the hash and return true if they were all set already (possibly seen)
+    bool BloomFilter::Insert(const uint64_t hash)
+    {
+        const uint64_t step = remix(hash);
+        uint64_t position   = hash;
+        bool all_set        = true;
+        for (unsigned int i = 0; i != m_num_hashes; ++i, position += step)
+        {
+            const size_t bit     = static_cast<size_t>(position % m_num_bits);
+            const uint64_t mask  = static_cast<uint64_t>(1) << (bit & 63);
+            const uint64_t old   = m_words[bit >> 6].fetch_or(mask, std::memory_order_relaxed);
+            all_set &= ((old & mask) != 0);
+        }
+        if (not all_set) {++m_num_inserted;}
+        return all_set;
+    }
+
+    // are all the bits for the hash set? 
+    bool BloomFilter::Contains(const uint64_t hash) const
+    {
+        const uint64_t step = remix(hash);
+        uint64_t position   = hash;
+        for (unsigned int i = 0; i != m_num_hashes; ++i, position += step)
+        {
+            const size_t bit    = static_cast<size_t>(position % m_num_bits);
+            const uint64_t mask = static_cast<uint64_t>(1) << (bit & 63);
+            if ((m_words[bit >> 6].load(std::memory_order_relaxed) & mask) == 0) {return false;}
+        }
+        return true;
+    }
+
+    // number of keys inserted
+    size_t BloomFilter::NumInserted() const
+    {
+        return m_num_inserted;
+    }
+
+    // false positive rate expected from the current fill of the bits (fraction set ^ k)
+    double BloomFilter::EstimatedFalsePositiveRate() const
+    {
+        size_t num_set = 0;
+        for (size_t i = 0; i != m_words.size(); ++i)
+        {
+            num_set += popcount(m_words[i].load(std::memory_order_relaxed));
+        }
+        return std::pow(static_cast<double>(num_set) / m_num_bits, static_cast<double>(m_num_hashes));
+    }
+
+    size_t BloomFilter::NumBits() const
+    {
+        return m_num_bits;
+    }
+
+    unsigned int BloomFilter::NumHashes() const
+    {
+        return m_num_hashes;
+    }
+
+    // memory used in bytes
+    size_t BloomFilter::MemoryUsage() const
+    {
+        return sizeof(BloomFilter) + m_words.size() * sizeof(uint64_t);
+    }
+
+} // namespace at
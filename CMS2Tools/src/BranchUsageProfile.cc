@@ -0,0 +1,223 @@
+#include "AnalysisTools/CMS2Tools/interface/BranchUsageProfile.h"
+
+// c++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// ROOT
+#include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+
+namespace at
+{
+    // was the branch (or one of its sub-branches) read?
+    static bool WasRead(TBranch& branch)
+    {
+        if (branch.GetReadEntry() >= 0)
+        {
+            return true;
+        }
+        TObjArray* const sub_branches = branch.GetListOfBranches();
+        for (int i = 0; sub_branches && i < sub_branches->GetEntries(); ++i)
+        {
+            TBranch* const sub_branch = dynamic_cast<TBranch*>(sub_branches->At(i));
+            if (sub_branch && WasRead(*sub_branch))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    BranchUsageProfile::BranchUsageProfile()
+        : m_branch_names()
+        , m_missed_branch_names()
+    {
+    }
+
+    BranchUsageProfile::BranchUsageProfile(const std::string& file_name)
+        : m_branch_names()
+        , m_missed_branch_names()
+    {
+        Read(file_name);
+    }
+
+    void BranchUsageProfile::Read(const std::string& file_name)
+    {
+        std::ifstream in(file_name.c_str());
+        if (!in)
+        {
+            throw std::runtime_error("[at::BranchUsageProfile::Read] Error: unable to open " + file_name);
+        }
+        m_branch_names.clear();
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream line_stream(line);
+            std::string branch_name;
+            if (!(line_stream >> branch_name) || branch_name[0] == '#')
+            {
+                continue;
+            }
+            m_branch_names.insert(branch_name);
+        }
+    }
+
+    void BranchUsageProfile::Write(const std::string& file_name) const
+    {
+        std::ofstream out(file_name.c_str());
+        if (!out)
+        {
+            throw std::runtime_error("[at::BranchUsageProfile::Write] Error: unable to open " + file_name);
+        }
+        out << "# branches read by the analysis (delete this file to relearn)" << std::endl;
+        for (std::set<std::string>::const_iterator iter = m_branch_names.begin(); iter != m_branch_names.end(); ++iter)
+        {
+            out << *iter << std::endl;
+        }
+    }
+
+    void BranchUsageProfile::Learn(TTree& tree)
+    {
+        TObjArray* const branches = tree.GetListOfBranches();
+        for (int i = 0; branches && i < branches->GetEntries(); ++i)
+        {
+            TBranch* const branch = dynamic_cast<TBranch*>(branches->At(i));
+            if (!branch || not WasRead(*branch))
+            {
+                continue;
+            }
+            if (tree.GetBranchStatus(branch->GetName()))
+            {
+                m_branch_names.insert(branch->GetName());
+            }
+            else
+            {
+                m_missed_branch_names.insert(branch->GetName());
+            }
+        }
+    }
+
+    void BranchUsageProfile::Verify(TTree& tree)
+    {
+        Learn(tree);
+        if (m_missed_branch_names.empty())
+        {
+            return;
+        }
+        std::ostringstream msg;
+        msg << "[at::BranchUsageProfile::Verify] Error: branches read after they were pruned (their values were not loaded;"
+            << " delete the profile to relearn it, or learn from more entries):";
+        for (std::set<std::string>::const_iterator iter = m_missed_branch_names.begin(); iter != m_missed_branch_names.end(); ++iter)
+        {
+            msg << " " << *iter;
+        }
+        throw std::runtime_error(msg.str());
+    }
+
+    void BranchUsageProfile::Prune(TTree& tree) const
+    {
+        // the sub-branches of split branches go with their parent
+        tree.SetBranchStatus("*", 0);
+        for (std::set<std::string>::const_iterator iter = m_branch_names.begin(); iter != m_branch_names.end(); ++iter)
+        {
+            tree.SetBranchStatus(iter->c_str(), 1);
+            tree.SetBranchStatus((*iter + ".*").c_str(), 1);
+        }
+
+        // only cache these (no learning phase)
+        if (tree.GetCacheSize() > 0)
+        {
+            for (std::set<std::string>::const_iterator iter = m_branch_names.begin(); iter != m_branch_names.end(); ++iter)
+            {
+                tree.AddBranchToCache(iter->c_str(), /*subbranches=*/true);
+            }
+            tree.StopCacheLearningPhase();
+        }
+    }
+
+    void BranchUsageProfile::Merge(const BranchUsageProfile& other)
+    {
+        m_branch_names.insert(other.m_branch_names.begin(), other.m_branch_names.end());
+        m_missed_branch_names.insert(other.m_missed_branch_names.begin(), other.m_missed_branch_names.end());
+    }
+
+    const std::set<std::string>& BranchUsageProfile::GetBranchNames() const
+    {
+        return m_branch_names;
+    }
+
+    std::vector<std::string> BranchUsageProfile::GetBranchNameList() const
+    {
+        return std::vector<std::string>(m_branch_names.begin(), m_branch_names.end());
+    }
+
+    size_t BranchUsageProfile::Size() const
+    {
+        return m_branch_names.size();
+    }
+
+    bool BranchUsageProfile::Empty() const
+    {
+        return m_branch_names.empty();
+    }
+
+    const std::set<std::string>& BranchUsageProfile::GetMissedBranchNames() const
+    {
+        return m_missed_branch_names;
+    }
+
+    void BranchUsageProfile::Print(std::ostream& out) const
+    {
+        out << "# of branches read       = " << m_branch_names.size() << std::endl;
+        if (!m_missed_branch_names.empty())
+        {
+            out << "Warning: " << m_missed_branch_names.size() << " branches were read but are not in the branch usage profile"
+                << " (their values are not loaded; delete the profile to relearn it):";
+            for (std::set<std::string>::const_iterator iter = m_missed_branch_names.begin(); iter != m_missed_branch_names.end(); ++iter)
+            {
+                out << " " << *iter;
+            }
+            out << std::endl;
+        }
+    }
+
+    // the profile used by the ScanChain functions
+    static std::string branch_usage_file_;
+    static long branch_usage_learn_entries_ = 0;
+
+    void set_branch_usage_profile(const std::string& file_name, const long learn_entries)
+    {
+        branch_usage_file_          = file_name;
+        branch_usage_learn_entries_ = learn_entries;
+    }
+
+    const std::string& get_branch_usage_file()
+    {
+        return branch_usage_file_;
+    }
+
+    long get_branch_usage_learn_entries()
+    {
+        return branch_usage_learn_entries_;
+    }
+
+    bool LoadBranchUsageProfile(BranchUsageProfile& profile)
+    {
+        if (branch_usage_file_.empty())
+        {
+            return false;
+        }
+        std::ifstream in(branch_usage_file_.c_str());
+        if (!in)
+        {
+            return false;
+        }
+        profile.Read(branch_usage_file_);
+        return true;
+    }
+
+} // namespace at
@@ -5,6 +5,8 @@ void Init(CMS2& cms2, TTree* tree)
     cms2.Init(tree);
 }
 
+// CMS2 loads a branch when it is first accessed so this only reads the event id branches
+// until the analyzer asks for more (no GetEventIdEntry: a second GetEntry would only reset them)
 void GetEntry(CMS2& cms2, long event)
 {
     cms2.GetEntry(event);
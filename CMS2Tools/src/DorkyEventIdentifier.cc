@@ -1,5 +1,8 @@
 #include "AnalysisTools/CMS2Tools/interface/DorkyEventIdentifier.h"
-#include <set>
+#include "AnalysisTools/CMS2Tools/interface/DuplicateEventFilter.h"
+#include "AnalysisTools/CMS2Tools/interface/TwoTierDuplicateFilter.h"
+#include <memory>
+#include <stdexcept>
 
 namespace at
 {
@@ -25,11 +28,91 @@ namespace at
         return true;
     }
 
-    static std::set<DorkyEventIdentifier> already_seen;
+    static DuplicateFilterMode::value_type duplicate_filter_mode_ = DuplicateFilterMode::EXACT;
+    static double false_positive_rate_ = 0.01;
+    static std::unique_ptr<TwoTierDuplicateFilter> two_tier_filter_;
+
+    // is_duplicate is shared by the ScanChainParallel workers
     bool is_duplicate (const DorkyEventIdentifier &id) 
     {
-        std::pair<std::set<DorkyEventIdentifier>::const_iterator, bool> ret = already_seen.insert(id);
-        return !ret.second;
+        if (duplicate_filter_mode_ == DuplicateFilterMode::TWO_TIER)
+        {
+            if (!two_tier_filter_)
+            {
+                throw std::logic_error("[at::is_duplicate] Error: the two tier duplicate filter needs a pre-scan (begin_duplicate_prescan)");
+            }
+            return two_tier_filter_->IsDuplicate(id);
+        }
+        return GetDuplicateEventFilter().Insert(id);
+    }
+
+    void set_duplicate_filter_mode(const DuplicateFilterMode::value_type mode, const double false_positive_rate)
+    {
+        duplicate_filter_mode_ = mode;
+        false_positive_rate_   = false_positive_rate;
+    }
+
+    DuplicateFilterMode::value_type get_duplicate_filter_mode()
+    {
+        return duplicate_filter_mode_;
+    }
+
+    // the filter is kept: ids seen by the earlier ScanChain calls are still duplicates
+    TwoTierDuplicateFilter& begin_duplicate_prescan(const size_t expected_size)
+    {
+        if (!two_tier_filter_)
+        {
+            two_tier_filter_.reset(new TwoTierDuplicateFilter(expected_size, false_positive_rate_));
+        }
+        return *two_tier_filter_;
+    }
+
+    void reset_duplicate_filter()
+    {
+        GetDuplicateEventFilter().Clear();
+        two_tier_filter_.reset();
+    }
+
+    TwoTierDuplicateFilter* get_two_tier_duplicate_filter()
+    {
+        return two_tier_filter_.get();
+    }
+
+    size_t get_duplicate_filter_memory_usage()
+    {
+        if (duplicate_filter_mode_ == DuplicateFilterMode::TWO_TIER)
+        {
+            return (two_tier_filter_ ? two_tier_filter_->MemoryUsage() : 0);
+        }
+        return GetDuplicateEventFilter().MemoryUsage();
+    }
+
+    void save_duplicate_state(std::ostream& out)
+    {
+        if (duplicate_filter_mode_ == DuplicateFilterMode::TWO_TIER)
+        {
+            if (!two_tier_filter_)
+            {
+                throw std::logic_error("[at::save_duplicate_state] Error: the two tier duplicate filter needs a pre-scan (begin_duplicate_prescan)");
+            }
+            two_tier_filter_->SaveSecondPass(out);
+            return;
+        }
+        GetDuplicateEventFilter().Save(out);
+    }
+
+    void load_duplicate_state(std::istream& in)
+    {
+        if (duplicate_filter_mode_ == DuplicateFilterMode::TWO_TIER)
+        {
+            if (!two_tier_filter_)
+            {
+                throw std::logic_error("[at::load_duplicate_state] Error: the two tier duplicate filter needs a pre-scan (begin_duplicate_prescan)");
+            }
+            two_tier_filter_->LoadSecondPass(in);
+            return;
+        }
+        GetDuplicateEventFilter().Load(in);
     }
 
 } // namespace at
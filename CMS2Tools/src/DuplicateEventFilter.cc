@@ -0,0 +1,406 @@
+#include "AnalysisTools/CMS2Tools/interface/DuplicateEventFilter.h"
+#include "AnalysisTools/CMS2Tools/interface/DorkyEventIdentifier.h"
+#include "AnalysisTools/CMS2Tools/interface/Mix64.h"
+
+// c++
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace at
+{
+    // helpers 
+    // ---------------------------------------------------------------------------------------- //
+
+    namespace
+    {
+        // number of shards = 2^shard_bits (picked by the top bits of the hash)
+        const unsigned int shard_bits = 6;
+        const size_t num_shards       = (1u << shard_bits);
+        const size_t min_capacity     = 1024;
+
+        // grow when the table is 70% full
+        const size_t max_load_num = 7;
+        const size_t max_load_den = 10;
+
+        // an empty slot (would be run 0xFFFFF, lumi 0xFFF, event 0xFFFFFFFF which are never packed)
+        const uint64_t empty_key = ~static_cast<uint64_t>(0);
+
+        // can the id be packed into 64 bits?
+        inline bool fits(const unsigned long run, const unsigned long lumi, const unsigned long event)
+        {
+            return run < 0xFFFFFul && lumi < 0x1000ul && event <= 0xFFFFFFFFul;
+        }
+
+        // 20 bits run | 12 bits lumi | 32 bits event
+        inline uint64_t pack(const unsigned long run, const unsigned long lumi, const unsigned long event)
+        {
+            return (static_cast<uint64_t>(run) << 44) | (static_cast<uint64_t>(lumi) << 32) | static_cast<uint64_t>(event);
+        }
+
+        // smallest power of 2 >= value
+        inline size_t next_pow2(const size_t value)
+        {
+            size_t result = 1;
+            while (result < value) {result <<= 1;}
+            return result;
+        }
+
+        // capacity of a shard needed to hold expected_size events in total
+        inline size_t shard_capacity(const size_t expected_size)
+        {
+            const size_t per_shard = (expected_size / num_shards) * max_load_den / max_load_num + 1;
+            return std::max(min_capacity, next_pow2(per_shard));
+        }
+
+    } // anonymous namespace
+
+    // one shard of the table 
+    // ---------------------------------------------------------------------------------------- //
+
+    struct DuplicateEventFilter::Shard
+    {
+        explicit Shard(const size_t capacity_)
+            : slots(NULL)
+            , capacity(0)
+            , size(0)
+            , users(0)
+            , growing(false)
+        {
+            Allocate(capacity_);
+        }
+
+        ~Shard()
+        {
+            delete [] slots;
+        }
+
+        void Allocate(const size_t new_capacity)
+        {
+            delete [] slots;
+            slots    = new std::atomic<uint64_t>[new_capacity];
+            capacity = new_capacity;
+            for (size_t i = 0; i != capacity; ++i) {slots[i].store(empty_key, std::memory_order_relaxed);}
+        }
+
+        // register as a user of the slots (waits while the shard grows)
+        void Enter()
+        {
+            for (;;)
+            {
+                while (growing) {std::this_thread::yield();}
+                ++users;
+                if (not growing) {return;}
+                --users;
+            }
+        }
+
+        void Leave()
+        {
+            --users;
+        }
+
+        // 0: inserted, 1: already there, 2: table is full
+        int InsertKey(const uint64_t key, const uint64_t key_hash)
+        {
+            const size_t mask = capacity - 1;
+            size_t index = static_cast<size_t>(key_hash) & mask;
+            for (size_t probe = 0; probe != capacity; ++probe, index = (index + 1) & mask)
+            {
+                uint64_t current = slots[index].load();
+                if (current == key) {return 1;}
+                if (current == empty_key)
+                {
+                    if (slots[index].compare_exchange_strong(current, key))
+                    {
+                        ++size;
+                        return 0;
+                    }
+                    // another thread took the slot first 
+                    if (current == key) {return 1;}
+                }
+            }
+            return 2;
+        }
+
+        bool ContainsKey(const uint64_t key, const uint64_t key_hash) const
+        {
+            const size_t mask = capacity - 1;
+            size_t index = static_cast<size_t>(key_hash) & mask;
+            for (size_t probe = 0; probe != capacity; ++probe, index = (index + 1) & mask)
+            {
+                const uint64_t current = slots[index].load();
+                if (current == key      ) {return true; }
+                if (current == empty_key) {return false;}
+            }
+            return false;
+        }
+
+        // double the table once all the current users have left
+        void Grow(const size_t old_capacity)
+        {
+            bool expected = false;
+            if (not growing.compare_exchange_strong(expected, true))
+            {
+                // someone else is already growing it
+                return;
+            }
+            while (users) {std::this_thread::yield();}
+
+            // only grow if nobody else did it in the meantime
+            if (capacity == old_capacity)
+            {
+                std::atomic<uint64_t>* const old_slots = slots;
+                slots    = NULL;
+                Allocate(2 * old_capacity);
+                for (size_t i = 0; i != old_capacity; ++i)
+                {
+                    const uint64_t key = old_slots[i].load(std::memory_order_relaxed);
+                    if (key == empty_key) {continue;}
+                    const size_t mask = capacity - 1;
+                    size_t index = static_cast<size_t>(detail::Mix64(key)) & mask;
+                    while (slots[index].load(std::memory_order_relaxed) != empty_key) {index = (index + 1) & mask;}
+                    slots[index].store(key, std::memory_order_relaxed);
+                }
+                delete [] old_slots;
+            }
+            growing = false;
+        }
+
+        std::atomic<uint64_t>* slots;
+        size_t capacity;
+        std::atomic<size_t> size;
+        std::atomic<int> users;
+        std::atomic<bool> growing;
+    };
+
+    // members
+    // ---------------------------------------------------------------------------------------- //
+
+    bool DuplicateEventFilter::WideKey::operator < (const WideKey& rhs) const
+    {
+        if (run  != rhs.run ) return run  < rhs.run;
+        if (lumi != rhs.lumi) return lumi < rhs.lumi;
+        return event < rhs.event;
+    }
+
+    DuplicateEventFilter::DuplicateEventFilter(const size_t expected_size)
+    {
+        const size_t capacity = shard_capacity(expected_size);
+        for (size_t i = 0; i != num_shards; ++i)
+        {
+            m_shards.emplace_back(new Shard(capacity));
+        }
+    }
+
+    DuplicateEventFilter::~DuplicateEventFilter()
+    {
+    }
+
+    bool DuplicateEventFilter::Insert(const DorkyEventIdentifier& id)
+    {
+        if (not fits(id.run, id.lumi, id.event))
+        {
+            const WideKey wide_key = {id.run, id.lumi, id.event};
+            std::lock_guard<std::mutex> lock(m_wide_mutex);
+            return not m_wide_keys.insert(wide_key).second;
+        }
+        return Insert(id.run, id.lumi, id.event);
+    }
+
+    bool DuplicateEventFilter::Insert(const unsigned int run, const unsigned int lumi, const unsigned int event)
+    {
+        if (not fits(run, lumi, event))
+        {
+            const WideKey wide_key = {run, lumi, event};
+            std::lock_guard<std::mutex> lock(m_wide_mutex);
+            return not m_wide_keys.insert(wide_key).second;
+        }
+
+        const uint64_t key      = pack(run, lumi, event);
+        const uint64_t key_hash = detail::Mix64(key);
+        Shard& shard = *m_shards[key_hash >> (64 - shard_bits)];
+        for (;;)
+        {
+            shard.Enter();
+            const size_t capacity = shard.capacity;
+            const int result      = shard.InsertKey(key, key_hash);
+            const size_t size     = shard.size;
+            shard.Leave();
+
+            if (result == 1) {return true;}
+            if (result == 0)
+            {
+                if (size * max_load_den > capacity * max_load_num) {shard.Grow(capacity);}
+                return false;
+            }
+
+            // table was full --> grow and try again
+            shard.Grow(capacity);
+        }
+    }
+
+    bool DuplicateEventFilter::Contains(const DorkyEventIdentifier& id) const
+    {
+        if (not fits(id.run, id.lumi, id.event))
+        {
+            const WideKey wide_key = {id.run, id.lumi, id.event};
+            std::lock_guard<std::mutex> lock(m_wide_mutex);
+            return m_wide_keys.count(wide_key) > 0;
+        }
+        return Contains(id.run, id.lumi, id.event);
+    }
+
+    bool DuplicateEventFilter::Contains(const unsigned int run, const unsigned int lumi, const unsigned int event) const
+    {
+        if (not fits(run, lumi, event))
+        {
+            const WideKey wide_key = {run, lumi, event};
+            std::lock_guard<std::mutex> lock(m_wide_mutex);
+            return m_wide_keys.count(wide_key) > 0;
+        }
+
+        const uint64_t key      = pack(run, lumi, event);
+        const uint64_t key_hash = detail::Mix64(key);
+        Shard& shard = *m_shards[key_hash >> (64 - shard_bits)];
+        shard.Enter();
+        const bool result = shard.ContainsKey(key, key_hash);
+        shard.Leave();
+        return result;
+    }
+
+    void DuplicateEventFilter::Reserve(const size_t expected_size)
+    {
+        const size_t capacity = shard_capacity(expected_size);
+        for (size_t i = 0; i != m_shards.size(); ++i)
+        {
+            while (m_shards[i]->capacity < capacity)
+            {
+                m_shards[i]->Grow(m_shards[i]->capacity);
+            }
+        }
+    }
+
+    void DuplicateEventFilter::Clear()
+    {
+        for (size_t i = 0; i != m_shards.size(); ++i)
+        {
+            Shard& shard = *m_shards[i];
+            for (size_t j = 0; j != shard.capacity; ++j) {shard.slots[j].store(empty_key);}
+            shard.size = 0;
+        }
+        std::lock_guard<std::mutex> lock(m_wide_mutex);
+        m_wide_keys.clear();
+    }
+
+    size_t DuplicateEventFilter::Size() const
+    {
+        size_t result = 0;
+        for (size_t i = 0; i != m_shards.size(); ++i)
+        {
+            result += m_shards[i]->size;
+        }
+        std::lock_guard<std::mutex> lock(m_wide_mutex);
+        return result + m_wide_keys.size();
+    }
+
+    size_t DuplicateEventFilter::MemoryUsage() const
+    {
+        size_t result = 0;
+        for (size_t i = 0; i != m_shards.size(); ++i)
+        {
+            result += sizeof(Shard) + m_shards[i]->capacity * sizeof(uint64_t);
+        }
+        // approximate size of a std::set node
+        std::lock_guard<std::mutex> lock(m_wide_mutex);
+        return result + m_wide_keys.size() * (sizeof(WideKey) + 4 * sizeof(void*));
+    }
+
+    // format: "ATDUPS01", # of packed keys, the keys, # of wide keys, the (run, lumi, event)s 
+    // (native byte order; only meant to be read back on the same kind of machine)
+    static const char save_tag[] = "ATDUPS01";
+
+    void DuplicateEventFilter::Save(std::ostream& out) const
+    {
+        out.write(save_tag, sizeof(save_tag) - 1);
+        uint64_t num_keys = 0;
+        for (size_t i = 0; i != m_shards.size(); ++i)
+        {
+            num_keys += m_shards[i]->size;
+        }
+        out.write(reinterpret_cast<const char*>(&num_keys), sizeof(num_keys));
+        for (size_t i = 0; i != m_shards.size(); ++i)
+        {
+            const Shard& shard = *m_shards[i];
+            for (size_t j = 0; j != shard.capacity; ++j)
+            {
+                const uint64_t key = shard.slots[j].load(std::memory_order_relaxed);
+                if (key == empty_key) {continue;}
+                out.write(reinterpret_cast<const char*>(&key), sizeof(key));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_wide_mutex);
+        const uint64_t num_wide_keys = m_wide_keys.size();
+        out.write(reinterpret_cast<const char*>(&num_wide_keys), sizeof(num_wide_keys));
+        for (std::set<WideKey>::const_iterator iter = m_wide_keys.begin(); iter != m_wide_keys.end(); ++iter)
+        {
+            const uint64_t values[3] = {iter->run, iter->lumi, iter->event};
+            out.write(reinterpret_cast<const char*>(values), sizeof(values));
+        }
+        if (!out)
+        {
+            throw std::runtime_error("[at::DuplicateEventFilter::Save] Error: writing failed");
+        }
+    }
+
+    void DuplicateEventFilter::Load(std::istream& in)
+    {
+        char tag[sizeof(save_tag) - 1];
+        if (!in.read(tag, sizeof(tag)) || !std::equal(tag, tag + sizeof(tag), save_tag))
+        {
+            throw std::runtime_error("[at::DuplicateEventFilter::Load] Error: not a saved duplicate filter");
+        }
+        Clear();
+
+        uint64_t num_keys = 0;
+        in.read(reinterpret_cast<char*>(&num_keys), sizeof(num_keys));
+        Reserve(num_keys);
+        for (uint64_t i = 0; in && i != num_keys; ++i)
+        {
+            uint64_t key = 0;
+            if (!in.read(reinterpret_cast<char*>(&key), sizeof(key))) {break;}
+            Insert(key >> 44, (key >> 32) & 0xFFFul, key & 0xFFFFFFFFul);
+        }
+
+        uint64_t num_wide_keys = 0;
+        in.read(reinterpret_cast<char*>(&num_wide_keys), sizeof(num_wide_keys));
+        std::lock_guard<std::mutex> lock(m_wide_mutex);
+        for (uint64_t i = 0; in && i != num_wide_keys; ++i)
+        {
+            uint64_t values[3] = {0, 0, 0};
+            if (!in.read(reinterpret_cast<char*>(values), sizeof(values))) {break;}
+            const WideKey wide_key = {values[0], values[1], values[2]};
+            m_wide_keys.insert(wide_key);
+        }
+        if (!in)
+        {
+            throw std::runtime_error("[at::DuplicateEventFilter::Load] Error: reading failed (truncated file?)");
+        }
+    }
+
+    // the filter behind at::is_duplicate
+    DuplicateEventFilter& GetDuplicateEventFilter()
+    {
+        static DuplicateEventFilter filter;
+        return filter;
+    }
+
+    // reserve space in the at::is_duplicate filter
+    void reserve_duplicate_filter(const size_t expected_size)
+    {
+        GetDuplicateEventFilter().Reserve(expected_size);
+    }
+
+} // namespace at
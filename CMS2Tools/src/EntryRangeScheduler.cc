@@ -0,0 +1,185 @@
+#include "AnalysisTools/CMS2Tools/interface/EntryRangeScheduler.h"
+
+// c++
+#include <stdexcept>
+#include <algorithm>
+
+// ROOT
+#include "TTree.h"
+#include "TChain.h"
+#include "TFile.h"
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/FileFaultPolicy.h"
+
+namespace at
+{
+    // one range per file of the chain 
+    std::vector<EntryRange> GetFileRanges(TChain& chain)
+    {
+        // GetEntries() fills the tree offsets
+        chain.GetEntries();
+        const long long* const offsets = chain.GetTreeOffset();
+        std::vector<EntryRange> result;
+        for (int i = 0; i < chain.GetNtrees(); ++i)
+        {
+            const EntryRange range = {static_cast<size_t>(i), 0, offsets[i+1] - offsets[i]};
+            result.push_back(range);
+        }
+        return result;
+    }
+
+    // split the tree into ranges aligned to its basket clusters.
+    std::vector<EntryRange> GetClusterAlignedRanges(TTree& tree, const size_t file_index, const long long min_entries)
+    {
+        std::vector<EntryRange> result;
+        const long long num_entries = tree.GetEntriesFast();
+        TTree::TClusterIterator cluster_iter = tree.GetClusterIterator(0);
+        long long begin = 0;
+        long long start = 0;
+        while ((start = cluster_iter.Next()) < num_entries)
+        {
+            const long long end = cluster_iter.GetNextEntry();
+            if (end - begin >= min_entries || end >= num_entries)
+            {
+                const EntryRange range = {file_index, begin, (end < num_entries ? end : num_entries)};
+                result.push_back(range);
+                begin = range.end;
+            }
+        }
+        if (begin < num_entries)
+        {
+            const EntryRange range = {file_index, begin, num_entries};
+            result.push_back(range);
+        }
+        return result;
+    }
+
+    // same as above for every file in the chain
+    std::vector<EntryRange> GetClusterAlignedRanges(TChain& chain, const long long min_entries)
+    {
+        std::vector<EntryRange> result;
+        TObjArray* const list_of_files = chain.GetListOfFiles();
+        for (int i = 0; i < list_of_files->GetEntries(); ++i)
+        {
+            const char* const file_name = list_of_files->At(i)->GetTitle();
+            TFile* file = NULL;
+            TTree* tree = NULL;
+            unsigned int num_attempts = 0;
+            const std::string error = OpenFileAndTree(file_name, chain.GetName(), file, tree, num_attempts);
+            if (!error.empty())
+            {
+                if (get_file_fault_policy() == FileFaultPolicy::FAIL)
+                {
+                    throw std::runtime_error(error);
+                }
+
+                // one range for the whole file: the worker that gets it skips it
+                // (it has the entries the chain counted, 0 if the chain couldn't open it either;
+                // the lost entries are then reported from the indexes, see GetBadFileEntries)
+                chain.GetEntries();
+                const long long* const offsets = chain.GetTreeOffset();
+                const EntryRange range = {static_cast<size_t>(i), 0, offsets[i+1] - offsets[i]};
+                result.push_back(range);
+                continue;
+            }
+            const std::vector<EntryRange> ranges = GetClusterAlignedRanges(*tree, i, min_entries);
+            result.insert(result.end(), ranges.begin(), ranges.end());
+            file->Close();
+            delete file;
+        }
+        return result;
+    }
+
+    // the parts of the ranges that are inside the owned ranges
+    std::vector<EntryRange> IntersectRanges(const std::vector<EntryRange>& ranges, const std::vector<EntryRange>& owned)
+    {
+        std::vector<EntryRange> result;
+        size_t first = 0;
+        for (size_t i = 0; i != ranges.size(); ++i)
+        {
+            const EntryRange& range = ranges[i];
+
+            // the owned ranges before this range are done
+            while (first != owned.size() && (owned[first].file_index < range.file_index || (owned[first].file_index == range.file_index && owned[first].end <= range.begin)))
+            {
+                ++first;
+            }
+            for (size_t j = first; j != owned.size() && owned[j].file_index == range.file_index && owned[j].begin < range.end; ++j)
+            {
+                const EntryRange part = {range.file_index, std::max(range.begin, owned[j].begin), std::min(range.end, owned[j].end)};
+                result.push_back(part);
+            }
+        }
+        return result;
+    }
+
+    // Hands out EntryRanges to a fixed number of workers.
+    EntryRangeScheduler::EntryRangeScheduler(const std::vector<EntryRange>& ranges, const size_t num_workers)
+        : m_num_steals(0)
+    {
+        if (num_workers < 1)
+        {
+            throw std::invalid_argument("[at::EntryRangeScheduler] Error: need at least one worker");
+        }
+        for (size_t i = 0; i != num_workers; ++i)
+        {
+            m_queues.emplace_back(new WorkQueue);
+        }
+
+        // contiguous blocks with about the same number of entries
+        long long num_entries = 0;
+        for (size_t i = 0; i != ranges.size(); ++i)
+        {
+            num_entries += ranges[i].end - ranges[i].begin;
+        }
+        long long entries_so_far = 0;
+        for (size_t i = 0; i != ranges.size(); ++i)
+        {
+            size_t worker = (num_entries > 0 ? static_cast<size_t>((entries_so_far * num_workers) / num_entries) : 0);
+            if (worker >= num_workers) {worker = num_workers - 1;}
+            m_queues[worker]->ranges.push_back(ranges[i]);
+            entries_so_far += ranges[i].end - ranges[i].begin;
+        }
+    }
+
+    // get the next range for this worker (false --> no work is left)
+    bool EntryRangeScheduler::Next(const size_t worker, EntryRange& range)
+    {
+        // own queue first (front to back)
+        {
+            WorkQueue& queue = *m_queues.at(worker);
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (not queue.ranges.empty())
+            {
+                range = queue.ranges.front();
+                queue.ranges.pop_front();
+                return true;
+            }
+        }
+
+        // steal from the back of the others
+        // (ranges are never added after construction so one empty pass means we are done)
+        const size_t num_workers = m_queues.size();
+        for (size_t i = 1; i != num_workers; ++i)
+        {
+            WorkQueue& victim = *m_queues[(worker + i) % num_workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (not victim.ranges.empty())
+            {
+                range = victim.ranges.back();
+                victim.ranges.pop_back();
+                ++m_num_steals;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // number of ranges taken from another worker's queue
+    size_t EntryRangeScheduler::NumSteals() const
+    {
+        return m_num_steals;
+    }
+
+} // namespace at
@@ -0,0 +1,165 @@
+#include "AnalysisTools/CMS2Tools/interface/EventBlock.h"
+
+// c++
+#include <stdexcept>
+
+// ROOT
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+
+namespace at
+{
+    namespace
+    {
+        // GetValue only makes sense for numbers and arrays or vectors of them
+        // (e.g. not for the vector<LorentzVector> branches of CMS2)
+        bool IsNumericLeaf(const TLeaf& leaf)
+        {
+            static const char* const numeric_types[] = 
+            {
+                "Bool_t", "bool", "Char_t", "char", "UChar_t", "unsigned char", "Short_t", "short", "UShort_t", "unsigned short",
+                "Int_t", "int", "UInt_t", "unsigned int", "Long_t", "long", "ULong_t", "unsigned long", "Long64_t", "long long", 
+                "ULong64_t", "unsigned long long", "Float_t", "float", "Double_t", "double", "Double32_t", "Float16_t"
+            };
+            std::string type_name = (leaf.GetTypeName() ? leaf.GetTypeName() : "");
+            if (type_name.compare(0, 7, "vector<") == 0 && type_name[type_name.size() - 1] == '>')
+            {
+                type_name = type_name.substr(7, type_name.size() - 8);
+            }
+            for (size_t i = 0; i != sizeof(numeric_types) / sizeof(numeric_types[0]); ++i)
+            {
+                if (type_name == numeric_types[i]) {return true;}
+            }
+            return false;
+        }
+
+    } // anonymous namespace
+
+    EventBlock::EventBlock(const std::vector<std::string>& branch_names, const size_t capacity)
+        : m_capacity(capacity > 0 ? capacity : 1)
+        , m_branch_names(branch_names)
+        , m_tree(NULL)
+        , m_file_name()
+        , m_leaves(branch_names.size(), NULL)
+        , m_entries()
+        , m_values(branch_names.size())
+        , m_offsets(branch_names.size(), std::vector<size_t>(1, 0))
+    {
+        m_entries.reserve(m_capacity);
+        for (size_t i = 0; i != m_offsets.size(); ++i)
+        {
+            m_offsets[i].reserve(m_capacity + 1);
+        }
+    }
+
+    // read the columns from this tree from now on
+    void EventBlock::SetTree(TTree& tree, const std::string& file_name)
+    {
+        Clear();
+        m_tree      = &tree;
+        m_file_name = file_name;
+        for (size_t i = 0; i != m_branch_names.size(); ++i)
+        {
+            const std::string& name = m_branch_names[i];
+            TLeaf* leaf = tree.GetLeaf(name.c_str());
+            if (!leaf)
+            {
+                // the branch name of a leaf with a different name (e.g. the .obj branches of CMS2)
+                TBranch* const branch = tree.GetBranch(name.c_str());
+                if (branch && branch->GetListOfLeaves() && branch->GetListOfLeaves()->GetEntries() > 0)
+                {
+                    leaf = static_cast<TLeaf*>(branch->GetListOfLeaves()->At(0));
+                }
+            }
+            if (!leaf || !leaf->GetBranch())
+            {
+                throw std::invalid_argument("[at::EventBlock::SetTree] Error: no branch " + name + " in " + file_name);
+            }
+            if (not IsNumericLeaf(*leaf))
+            {
+                throw std::invalid_argument("[at::EventBlock::SetTree] Error: branch " + name + " is not numeric (" + leaf->GetTypeName() + ")");
+            }
+
+            // a pruned tree (see BranchUsageProfile) still has to read the columns
+            tree.SetBranchStatus(leaf->GetBranch()->GetName(), 1);
+            m_leaves[i] = leaf;
+        }
+    }
+
+    // add the entry of the tree and read its column values
+    void EventBlock::Add(const long entry)
+    {
+        if (!m_tree)
+        {
+            throw std::logic_error("[at::EventBlock::Add] Error: no tree (call SetTree first)");
+        }
+        m_entries.push_back(entry);
+        for (size_t i = 0; i != m_leaves.size(); ++i)
+        {
+            TLeaf* const leaf = m_leaves[i];
+            TBranch* const branch = leaf->GetBranch();
+            if (branch->GetReadEntry() != entry)
+            {
+                branch->GetEntry(entry);
+            }
+            std::vector<double>& values = m_values[i];
+            const int num_values = leaf->GetLen();
+            for (int j = 0; j < num_values; ++j)
+            {
+                values.push_back(leaf->GetValue(j));
+            }
+            m_offsets[i].push_back(values.size());
+        }
+    }
+
+    // remove the events (the tree is kept)
+    void EventBlock::Clear()
+    {
+        m_entries.clear();
+        for (size_t i = 0; i != m_values.size(); ++i)
+        {
+            m_values[i].clear();
+            m_offsets[i].assign(1, 0);
+        }
+    }
+
+    size_t EventBlock::Column(const std::string& branch_name) const
+    {
+        for (size_t i = 0; i != m_branch_names.size(); ++i)
+        {
+            if (m_branch_names[i] == branch_name) {return i;}
+        }
+        throw std::invalid_argument("[at::EventBlock::Column] Error: branch not in the block: " + branch_name);
+    }
+
+    const double* EventBlock::Begin(const size_t column, const size_t event) const
+    {
+        return m_values.at(column).data() + m_offsets.at(column).at(event);
+    }
+
+    const double* EventBlock::End(const size_t column, const size_t event) const
+    {
+        return m_values.at(column).data() + m_offsets.at(column).at(event + 1);
+    }
+
+    size_t EventBlock::NumValues(const size_t column, const size_t event) const
+    {
+        return m_offsets.at(column).at(event + 1) - m_offsets.at(column).at(event);
+    }
+
+    // the number of events in the blocks of the ScanChain functions
+    static size_t event_block_size_ = 256;
+
+    void set_event_block_size(const size_t block_size)
+    {
+        event_block_size_ = (block_size > 0 ? block_size : 1);
+    }
+
+    size_t get_event_block_size()
+    {
+        return event_block_size_;
+    }
+
+} // namespace at
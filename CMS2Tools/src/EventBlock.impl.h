@@ -0,0 +1,27 @@
+// c++
+#include <utility>
+#include <type_traits>
+
+namespace at
+{
+    namespace detail
+    {
+        template <typename Analyzer>
+        auto HasEventBlockAnalyzeImpl(int) -> decltype
+        (
+            std::declval<Analyzer&>().Analyze(std::declval<const EventBlock&>()),
+            std::vector<std::string>(std::declval<Analyzer&>().GetBlockBranchNames()),
+            std::true_type()
+        );
+
+        template <typename Analyzer>
+        std::false_type HasEventBlockAnalyzeImpl(long);
+
+    } // namespace detail
+
+    template <typename Analyzer>
+    struct HasEventBlockAnalyze : decltype(detail::HasEventBlockAnalyzeImpl<Analyzer>(0))
+    {
+    };
+
+} // namespace at
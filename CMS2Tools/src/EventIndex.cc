@@ -0,0 +1,408 @@
+#include "AnalysisTools/CMS2Tools/interface/EventIndex.h"
+
+// c++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <mutex>
+#include <set>
+
+namespace at
+{
+    EventIndex::EventIndex()
+        : m_num_locations(0)
+        , m_locations_offset(0)
+        , m_selected_run(-1)
+        , m_selected_lumi(-1)
+        , m_selected_event(-1)
+    {
+    }
+
+    EventIndex::EventIndex(const std::string& file_name)
+        : m_num_locations(0)
+        , m_locations_offset(0)
+        , m_selected_run(-1)
+        , m_selected_lumi(-1)
+        , m_selected_event(-1)
+    {
+        Read(file_name);
+    }
+
+    EventIndex::~EventIndex()
+    {
+    }
+
+    void EventIndex::Clear()
+    {
+        m_tree_name.clear();
+        m_file_names.clear();
+        m_file_entries.clear();
+        m_file_map.clear();
+        m_locations.clear();
+        m_num_locations = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_in_mutex);
+            m_file_name.clear();
+            m_locations_offset = 0;
+            m_in.reset();
+        }
+        std::lock_guard<std::mutex> lock(m_selected_mutex);
+        m_selected_ranges.clear();
+    }
+
+    void EventIndex::BeginBuild(const std::string& tree_name)
+    {
+        Clear();
+        m_tree_name = tree_name;
+    }
+
+    void EventIndex::AddFile(const std::string& file_name, const long long num_entries)
+    {
+        m_file_map[file_name] = m_file_names.size();
+        m_file_names.push_back(file_name);
+        m_file_entries.push_back(num_entries);
+        m_locations.reserve(m_locations.size() + num_entries);
+    }
+
+    // add an entry of the last file added
+    void EventIndex::AddEntry(const unsigned int run, const unsigned int lumi, const unsigned int event, const long long entry)
+    {
+        if (m_file_names.empty())
+        {
+            throw std::runtime_error("[at::EventIndex::AddEntry] Error: no file to add the entry to");
+        }
+        const Location location = {run, lumi, event, static_cast<unsigned int>(m_file_names.size() - 1), entry};
+        m_locations.push_back(location);
+    }
+
+    void EventIndex::EndBuild()
+    {
+        std::sort(m_locations.begin(), m_locations.end(), detail::EventLocationLess);
+        m_num_locations = m_locations.size();
+    }
+
+    // format: "ATEVTIDX01", tree name, # of files, (# of entries, file name) per file, # of events, the locations
+    // (strings are written as their length then the characters; native byte order, like the other binary
+    // files of CMS2Tools it is only meant to be read back on the same kind of machine)
+    static const char index_tag[] = "ATEVTIDX01";
+
+    static void WriteString(std::ostream& out, const std::string& value)
+    {
+        const unsigned long long size = value.size();
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(value.data(), size);
+    }
+
+    static bool ReadString(std::istream& in, std::string& value)
+    {
+        unsigned long long size = 0;
+        if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > 65536) {return false;}
+        value.resize(size);
+        return size == 0 || static_cast<bool>(in.read(&value[0], size));
+    }
+
+    // number of locations read or written at a time
+    static const size_t locations_per_read = 4096;
+
+    void EventIndex::Write(const std::string& file_name) const
+    {
+        if (not m_file_name.empty() && file_name == m_file_name)
+        {
+            throw std::runtime_error("[at::EventIndex::Write] Error: cannot overwrite the file the index is read from: " + file_name);
+        }
+        std::ofstream out(file_name.c_str(), std::ios::binary);
+        if (!out)
+        {
+            throw std::runtime_error("[at::EventIndex::Write] Error: cannot open " + file_name);
+        }
+        out.write(index_tag, sizeof(index_tag) - 1);
+        WriteString(out, m_tree_name);
+        const unsigned long long num_files = m_file_names.size();
+        out.write(reinterpret_cast<const char*>(&num_files), sizeof(num_files));
+        for (size_t i = 0; i != m_file_names.size(); ++i)
+        {
+            out.write(reinterpret_cast<const char*>(&m_file_entries[i]), sizeof(m_file_entries[i]));
+            WriteString(out, m_file_names[i]);
+        }
+        const unsigned long long num_locations = m_num_locations;
+        out.write(reinterpret_cast<const char*>(&num_locations), sizeof(num_locations));
+        std::vector<Location> locations;
+        for (size_t first = 0; first < m_num_locations && out; first += locations.size())
+        {
+            ReadLocations(first, locations_per_read, locations);
+            out.write(reinterpret_cast<const char*>(&locations.front()), locations.size() * sizeof(Location));
+        }
+        if (!out)
+        {
+            throw std::runtime_error("[at::EventIndex::Write] Error: failed writing " + file_name);
+        }
+    }
+
+    void EventIndex::Read(const std::string& file_name)
+    {
+        std::unique_ptr<std::ifstream> in_ptr(new std::ifstream(file_name.c_str(), std::ios::binary));
+        std::ifstream& in = *in_ptr;
+        if (!in)
+        {
+            throw std::runtime_error("[at::EventIndex::Read] Error: cannot open " + file_name);
+        }
+        Clear();
+        char tag[sizeof(index_tag) - 1];
+        if (!in.read(tag, sizeof(tag)) || !std::equal(tag, tag + sizeof(tag), index_tag))
+        {
+            throw std::runtime_error("[at::EventIndex::Read] Error: not an event index: " + file_name);
+        }
+
+        unsigned long long num_files = 0;
+        if (!ReadString(in, m_tree_name) || !in.read(reinterpret_cast<char*>(&num_files), sizeof(num_files)))
+        {
+            throw std::runtime_error("[at::EventIndex::Read] Error: bad header in " + file_name);
+        }
+        for (unsigned long long i = 0; i != num_files; ++i)
+        {
+            long long entries = 0;
+            std::string name;
+            if (!in.read(reinterpret_cast<char*>(&entries), sizeof(entries)) || !ReadString(in, name))
+            {
+                std::ostringstream msg;
+                msg << "[at::EventIndex::Read] Error: bad file " << i << " in " << file_name;
+                throw std::runtime_error(msg.str());
+            }
+            m_file_map[name] = m_file_names.size();
+            m_file_names.push_back(name);
+            m_file_entries.push_back(entries);
+        }
+
+        // only the header is read: the locations are looked up in the file (see ReadLocations)
+        unsigned long long num_locations = 0;
+        in.read(reinterpret_cast<char*>(&num_locations), sizeof(num_locations));
+        const long long locations_offset = in ? static_cast<long long>(in.tellg()) : 0;
+        in.seekg(0, std::ios::end);
+        const long long file_size = in ? static_cast<long long>(in.tellg()) : 0;
+        if (!in || file_size - locations_offset != static_cast<long long>(num_locations * sizeof(Location)))
+        {
+            Clear();
+            throw std::runtime_error("[at::EventIndex::Read] Error: reading failed (truncated file?) " + file_name);
+        }
+        std::lock_guard<std::mutex> lock(m_in_mutex);
+        m_num_locations    = num_locations;
+        m_file_name        = file_name;
+        m_locations_offset = locations_offset;
+        m_in.reset(in_ptr.release());
+    }
+
+    // the locations [first, first + count) (fewer at the end of the index)
+    void EventIndex::ReadLocations(const size_t first, const size_t count, std::vector<Location>& locations) const
+    {
+        locations.resize(first < m_num_locations ? std::min(count, m_num_locations - first) : 0);
+        if (locations.empty())
+        {
+            return;
+        }
+        if (!m_in)
+        {
+            std::copy(m_locations.begin() + first, m_locations.begin() + first + locations.size(), locations.begin());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_in_mutex);
+        m_in->clear();
+        m_in->seekg(m_locations_offset + static_cast<long long>(first * sizeof(Location)));
+        if (!m_in->read(reinterpret_cast<char*>(&locations.front()), locations.size() * sizeof(Location)))
+        {
+            throw std::runtime_error("[at::EventIndex] Error: reading failed " + m_file_name);
+        }
+        for (size_t i = 0; i != locations.size(); ++i)
+        {
+            if (locations[i].file_index >= m_file_names.size())
+            {
+                throw std::runtime_error("[at::EventIndex] Error: bad event location in " + m_file_name);
+            }
+        }
+    }
+
+    // the first location that is not less than value (one record read per step)
+    size_t EventIndex::LowerBound(const Location& value) const
+    {
+        size_t first = 0;
+        size_t count = m_num_locations;
+        std::vector<Location> location;
+        while (count > 0)
+        {
+            const size_t step = count / 2;
+            ReadLocations(first + step, 1, location);
+            if (detail::EventLocationLess(location.front(), value))
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+    size_t EventIndex::FileIndex(const std::string& file_name) const
+    {
+        std::map<std::string, size_t>::const_iterator iter = m_file_map.find(file_name);
+        if (iter == m_file_map.end())
+        {
+            throw std::runtime_error("[at::EventIndex] Error: file not in the index: " + file_name);
+        }
+        return iter->second;
+    }
+
+    bool EventIndex::Contains(const std::string& file_name) const
+    {
+        return m_file_map.find(file_name) != m_file_map.end();
+    }
+
+    long long EventIndex::GetEntries(const std::string& file_name) const
+    {
+        return m_file_entries.at(FileIndex(file_name));
+    }
+
+    // the locations of the event (more than one if it is duplicated)
+    std::vector<EventIndex::Location> EventIndex::Find(const unsigned int run, const unsigned int lumi, const unsigned int event) const
+    {
+        const Location value = {run, lumi, event, 0, 0};
+        std::vector<Location> result;
+        std::vector<Location> locations;
+        for (size_t first = LowerBound(value); first < m_num_locations; first += locations.size())
+        {
+            // an event is rarely in more than one place so only a few are read at a time
+            ReadLocations(first, 16, locations);
+            for (std::vector<Location>::const_iterator iter = locations.begin(); iter != locations.end(); ++iter)
+            {
+                if (iter->run != run || iter->lumi != lumi || iter->event != event)
+                {
+                    return result;
+                }
+                result.push_back(*iter);
+            }
+        }
+        return result;
+    }
+
+    static bool LocationInFileLess(const EventIndex::Location& lhs, const EventIndex::Location& rhs)
+    {
+        return (lhs.file_index != rhs.file_index ? lhs.file_index < rhs.file_index : lhs.entry < rhs.entry);
+    }
+
+    // the locations that pass the selection sorted by (file, entry)
+    std::vector<EventIndex::Location> EventIndex::Select(const int run, const int lumi, const int event) const
+    {
+        // the locations are sorted by run first, so only the events of the run are checked
+        size_t begin = 0;
+        if (run >= 0)
+        {
+            const Location value = {static_cast<unsigned int>(run), (lumi >= 0 ? static_cast<unsigned int>(lumi) : 0), 0, 0, 0};
+            begin = LowerBound(value);
+        }
+
+        std::vector<Location> result;
+        std::vector<Location> locations;
+        bool done = false;
+        for (size_t first = begin; first < m_num_locations && not done; first += locations.size())
+        {
+            ReadLocations(first, locations_per_read, locations);
+            for (std::vector<Location>::const_iterator iter = locations.begin(); iter != locations.end(); ++iter)
+            {
+                if (run >= 0 && iter->run != static_cast<unsigned int>(run)) {done = true; break;}
+                if (run >= 0 && lumi >= 0 && iter->lumi != static_cast<unsigned int>(lumi)) {done = true; break;}
+                if (lumi  >= 0 && iter->lumi  != static_cast<unsigned int>(lumi )) continue;
+                if (event >= 0 && iter->event != static_cast<unsigned int>(event)) continue;
+                result.push_back(*iter);
+            }
+        }
+        std::sort(result.begin(), result.end(), LocationInFileLess);
+        return result;
+    }
+
+    // the entries of the file that pass the selection (adjacent entries are merged)
+    std::vector<EntryRange> EventIndex::GetRanges(const std::string& file_name, const size_t file_index, const int run, const int lumi, const int event) const
+    {
+        const size_t index = FileIndex(file_name);
+
+        // ScanChain asks for the same selection for every file, so it is only done once
+        std::lock_guard<std::mutex> lock(m_selected_mutex);
+        if (m_selected_ranges.empty() || run != m_selected_run || lumi != m_selected_lumi || event != m_selected_event)
+        {
+            m_selected_ranges.assign(m_file_names.size(), std::vector<EntryRange>());
+            const std::vector<Location> locations = Select(run, lumi, event);
+            for (size_t i = 0; i != locations.size(); ++i)
+            {
+                std::vector<EntryRange>& ranges = m_selected_ranges[locations[i].file_index];
+                if (not ranges.empty() && ranges.back().end == locations[i].entry)
+                {
+                    ranges.back().end = locations[i].entry + 1;
+                }
+                else
+                {
+                    const EntryRange range = {locations[i].file_index, locations[i].entry, locations[i].entry + 1};
+                    ranges.push_back(range);
+                }
+            }
+            m_selected_run   = run;
+            m_selected_lumi  = lumi;
+            m_selected_event = event;
+        }
+
+        std::vector<EntryRange> result = m_selected_ranges[index];
+        for (size_t i = 0; i != result.size(); ++i)
+        {
+            result[i].file_index = file_index;
+        }
+        return result;
+    }
+
+    // the index used by the ScanChain functions
+    static std::unique_ptr<EventIndex> event_index_;
+    static std::mutex event_index_mutex_;
+
+    void set_event_index_file(const std::string& file_name)
+    {
+        std::lock_guard<std::mutex> lock(event_index_mutex_);
+        if (file_name.empty())
+        {
+            event_index_.reset();
+            return;
+        }
+        event_index_.reset(new EventIndex(file_name));
+    }
+
+    const EventIndex* get_event_index()
+    {
+        return event_index_.get();
+    }
+
+    // the entries of the file that the ScanChain functions read for the evt_run/evt_lumi/evt_event arguments
+    static std::set<std::string> changed_files_;
+
+    OwnedEntryCursor GetSelectedEntries(const std::string& file_name, const int evt_run, const int evt_lumi, const int evt_event, const long long num_entries)
+    {
+        std::lock_guard<std::mutex> lock(event_index_mutex_);
+        if (!event_index_ || (evt_run < 0 && evt_lumi < 0 && evt_event < 0) || not event_index_->Contains(file_name))
+        {
+            return OwnedEntryCursor();
+        }
+
+        // the entries of a file changed since it was indexed are not where the index says
+        if (num_entries >= 0 && num_entries != event_index_->GetEntries(file_name))
+        {
+            if (changed_files_.insert(file_name).second)
+            {
+                std::cout << "Warning: " << file_name << " has " << num_entries << " entries but " << event_index_->GetEntries(file_name) 
+                          << " in the event index (reading all of them)" << std::endl;
+            }
+            return OwnedEntryCursor();
+        }
+        return OwnedEntryCursor(event_index_->GetRanges(file_name, 0, evt_run, evt_lumi, evt_event), event_index_->GetEntries(file_name));
+    }
+
+} // namespace at
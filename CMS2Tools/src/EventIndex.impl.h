@@ -0,0 +1,88 @@
+// c++
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+// ROOT
+#include "TChain.h"
+#include "TFile.h"
+#include "TTree.h"
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/LumiPreFilter.h"
+
+namespace at
+{
+    namespace detail
+    {
+        inline bool EventLocationLess(const EventIndex::Location& lhs, const EventIndex::Location& rhs)
+        {
+            if (lhs.run        != rhs.run       ) {return lhs.run        < rhs.run;       }
+            if (lhs.lumi       != rhs.lumi      ) {return lhs.lumi       < rhs.lumi;      }
+            if (lhs.event      != rhs.event     ) {return lhs.event      < rhs.event;     }
+            if (lhs.file_index != rhs.file_index) {return lhs.file_index < rhs.file_index;}
+            return lhs.entry < rhs.entry;
+        }
+
+    } // namespace detail
+
+    // build the index from the chain (reads only the event id of every entry)
+    template <typename NtupleClass>
+    void EventIndex::Build(TChain& chain, NtupleClass& ntuple_class, const bool verbose)
+    {
+        BuildIndexes(chain, ntuple_class, NULL, this, verbose);
+    }
+
+    // build a lumi index and an event index of the chain in one pass (either can be NULL)
+    template <typename NtupleClass>
+    void BuildIndexes(TChain& chain, NtupleClass& ntuple_class, LumiIndex* const lumi_index, EventIndex* const event_index, const bool verbose)
+    {
+        const std::string tree_name = chain.GetName();
+        if (lumi_index ) {lumi_index->BeginBuild(tree_name); }
+        if (event_index) {event_index->BeginBuild(tree_name);}
+
+        TObjArray* const list_of_files = chain.GetListOfFiles();
+        for (int i = 0; i < list_of_files->GetEntries(); ++i)
+        {
+            const std::string file_name = list_of_files->At(i)->GetTitle();
+            if (verbose) {std::cout << "[at::BuildIndexes] indexing " << file_name << std::endl;}
+
+            TFile* const file = TFile::Open(file_name.c_str());
+            if (!file || file->IsZombie())
+            {
+                throw std::runtime_error(Form("File from TChain is invalid or corrupt: %s", file_name.c_str()));
+            }
+            TTree* const tree = dynamic_cast<TTree*>(file->Get(tree_name.c_str()));
+            if (!tree || tree->IsZombie())
+            {
+                throw std::runtime_error(Form("File from TChain has an invalid TTree or is corrupt: %s", file_name.c_str()));
+            }
+            Init(ntuple_class, tree);
+
+            // a file is either all data or all MC
+            const long long num_entries = tree->GetEntriesFast();
+            bool is_mc = false;
+            if (num_entries > 0)
+            {
+                LoadEventId(ntuple_class, 0);
+                is_mc = not IsRealData(ntuple_class);
+            }
+            if (lumi_index ) {lumi_index->AddFile(file_name, num_entries, is_mc);}
+            if (event_index) {event_index->AddFile(file_name, num_entries);     }
+
+            // the lumi index has no blocks for MC
+            const bool add_lumis = lumi_index && not is_mc;
+            for (long long entry = 0; entry != num_entries && (add_lumis || event_index); ++entry)
+            {
+                LoadEventId(ntuple_class, entry);
+                if (add_lumis  ) {lumi_index->AddEntry(Run(ntuple_class), LumiBlock(ntuple_class), entry);}
+                if (event_index) {event_index->AddEntry(Run(ntuple_class), LumiBlock(ntuple_class), Event(ntuple_class), entry);}
+            }
+
+            file->Close();
+            delete file;
+        }
+        if (event_index) {event_index->EndBuild();}
+    }
+
+} // namespace at
@@ -0,0 +1,262 @@
+#include "AnalysisTools/CMS2Tools/interface/FileFaultPolicy.h"
+#include "AnalysisTools/CMS2Tools/interface/LumiIndex.h"
+#include "AnalysisTools/CMS2Tools/interface/EventIndex.h"
+
+// c++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TDirectory.h"
+
+namespace at
+{
+    // the policy
+    static FileFaultPolicy::value_type file_fault_policy_ = FileFaultPolicy::FAIL;
+    static unsigned int file_fault_retries_                = 3;
+    static double file_fault_backoff_                      = 5.0;
+
+    void set_file_fault_policy(const FileFaultPolicy::value_type policy, const unsigned int num_retries, const double backoff)
+    {
+        if (policy < 0 || policy >= FileFaultPolicy::static_size)
+        {
+            throw std::invalid_argument("[at::set_file_fault_policy] Error: invalid policy");
+        }
+        file_fault_policy_  = policy;
+        file_fault_retries_ = num_retries;
+        file_fault_backoff_ = (backoff > 0 ? backoff : 0.0);
+    }
+
+    FileFaultPolicy::value_type get_file_fault_policy()
+    {
+        return file_fault_policy_;
+    }
+
+    unsigned int get_file_fault_retries()
+    {
+        return file_fault_retries_;
+    }
+
+    double get_file_fault_backoff()
+    {
+        return file_fault_backoff_;
+    }
+
+    // one attempt (Form is not thread safe so the messages are built by hand)
+    // TFile::Open makes the file the current directory: the context puts back the caller's (e.g. the analyzer's output file)
+    static std::string TryOpenFileAndTree(const std::string& file_name, const std::string& tree_name, TFile*& file, TTree*& tree)
+    {
+        TDirectory::TContext context;
+        file = TFile::Open(file_name.c_str());
+        tree = NULL;
+        if (!file || file->IsZombie())
+        {
+            delete file;
+            file = NULL;
+            return "File from TChain is invalid or corrupt: " + file_name;
+        }
+        tree = dynamic_cast<TTree*>(file->Get(tree_name.c_str()));
+        if (!tree || tree->IsZombie())
+        {
+            file->Close();
+            delete file;
+            file = NULL;
+            tree = NULL;
+            return "File from TChain has an invalid TTree or is corrupt: " + file_name;
+        }
+        return "";
+    }
+
+    // open the file and get its tree, retrying as the fault policy says
+    std::string OpenFileAndTree
+    (
+        const std::string& file_name,
+        const std::string& tree_name,
+        TFile*& file,
+        TTree*& tree,
+        unsigned int& num_attempts,
+        std::mutex* const root_mutex
+    )
+    {
+        const unsigned int max_attempts = 1 + (file_fault_policy_ == FileFaultPolicy::RETRY ? file_fault_retries_ : 0);
+        double backoff = file_fault_backoff_;
+        std::string error;
+        for (num_attempts = 1; ; ++num_attempts)
+        {
+            if (root_mutex)
+            {
+                std::lock_guard<std::mutex> lock(*root_mutex);
+                error = TryOpenFileAndTree(file_name, tree_name, file, tree);
+            }
+            else
+            {
+                error = TryOpenFileAndTree(file_name, tree_name, file, tree);
+            }
+            if (error.empty() || num_attempts >= max_attempts)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(backoff));
+            backoff *= 2.0;
+        }
+        return error;
+    }
+
+    // The files a job gave up on.
+    BadFileReport::BadFileReport()
+    {
+    }
+
+    void BadFileReport::Add(const std::string& file_name, const long long lost_entries, const unsigned int attempts, const std::string& error)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i != m_bad_files.size(); ++i)
+        {
+            if (m_bad_files[i].file_name == file_name)
+            {
+                long long& lost = m_bad_files[i].lost_entries;
+                lost = (lost < 0 || lost_entries < 0 ? -1 : lost + lost_entries);
+                return;
+            }
+        }
+        const BadFile bad_file = {file_name, lost_entries, attempts, error};
+        m_bad_files.push_back(bad_file);
+    }
+
+    bool BadFileReport::Contains(const std::string& file_name) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i != m_bad_files.size(); ++i)
+        {
+            if (m_bad_files[i].file_name == file_name) {return true;}
+        }
+        return false;
+    }
+
+    size_t BadFileReport::Size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bad_files.size();
+    }
+
+    long long BadFileReport::LostEntries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        long long result = 0;
+        for (size_t i = 0; i != m_bad_files.size(); ++i)
+        {
+            if (m_bad_files[i].lost_entries > 0) {result += m_bad_files[i].lost_entries;}
+        }
+        return result;
+    }
+
+    size_t BadFileReport::NumUnknownEntries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t result = 0;
+        for (size_t i = 0; i != m_bad_files.size(); ++i)
+        {
+            if (m_bad_files[i].lost_entries < 0) {++result;}
+        }
+        return result;
+    }
+
+    std::vector<BadFileReport::BadFile> BadFileReport::GetBadFiles() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bad_files;
+    }
+
+    void BadFileReport::Print(std::ostream& out) const
+    {
+        const std::vector<BadFile> bad_files = GetBadFiles();
+        for (size_t i = 0; i != bad_files.size(); ++i)
+        {
+            out << "skipped " << bad_files[i].file_name << " (";
+            if (bad_files[i].lost_entries < 0) {out << "unknown number of";}
+            else                               {out << bad_files[i].lost_entries;}
+            out << " entries, " << bad_files[i].attempts << " attempts): " << bad_files[i].error << "\n";
+        }
+        out.flush();
+    }
+
+    void BadFileReport::Write(const std::string& file_name) const
+    {
+        std::ofstream out(file_name.c_str());
+        if (!out)
+        {
+            throw std::runtime_error("[at::BadFileReport::Write] Error: cannot open " + file_name);
+        }
+        const std::vector<BadFile> bad_files = GetBadFiles();
+        out << "# at::BadFileReport: <file name> <lost entries (-1 --> unknown)> <attempts> <error>\n";
+        for (size_t i = 0; i != bad_files.size(); ++i)
+        {
+            out << bad_files[i].file_name << " " << bad_files[i].lost_entries << " " << bad_files[i].attempts << " " << bad_files[i].error << "\n";
+        }
+        if (!out)
+        {
+            throw std::runtime_error("[at::BadFileReport::Write] Error: failed writing " + file_name);
+        }
+    }
+
+    void BadFileReport::Read(const std::string& file_name)
+    {
+        std::ifstream in(file_name.c_str());
+        if (!in)
+        {
+            throw std::runtime_error("[at::BadFileReport::Read] Error: cannot open " + file_name);
+        }
+        std::vector<BadFile> bad_files;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream line_stream(line);
+            BadFile bad_file = {"", 0, 0, ""};
+            if (!(line_stream >> bad_file.file_name >> bad_file.lost_entries >> bad_file.attempts))
+            {
+                throw std::runtime_error("[at::BadFileReport::Read] Error: bad line in " + file_name + ": " + line);
+            }
+            std::getline(line_stream >> std::ws, bad_file.error);
+            bad_files.push_back(bad_file);
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bad_files.swap(bad_files);
+    }
+
+    // the entries of a bad file that the chain could not count
+    long long GetBadFileEntries(const std::string& file_name)
+    {
+        const LumiIndex* const lumi_index = get_lumi_index();
+        if (lumi_index && lumi_index->Contains(file_name))
+        {
+            return lumi_index->GetEntries(file_name);
+        }
+        const EventIndex* const event_index = get_event_index();
+        if (event_index && event_index->Contains(file_name))
+        {
+            return event_index->GetEntries(file_name);
+        }
+        return -1;
+    }
+
+    // where the ScanChain functions write the list of the files they skipped
+    static std::string bad_file_report_;
+
+    void set_bad_file_report(const std::string& file_name)
+    {
+        bad_file_report_ = file_name;
+    }
+
+    const std::string& get_bad_file_report()
+    {
+        return bad_file_report_;
+    }
+
+} // namespace at
@@ -0,0 +1,229 @@
+#include "AnalysisTools/CMS2Tools/interface/FilePrefetcher.h"
+
+// c++
+#include <stdexcept>
+#include <chrono>
+
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TTreeCache.h"
+#include "TObjArray.h"
+
+// tools
+#include "AnalysisTools/CMS2Tools/interface/TreeCacheSizing.h"
+#include "AnalysisTools/CMS2Tools/interface/FileFaultPolicy.h"
+
+namespace at
+{
+    FilePrefetcher::FilePrefetcher
+    (
+        const std::vector<std::string>& file_names, 
+        const std::string& tree_name, 
+        const std::vector<bool>& use_caches,
+        const size_t depth
+    )
+        : m_file_names(file_names)
+        , m_tree_name(tree_name)
+        , m_use_caches(use_caches)
+        , m_depth(depth)
+        , m_files(file_names.size())
+        , m_errors(file_names.size())
+        , m_ready(file_names.size(), false)
+        , m_next_open(0)
+        , m_next_taken(0)
+        , m_branch_names()
+        , m_stop(false)
+        , m_wait_time(0.0)
+    {
+        if (m_use_caches.size() != m_file_names.size())
+        {
+            throw std::invalid_argument("[at::FilePrefetcher] Error: need one cache flag per file");
+        }
+        if (m_depth > 0 && !m_file_names.empty())
+        {
+            m_thread = std::thread(&FilePrefetcher::OpenAhead, this);
+        }
+    }
+
+    FilePrefetcher::~FilePrefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_taken.notify_all();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        // the files opened ahead that were never taken
+        for (size_t index = m_next_taken; index < m_files.size(); ++index)
+        {
+            if (m_ready[index] && m_files[index].file)
+            {
+                Close(m_files[index]);
+            }
+        }
+    }
+
+    void FilePrefetcher::OpenAhead()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_taken.wait(lock, [this] {return m_stop || (m_next_open < m_file_names.size() && m_next_open < m_next_taken + m_depth);});
+            if (m_stop)
+            {
+                break;
+            }
+            const size_t index = m_next_open++;
+            const std::vector<std::string> branch_names = m_branch_names;
+            lock.unlock();
+
+            std::string error;
+            const PrefetchedFile prefetched_file = Open(index, branch_names, error);
+
+            lock.lock();
+            m_files[index]  = prefetched_file;
+            m_errors[index] = error;
+            m_ready[index]  = true;
+            m_opened.notify_all();
+        }
+    }
+
+    FilePrefetcher::PrefetchedFile FilePrefetcher::Open(const size_t index, const std::vector<std::string>& branch_names, std::string& error)
+    {
+        PrefetchedFile result = {m_file_names.at(index), NULL, NULL, false, 0};
+        const bool use_cache = m_use_caches.at(index);
+
+        // (retried if the fault policy says so; the lock is not held while waiting)
+        unsigned int num_attempts = 0;
+        error = OpenFileAndTree(result.file_name, m_tree_name, result.file, result.tree, num_attempts, &m_root_mutex);
+        if (!error.empty())
+        {
+            return result;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_root_mutex);
+            if (use_cache)
+            {
+                result.cache_size = SetTreeCache(*result.tree, branch_names);
+                for (size_t i = 0; i != branch_names.size(); ++i)
+                {
+                    result.tree->AddBranchToCache(branch_names[i].c_str(), /*subbranches=*/true);
+                }
+                if (!branch_names.empty())
+                {
+                    result.tree->StopCacheLearningPhase();
+                }
+                result.cache_ready = true;
+            }
+        }
+
+        // read the first cluster of the known branches now
+        if (result.cache_ready && !branch_names.empty() && result.tree->GetEntriesFast() > 0)
+        {
+            result.tree->LoadTree(0);
+            TTreeCache* const cache = dynamic_cast<TTreeCache*>(result.file->GetCacheRead(result.tree));
+            if (cache)
+            {
+                cache->FillBuffer();
+            }
+        }
+        return result;
+    }
+
+    FilePrefetcher::PrefetchedFile FilePrefetcher::Next()
+    {
+        if (m_next_taken >= m_file_names.size())
+        {
+            throw std::out_of_range("[at::FilePrefetcher] Error: no files left");
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        PrefetchedFile result;
+        std::string error;
+        if (m_depth == 0)
+        {
+            result = Open(m_next_taken++, m_branch_names, error);
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const size_t index = m_next_taken;
+            m_opened.wait(lock, [this, index] {return static_cast<bool>(m_ready[index]);});
+            result = m_files[index];
+            error  = m_errors[index];
+            m_files[index].file = NULL;
+            m_files[index].tree = NULL;
+            m_files[index].cache_size = 0;
+            ++m_next_taken;
+        }
+        m_taken.notify_all();
+
+        m_wait_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!error.empty())
+        {
+            throw std::runtime_error(error);
+        }
+        return result;
+    }
+
+    void FilePrefetcher::Close(PrefetchedFile& prefetched_file)
+    {
+        if (prefetched_file.file)
+        {
+            std::lock_guard<std::mutex> lock(m_root_mutex);
+            prefetched_file.file->Close();
+            delete prefetched_file.file;
+        }
+        ReleaseTreeCache(prefetched_file.cache_size);
+        prefetched_file.file       = NULL;
+        prefetched_file.tree       = NULL;
+        prefetched_file.cache_size = 0;
+    }
+
+    void FilePrefetcher::SetCachedBranches(const std::vector<std::string>& branch_names)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_branch_names = branch_names;
+    }
+
+    std::vector<std::string> FilePrefetcher::GetCachedBranches(TFile& file, TTree& tree)
+    {
+        std::vector<std::string> result;
+        TTreeCache* const cache = dynamic_cast<TTreeCache*>(file.GetCacheRead(&tree));
+        if (!cache || cache->IsLearning())
+        {
+            return result;
+        }
+        const TObjArray* const branches = cache->GetCachedBranches();
+        for (int i = 0; branches && i < branches->GetEntries(); ++i)
+        {
+            result.push_back(branches->At(i)->GetName());
+        }
+        return result;
+    }
+
+    double FilePrefetcher::WaitTime() const
+    {
+        return m_wait_time;
+    }
+
+    // number of files the ScanChain functions open ahead
+    static size_t file_prefetch_depth_ = 1;
+
+    void set_file_prefetch_depth(const size_t depth)
+    {
+        file_prefetch_depth_ = depth;
+    }
+
+    size_t get_file_prefetch_depth()
+    {
+        return file_prefetch_depth_;
+    }
+
+} // namespace at
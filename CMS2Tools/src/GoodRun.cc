@@ -5,285 +5,116 @@
 
 #ifndef __CINT__
 
+#include "AnalysisTools/CMS2Tools/interface/GoodRunList.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdexcept>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <sys/stat.h>
-#include <set>
-#include <string>
-
-enum file_type { TEXT, JSON };
-
-struct run_and_lumi {
-     unsigned int run;
-     long long int lumi_min;
-     long long int lumi_max;
-};
-
-bool operator < (const struct run_and_lumi &r1, const struct run_and_lumi &r2)
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+// the free functions are thin wrappers around a default at::GoodRunList.
+// Loading a new list publishes a new immutable object; the old lists are kept
+// alive (they are small) so a thread still reading one is never left dangling.
+static const at::GoodRunList empty_good_runs_;
+static std::atomic<const at::GoodRunList*> good_runs_(&empty_good_runs_);
+static std::atomic<bool> good_runs_loaded_(false);
+static std::vector<std::unique_ptr<const at::GoodRunList> > loaded_good_runs_;
+static std::mutex load_mutex_;
+
+static bool load_runs (const char *fname, at::GoodRunFileType::value_type type)
 {
-     return r1.run < r2.run;
+     std::lock_guard<std::mutex> lock(load_mutex_);
+     try {
+          loaded_good_runs_.emplace_back(new at::GoodRunList(fname, type));
+     } catch (std::exception &e) {
+          fprintf(stderr, "%s\n", e.what());
+          return false;
+     }
+     good_runs_.store(loaded_good_runs_.back().get());
+     good_runs_loaded_ = true;
+     return true;
 }
 
-typedef std::multiset<struct run_and_lumi> set_t; 
-static set_t good_runs_;
-static bool good_runs_loaded_ = false;
-
-static const char json_py[] =
-"#! /usr/bin/env python                                                                                       \n"
-"                                                                                                             \n"
-"# usage to print out good run selection for goodrun.cc:                                                      \n"
-"# convertGoodRunsList_JSON.py <json file>                                                                    \n"
-"                                                                                                             \n"
-"import sys,json                                                                                              \n"
-"                                                                                                             \n"
-"runs = json.load(open(sys.argv[1],\"r\"))                                                                    \n"
-"                                                                                                             \n"
-"for run in runs.keys():                                                                                      \n"
-"    for lumiBlock in runs[run] :                                                                             \n"
-"        if len(lumiBlock) != 2 :                                                                             \n"
-"            print 'ERROR reading lumi block: run:',run,'lumiBlock:',lumiBlock                                \n"
-"        else:                                                                                                \n"
-"            # print 'run ' + str(run) + ', min lumi ' + str(lumiBlock[0]) + ', max lumi ' + str(lumiBlock[1])\n"
-"            print run,lumiBlock[0],lumiBlock[1]                                                              \n"
-     "                                                                                                        \n";
-
-static int load_runs (const char *fname, enum file_type type)
+// load the list on first use if nobody set one
+static void load_runs_once (const char *fname, at::GoodRunFileType::value_type type)
 {
-     good_runs_.clear();
-     FILE *file = 0;
-     switch (type) { 
-     case TEXT:
-          file = fopen(fname, "r");
-          if (file == 0) {
-               perror("opening good run list");
-               return 0;
-          }
-          break;
-     case JSON:
+     if (good_runs_loaded_)
+          return;
      {
-          // first make a temp file with the python parsing code
-          FILE *pyfile = fopen("tmp.py", "w");
-          if (pyfile == 0) {
-               perror("opening tmp file");
-               return 0;
-          }
-          fprintf(pyfile, "%s", json_py);
-          fclose(pyfile);
-          chmod("tmp.py", S_IRUSR | S_IWUSR | S_IXUSR);
-          // now execute a command to convert the JSON file to text
-          pid_t child = fork();
-          if (child == -1) {
-               perror("forking process to convert JSON good run list");
-               return 0;
-          }
-          if (child == 0) {
-               FILE *f = freopen((std::string(fname) + ".tmp").c_str(), "w", stdout);
-               if (f == 0) {
-                    perror("opening good run list");
-                    return 127;
-               }
-               execlp("./tmp.py", "", fname, (char *)0);
-               perror("executing JSON conversion script");
-               exit(127);
-          }
-          if (child != 0) {
-               int status;
-               waitpid(child, &status, 0);
-               if (status != 0) {
-                    printf("conversion exited abnormally, consult previous errors\n");
-                    return 0;
-               }
-          }
-          printf("note: converted JSON file is in %s.tmp, "
-                 "please consult in case of parsing errors\n", fname);
-          file = fopen((std::string(fname) + ".tmp").c_str(), "r");
-          if (file == 0) {
-               perror("opening good run list");
-               return 0;
-          }
-          unlink("tmp.py");
-          break;
-     }
-     default:
-          break;
+          std::lock_guard<std::mutex> lock(load_mutex_);
+          if (good_runs_loaded_)
+               return;
      }
-     int s;
-     int line = 0;
-     do {
-          int n;
-          char buf[1024] = "";
-          // read a line from the file, not including the newline (if
-          // there is a newline)
-          s = fscanf(file, "%1024[^\n]%n", buf, &n);
-          assert(n < 1023);
-          if (s != 1) {
-               if (s != EOF) {
-                    perror("reading good run list");
-                    return 0;
-               } else {
-                    if (ferror(file)) {
-                         perror("reading good run list");
-                         return 0;
-                    }
-               }
-          } else if (strlen(buf) != 0 && buf[0] == '#') {
-               line++;
-               // printf("Read a comment line (line %d) from the good run list: %s\n", line, buf);
-          } else {
-               line++;
-               // printf("Read a line from the good run list: %s\n", buf);
-               unsigned int run;
-               char *pbuf = buf;
-                   s = sscanf(pbuf, " %u%n", &run, &n);
-               if (s != 1) {
-                    fprintf(stderr, "Expected a run number (unsigned int)"
-                            " in the first position of line %d: %s\n", line, buf);
-                    assert(s == 1);
-               }
-               pbuf += n;
-               long long int lumi_min = -1;
-               long long int lumi_max = -1;
-               s = sscanf(pbuf, " %lld%n", &lumi_min, &n);
-               // if there is no lumi_min specified, that means the
-               // entire run is good
-               if (s == 1) {
-                    pbuf += n;
-                    s = sscanf(pbuf, " %lld%n", &lumi_max, &n);
-                    if (s != 1) {
-                         fprintf(stderr, "Expected a max lumi section in a lumi section range"
-                                 " (int) in the third position of line %d: %s\n", line, buf);
-                         assert(s == 1);
-                    }
-                    pbuf += n;
-               }
-               char trail[1024] = "";
-               s = sscanf(pbuf, " %s", trail);
-               if (strlen(trail) != 0) {
-                    fprintf(stderr, "Unexpected trailing junk (%s) on line %d: %s\n", trail, line, buf);
-                    assert(s == 0);
-               }
-               // printf("Read line: run %u, min lumi %lld, max lumi %lld\n", run, lumi_min, lumi_max);
-               struct run_and_lumi new_entry = { run, lumi_min, lumi_max };
-               good_runs_.insert(new_entry);
-          }
-          // advance past the newline
-          char newlines[1024] = "";
-          s = fscanf(file, "%[ \f\n\r\t\v]", newlines); 
-          if (s != -1 && strlen(newlines) != 1) {
-                fprintf(stderr, "Warning: unexpected white space following line %d\n", line);
-                // but that's just a warning
-          } 
-     } while (s == 1);
-     fclose(file);
-     if (type == JSON)
-          unlink((std::string(fname) + ".tmp").c_str());
-     return line;
+     bool loaded = load_runs(fname, type);
+     assert(loaded);
+     (void)loaded;
 }
 
-bool goodrun (unsigned int run, unsigned int lumi_block)
+namespace at
 {
-    if (not good_runs_loaded_) {
-        bool loaded = (load_runs("goodruns.json", TEXT) == 0);
-        assert(!loaded);
-        good_runs_loaded_ = loaded;
-    }
-    // we assume that an empty list means accept anything
-    if (good_runs_.size() == 0)
+    const GoodRunList& GetDefaultGoodRunList()
     {
-        return true;
-    }
-    // find all blocks with this run number
-    struct run_and_lumi r_a_l = { run, 0, 0 };
-    std::pair<set_t::const_iterator, set_t::const_iterator> good_blocks = 
-        good_runs_.equal_range(r_a_l);
-    for (set_t::const_iterator i = good_blocks.first; 
-            i != good_blocks.second; ++i) {
-        //        printf("considering run %u, min %lld, max %lld\n",
-        //               i->run, i->lumi_min, i->lumi_max);
-        if (i->lumi_min <= lumi_block) {
-            if (i->lumi_max == -1 || i->lumi_max >= lumi_block)
-                return true;
-        }
+        return *good_runs_.load();
     }
-    return false;
+}
+
+bool goodrun (unsigned int run, unsigned int lumi_block)
+{
+     load_runs_once("goodruns.json", at::GoodRunFileType::TEXT);
+     return good_runs_.load()->Contains(run, lumi_block);
 }
 
 int min_run ()
 {
      if (not good_runs_loaded_)
           return -1;
-     set_t::const_iterator first = good_runs_.begin();
-     if (first != good_runs_.end())
-          return first->run;
-     return -1;
+     return good_runs_.load()->MinRun();
 }
 
 int max_run ()
 {
      if (not good_runs_loaded_)
           return -1;
-     set_t::const_iterator last = good_runs_.end();
-     if (last != good_runs_.begin()) {
-          last--;
-          return last->run;
-     }
-     return -1;
+     return good_runs_.load()->MaxRun();
 }
 
 bool goodrun_json (unsigned int run, unsigned int lumi_block)
 {
-    if (not good_runs_loaded_) {
-        bool loaded = (load_runs("goodruns.json", JSON) == 0);
-        assert(!loaded);
-        good_runs_loaded_ = loaded;
-    }
-    // once the JSON good-run list is loaded, there's no difference
-    // between TEXT and JSON
-    return goodrun(run, lumi_block);
+     load_runs_once("goodruns.json", at::GoodRunFileType::JSON);
+     // once the JSON good-run list is loaded, there's no difference
+     // between TEXT and JSON
+     return goodrun(run, lumi_block);
 }
 
 void set_goodrun_file (const char* filename)
 {
-    bool loaded = (load_runs(filename, TEXT) == 0);
-    assert(!loaded);
-    good_runs_loaded_ = !loaded;
+     bool loaded = load_runs(filename, at::GoodRunFileType::TEXT);
+     assert(loaded);
+     (void)loaded;
 }
 
 void set_goodrun_file_json (const char* filename)
 {
-    bool loaded = (load_runs(filename, JSON) == 0);
-    assert(!loaded);
-    good_runs_loaded_ = !loaded;
+     bool loaded = load_runs(filename, at::GoodRunFileType::JSON);
+     assert(loaded);
+     (void)loaded;
 }
 
 int min_run_min_lumi ()
 {
      if (not good_runs_loaded_)
-      return -1;
-     set_t::const_iterator first = good_runs_.begin();
-     if (first != good_runs_.end())
-      return first->lumi_min;
-     return -1;
+          return -1;
+     return good_runs_.load()->MinRunMinLumi();
 }
 
 int max_run_max_lumi ()
 {
      if (not good_runs_loaded_)
-      return -1;
-     set_t::const_iterator last = good_runs_.end();
-     if (last != good_runs_.begin()) {
-      last--;
-      return last->lumi_max;
-     }
-     return -1;
+          return -1;
+     return good_runs_.load()->MaxRunMaxLumi();
 }
 
 #endif // __CUNT__
 
-
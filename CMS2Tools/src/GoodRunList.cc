@@ -0,0 +1,370 @@
+// CINT is allowed to see this, but nothing else:
+#include "AnalysisTools/CMS2Tools/interface/GoodRunList.h"
+
+#ifndef __CINT__
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+
+struct run_and_lumi {
+     unsigned int run;
+     long long int lumi_min;
+     long long int lumi_max;
+};
+
+static bool operator < (const struct run_and_lumi &r1, const struct run_and_lumi &r2)
+{
+     return r1.run < r2.run;
+}
+
+// minimal streaming parser for the certification JSON format:
+// {"run": [[lumi_min, lumi_max], [lumi_min, lumi_max], ...], "run": [...], ...}
+// reads the file one character at a time and keeps no state outside of the arguments
+
+// next character that is not white space (EOF at the end)
+static int json_next (FILE *file)
+{
+     int c = getc(file);
+     while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v')
+          c = getc(file);
+     return c;
+}
+
+static int json_peek (FILE *file)
+{
+     const int c = json_next(file);
+     if (c != EOF)
+          ungetc(c, file);
+     return c;
+}
+
+static bool json_expect (FILE *file, int expected)
+{
+     return json_next(file) == expected;
+}
+
+// an unsigned integer (optionally in quotes, as the run numbers are)
+static bool json_uint (FILE *file, long long int &value)
+{
+     int c = json_next(file);
+     const bool quoted = (c == '"');
+     if (quoted)
+          c = getc(file);
+     if (c < '0' || c > '9')
+          return false;
+     value = 0;
+     while (c >= '0' && c <= '9') {
+          value = 10 * value + (c - '0');
+          if (value > 0xFFFFFFFFll)
+               return false;
+          c = getc(file);
+     }
+     if (quoted)
+          return c == '"';
+     if (c != EOF)
+          ungetc(c, file);
+     return true;
+}
+
+// parse the JSON into ranges (returns false on a syntax error)
+static bool parse_json_runs (FILE *file, std::vector<struct run_and_lumi> &ranges)
+{
+     if (not json_expect(file, '{'))
+          return false;
+     if (json_peek(file) == '}')
+          return json_expect(file, '}');
+     for (;;) {
+          long long int run = 0;
+          if (not json_uint(file, run) || not json_expect(file, ':') || not json_expect(file, '['))
+               return false;
+          if (json_peek(file) == ']') {
+               json_next(file);
+          } else {
+               for (;;) {
+                    long long int lumi_min = 0;
+                    long long int lumi_max = 0;
+                    if (not json_expect(file, '[') || not json_uint(file, lumi_min) || not json_expect(file, ',') 
+                        || not json_uint(file, lumi_max) || not json_expect(file, ']')) {
+                         fprintf(stderr, "ERROR reading lumi block: run: %lld (expected [min, max])\n", run);
+                         return false;
+                    }
+                    struct run_and_lumi new_entry = { static_cast<unsigned int>(run), lumi_min, lumi_max };
+                    ranges.push_back(new_entry);
+                    const int c = json_next(file);
+                    if (c == ']')
+                         break;
+                    if (c != ',')
+                         return false;
+               }
+          }
+          const int c = json_next(file);
+          if (c == '}')
+               break;
+          if (c != ',')
+               return false;
+     }
+     return json_peek(file) == EOF;
+}
+
+// read the text list into ranges (returns the number of lines read, 0 on failure)
+static int read_text_runs (const char *fname, std::vector<struct run_and_lumi> &ranges)
+{
+     FILE *file = fopen(fname, "r");
+     if (file == 0) {
+          perror("opening good run list");
+          return 0;
+     }
+     int s;
+     int line = 0;
+     do {
+          int n;
+          char buf[1024] = "";
+          // read a line from the file, not including the newline (if
+          // there is a newline)
+          s = fscanf(file, "%1024[^\n]%n", buf, &n);
+          assert(n < 1023);
+          if (s != 1) {
+               if (s != EOF) {
+                    perror("reading good run list");
+                    fclose(file);
+                    return 0;
+               } else {
+                    if (ferror(file)) {
+                         perror("reading good run list");
+                         fclose(file);
+                         return 0;
+                    }
+               }
+          } else if (strlen(buf) != 0 && buf[0] == '#') {
+               line++;
+               // printf("Read a comment line (line %d) from the good run list: %s\n", line, buf);
+          } else {
+               line++;
+               // printf("Read a line from the good run list: %s\n", buf);
+               unsigned int run;
+               char *pbuf = buf;
+               s = sscanf(pbuf, " %u%n", &run, &n);
+               if (s != 1) {
+                    fprintf(stderr, "Expected a run number (unsigned int)"
+                            " in the first position of line %d: %s\n", line, buf);
+                    fclose(file);
+                    return 0;
+               }
+               pbuf += n;
+               long long int lumi_min = -1;
+               long long int lumi_max = -1;
+               s = sscanf(pbuf, " %lld%n", &lumi_min, &n);
+               // if there is no lumi_min specified, that means the
+               // entire run is good
+               if (s == 1) {
+                    pbuf += n;
+                    s = sscanf(pbuf, " %lld%n", &lumi_max, &n);
+                    if (s != 1) {
+                         fprintf(stderr, "Expected a max lumi section in a lumi section range"
+                                 " (int) in the third position of line %d: %s\n", line, buf);
+                         fclose(file);
+                         return 0;
+                    }
+                    pbuf += n;
+               }
+               char trail[1024] = "";
+               s = sscanf(pbuf, " %s", trail);
+               if (strlen(trail) != 0) {
+                    fprintf(stderr, "Unexpected trailing junk (%s) on line %d: %s\n", trail, line, buf);
+                    fclose(file);
+                    return 0;
+               }
+               // printf("Read line: run %u, min lumi %lld, max lumi %lld\n", run, lumi_min, lumi_max);
+               struct run_and_lumi new_entry = { run, lumi_min, lumi_max };
+               ranges.push_back(new_entry);
+          }
+          // advance past the newline
+          char newlines[1024] = "";
+          s = fscanf(file, "%[ \f\n\r\t\v]", newlines); 
+          if (s != -1 && strlen(newlines) != 1) {
+                fprintf(stderr, "Warning: unexpected white space following line %d\n", line);
+                // but that's just a warning
+          } 
+     } while (s == 1);
+     fclose(file);
+     return line;
+}
+
+// read the JSON list into ranges (returns the number of ranges read, 0 on failure)
+static int read_json_runs (const char *fname, std::vector<struct run_and_lumi> &ranges)
+{
+     FILE *file = fopen(fname, "r");
+     if (file == 0) {
+          perror("opening good run list");
+          return 0;
+     }
+     const bool parsed = parse_json_runs(file, ranges);
+     const bool failed = ferror(file);
+     fclose(file);
+     if (failed) {
+          perror("reading good run list");
+          return 0;
+     }
+     if (not parsed) {
+          fprintf(stderr, "Error parsing JSON good run list %s\n", fname);
+          return 0;
+     }
+     return ranges.size();
+}
+
+// consecutive events almost always share the lumi block so remember the last lookup.
+// The cache is per thread with a slot per list (by id) so that several lists 
+// used for the same events (e.g. muon and golden) don't evict each other.
+struct last_lookup {
+     unsigned long list_id;
+     unsigned int run;
+     unsigned int lumi_block;
+     bool result;
+};
+static const size_t num_lookup_slots = 4;
+static thread_local struct last_lookup last_lookup_[num_lookup_slots] = {};
+
+// ids start at 1 so that the zeroed cache matches no list
+static unsigned long next_list_id ()
+{
+     static std::atomic<unsigned long> next_id(1);
+     return next_id.fetch_add(1);
+}
+
+namespace at
+{
+    GoodRunList::GoodRunList()
+        : m_id(next_list_id())
+        , m_file_name()
+    {
+    }
+
+    GoodRunList::GoodRunList(const std::string& file_name, const GoodRunFileType::value_type file_type)
+        : m_id(next_list_id())
+        , m_file_name(file_name)
+    {
+        std::vector<struct run_and_lumi> ranges;
+        int num_read = 0;
+        switch (file_type)
+        {
+            case GoodRunFileType::TEXT: num_read = read_text_runs(file_name.c_str(), ranges); break;
+            case GoodRunFileType::JSON: num_read = read_json_runs(file_name.c_str(), ranges); break;
+            default: throw std::invalid_argument("[at::GoodRunList] Error: unknown file type");
+        }
+        if (num_read == 0)
+        {
+            throw std::runtime_error("[at::GoodRunList] Error: unable to read good run list " + file_name);
+        }
+
+        // build the index (ranges of a run keep the order they were read in)
+        std::stable_sort(ranges.begin(), ranges.end());
+        m_lumi_min.reserve(ranges.size());
+        m_lumi_max.reserve(ranges.size());
+        for (size_t i = 0; i != ranges.size(); ++i)
+        {
+            if (m_runs.empty() || m_runs.back() != ranges[i].run)
+            {
+                m_runs.push_back(ranges[i].run);
+                m_offsets.push_back(i);
+            }
+            m_lumi_min.push_back(ranges[i].lumi_min);
+            m_lumi_max.push_back(ranges[i].lumi_max);
+        }
+        m_offsets.push_back(ranges.size());
+    }
+
+    static GoodRunFileType::value_type FileTypeFromName(const std::string& file_name)
+    {
+        const std::string ext = ".json";
+        const bool is_json = file_name.size() >= ext.size() && file_name.compare(file_name.size() - ext.size(), ext.size(), ext) == 0;
+        return (is_json ? GoodRunFileType::JSON : GoodRunFileType::TEXT);
+    }
+
+    GoodRunList::GoodRunList(const std::string& file_name)
+        : GoodRunList(file_name, FileTypeFromName(file_name))
+    {
+    }
+
+    // branchless binary search
+    size_t GoodRunList::FindRun(const unsigned int run) const
+    {
+        const unsigned int *base = m_runs.data();
+        size_t n = m_runs.size();
+        if (n == 0)
+        {
+            return 0;
+        }
+        while (n > 1)
+        {
+            const size_t half = n / 2;
+            base = (base[half] <= run) ? base + half : base;
+            n -= half;
+        }
+        return (*base == run) ? static_cast<size_t>(base - m_runs.data()) : m_runs.size();
+    }
+
+    bool GoodRunList::ContainsRun(const unsigned int run) const
+    {
+        return FindRun(run) != m_runs.size();
+    }
+
+    bool GoodRunList::Contains(const unsigned int run, const unsigned int lumi_block) const
+    {
+        // we assume that an empty list means accept anything
+        if (m_lumi_min.empty())
+        {
+            return true;
+        }
+
+        // same lumi block as last time?
+        struct last_lookup &last = last_lookup_[m_id % num_lookup_slots];
+        if (last.list_id == m_id && last.run == run && last.lumi_block == lumi_block)
+        {
+            return last.result;
+        }
+
+        // check the blocks with this run number
+        bool result = false;
+        const size_t i = FindRun(run);
+        if (i != m_runs.size())
+        {
+            const long long lumi = lumi_block;
+            for (unsigned int j = m_offsets[i]; j != m_offsets[i+1]; ++j)
+            {
+                result |= (m_lumi_min[j] <= lumi) & ((m_lumi_max[j] == -1) | (m_lumi_max[j] >= lumi));
+            }
+        }
+        last.list_id    = m_id;
+        last.run        = run;
+        last.lumi_block = lumi_block;
+        last.result     = result;
+        return result;
+    }
+
+    int GoodRunList::MinRun() const
+    {
+        return (m_runs.empty() ? -1 : static_cast<int>(m_runs.front()));
+    }
+
+    int GoodRunList::MaxRun() const
+    {
+        return (m_runs.empty() ? -1 : static_cast<int>(m_runs.back()));
+    }
+
+    int GoodRunList::MinRunMinLumi() const
+    {
+        return (m_lumi_min.empty() ? -1 : static_cast<int>(m_lumi_min.front()));
+    }
+
+    int GoodRunList::MaxRunMaxLumi() const
+    {
+        return (m_lumi_max.empty() ? -1 : static_cast<int>(m_lumi_max.back()));
+    }
+
+} // namespace at
+
+#endif // __CINT__
@@ -0,0 +1,330 @@
+#include "AnalysisTools/CMS2Tools/interface/LumiIndex.h"
+
+// c++
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <stdexcept>
+
+namespace at
+{
+    LumiIndex::LumiIndex()
+    {
+    }
+
+    LumiIndex::LumiIndex(const std::string& file_name)
+    {
+        Read(file_name);
+    }
+
+    void LumiIndex::Clear()
+    {
+        m_tree_name.clear();
+        m_file_names.clear();
+        m_file_entries.clear();
+        m_file_is_mc.clear();
+        m_blocks.clear();
+        m_file_map.clear();
+    }
+
+    void LumiIndex::BeginBuild(const std::string& tree_name)
+    {
+        Clear();
+        m_tree_name = tree_name;
+    }
+
+    void LumiIndex::AddFile(const std::string& file_name, const long long num_entries, const bool is_mc)
+    {
+        m_file_map[file_name] = m_file_names.size();
+        m_file_names.push_back(file_name);
+        m_file_entries.push_back(num_entries);
+        m_file_is_mc.push_back(is_mc);
+        m_blocks.push_back(std::vector<Block>());
+    }
+
+    // add an entry of the last file added
+    void LumiIndex::AddEntry(const unsigned int run, const unsigned int lumi, const long long entry)
+    {
+        if (m_file_names.empty() || m_file_is_mc.back())
+        {
+            throw std::runtime_error("[at::LumiIndex::AddEntry] Error: no data file to add the entry to");
+        }
+        AddBlock(m_file_names.size() - 1, run, lumi, entry);
+    }
+
+    // extend the last block of the file or start a new one
+    void LumiIndex::AddBlock(const size_t file_index, const unsigned int run, const unsigned int lumi, const long long entry)
+    {
+        std::vector<Block>& blocks = m_blocks.at(file_index);
+        if (not blocks.empty() && blocks.back().run == run && blocks.back().lumi == lumi && blocks.back().end == entry)
+        {
+            blocks.back().end = entry + 1;
+            return;
+        }
+        const Block block = {run, lumi, entry, entry + 1};
+        blocks.push_back(block);
+    }
+
+    // format:
+    // # comment
+    // tree <tree name>
+    // file <file index> <number of entries> <file name>
+    // mc <file index> (optional: the file is MC)
+    // block <file index> <run> <lumi> <first entry> <last entry + 1>
+    void LumiIndex::Write(const std::string& file_name) const
+    {
+        std::ofstream out(file_name.c_str());
+        if (!out)
+        {
+            throw std::runtime_error("[at::LumiIndex::Write] Error: cannot open " + file_name);
+        }
+        out << "# at::LumiIndex: (run, lumi) --> (file, entries)\n";
+        out << "tree " << m_tree_name << "\n";
+        for (size_t i = 0; i != m_file_names.size(); ++i)
+        {
+            out << "file " << i << " " << m_file_entries[i] << " " << m_file_names[i] << "\n";
+        }
+        for (size_t i = 0; i != m_file_is_mc.size(); ++i)
+        {
+            if (m_file_is_mc[i]) {out << "mc " << i << "\n";}
+        }
+        for (size_t i = 0; i != m_blocks.size(); ++i)
+        {
+            for (size_t j = 0; j != m_blocks[i].size(); ++j)
+            {
+                const Block& block = m_blocks[i][j];
+                out << "block " << i << " " << block.run << " " << block.lumi << " " << block.begin << " " << block.end << "\n";
+            }
+        }
+        if (!out)
+        {
+            throw std::runtime_error("[at::LumiIndex::Write] Error: failed writing " + file_name);
+        }
+    }
+
+    void LumiIndex::Read(const std::string& file_name)
+    {
+        std::ifstream in(file_name.c_str());
+        if (!in)
+        {
+            throw std::runtime_error("[at::LumiIndex::Read] Error: cannot open " + file_name);
+        }
+        Clear();
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(in, line))
+        {
+            ++line_number;
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream line_stream(line);
+            std::string key;
+            line_stream >> key;
+            if (key == "tree")
+            {
+                line_stream >> m_tree_name;
+            }
+            else if (key == "file")
+            {
+                size_t index        = 0;
+                long long entries   = 0;
+                std::string name;
+                if (!(line_stream >> index >> entries) || !std::getline(line_stream >> std::ws, name) || index != m_file_names.size())
+                {
+                    std::ostringstream msg; 
+                    msg << "[at::LumiIndex::Read] Error: bad file line " << line_number << " in " << file_name;
+                    throw std::runtime_error(msg.str());
+                }
+                m_file_map[name] = index;
+                m_file_names.push_back(name);
+                m_file_entries.push_back(entries);
+                m_file_is_mc.push_back(false);
+                m_blocks.push_back(std::vector<Block>());
+            }
+            else if (key == "mc")
+            {
+                size_t index = 0;
+                line_stream >> index;
+                if (line_stream.fail() || index >= m_file_is_mc.size())
+                {
+                    std::ostringstream msg; 
+                    msg << "[at::LumiIndex::Read] Error: bad mc line " << line_number << " in " << file_name;
+                    throw std::runtime_error(msg.str());
+                }
+                m_file_is_mc[index] = true;
+            }
+            else if (key == "block")
+            {
+                size_t index = 0;
+                Block block  = {0, 0, 0, 0};
+                line_stream >> index >> block.run >> block.lumi >> block.begin >> block.end;
+                if (line_stream.fail() || index >= m_blocks.size() || block.end < block.begin)
+                {
+                    std::ostringstream msg; 
+                    msg << "[at::LumiIndex::Read] Error: bad block line " << line_number << " in " << file_name;
+                    throw std::runtime_error(msg.str());
+                }
+                m_blocks[index].push_back(block);
+            }
+            else
+            {
+                std::ostringstream msg; 
+                msg << "[at::LumiIndex::Read] Error: unknown line " << line_number << " in " << file_name;
+                throw std::runtime_error(msg.str());
+            }
+        }
+    }
+
+    size_t LumiIndex::FileIndex(const std::string& file_name) const
+    {
+        std::map<std::string, size_t>::const_iterator iter = m_file_map.find(file_name);
+        if (iter == m_file_map.end())
+        {
+            throw std::runtime_error("[at::LumiIndex] Error: file not in the index: " + file_name);
+        }
+        return iter->second;
+    }
+
+    bool LumiIndex::Contains(const std::string& file_name) const
+    {
+        return m_file_map.find(file_name) != m_file_map.end();
+    }
+
+    long long LumiIndex::GetEntries(const std::string& file_name) const
+    {
+        return m_file_entries.at(FileIndex(file_name));
+    }
+
+    bool LumiIndex::IsMC(const std::string& file_name) const
+    {
+        return m_file_is_mc.at(FileIndex(file_name));
+    }
+
+    // entry ranges of the file owned by the partition (adjacent blocks are merged)
+    // (the partition is only for data: every shard reads all of an MC file)
+    std::vector<EntryRange> LumiIndex::GetRanges(const std::string& file_name, const size_t file_index, const RunLumiPartition& partition) const
+    {
+        const size_t index = FileIndex(file_name);
+        std::vector<EntryRange> result;
+        if (m_file_is_mc[index])
+        {
+            const EntryRange range = {file_index, 0, m_file_entries[index]};
+            if (range.end > 0) {result.push_back(range);}
+            return result;
+        }
+        const std::vector<Block>& blocks = m_blocks[index];
+        for (size_t i = 0; i != blocks.size(); ++i)
+        {
+            const Block& block = blocks[i];
+            if (not partition.Owns(block.run, block.lumi)) continue;
+            if (not result.empty() && result.back().end == block.begin)
+            {
+                result.back().end = block.end;
+            }
+            else
+            {
+                const EntryRange range = {file_index, block.begin, block.end};
+                result.push_back(range);
+            }
+        }
+        return result;
+    }
+
+    // same as above for every file in the list
+    std::vector<EntryRange> LumiIndex::GetRanges(const std::vector<std::string>& file_names, const RunLumiPartition& partition) const
+    {
+        std::vector<EntryRange> result;
+        for (size_t i = 0; i != file_names.size(); ++i)
+        {
+            const std::vector<EntryRange> ranges = GetRanges(file_names[i], i, partition);
+            result.insert(result.end(), ranges.begin(), ranges.end());
+        }
+        return result;
+    }
+
+    const std::vector<std::string>& LumiIndex::GetFileNames() const
+    {
+        return m_file_names;
+    }
+
+    const std::vector<LumiIndex::Block>& LumiIndex::GetBlocks(const std::string& file_name) const
+    {
+        return m_blocks.at(FileIndex(file_name));
+    }
+
+    // Walks the owned entries of one file in entry order.
+    OwnedEntryCursor::OwnedEntryCursor()
+        : m_ranges()
+        , m_num_entries(-1)
+        , m_current(0)
+    {
+    }
+
+    OwnedEntryCursor::OwnedEntryCursor(const std::vector<EntryRange>& ranges, const long long num_entries)
+        : m_ranges(ranges)
+        , m_num_entries(num_entries)
+        , m_current(0)
+    {
+    }
+
+    long long OwnedEntryCursor::NextOwned(const long long entry)
+    {
+        if (m_num_entries < 0)
+        {
+            return entry;
+        }
+        // entries usually only move forward; start over if they moved back
+        if (m_current != 0 && entry < m_ranges[m_current - 1].end)
+        {
+            m_current = 0;
+        }
+        while (m_current != m_ranges.size() && m_ranges[m_current].end <= entry)
+        {
+            ++m_current;
+        }
+        if (m_current == m_ranges.size())
+        {
+            return m_num_entries;
+        }
+        return (entry < m_ranges[m_current].begin ? m_ranges[m_current].begin : entry);
+    }
+
+    bool OwnedEntryCursor::Empty() const
+    {
+        return m_num_entries >= 0 && m_ranges.empty();
+    }
+
+    long long OwnedEntryCursor::NumEntries() const
+    {
+        return m_num_entries;
+    }
+
+    // the index used by the ScanChain functions
+    static std::unique_ptr<LumiIndex> lumi_index_;
+
+    void set_lumi_index_file(const std::string& file_name)
+    {
+        if (file_name.empty())
+        {
+            lumi_index_.reset();
+            return;
+        }
+        lumi_index_.reset(new LumiIndex(file_name));
+    }
+
+    const LumiIndex* get_lumi_index()
+    {
+        return lumi_index_.get();
+    }
+
+    // the entries of the file that the ScanChain functions read
+    OwnedEntryCursor GetOwnedEntries(const std::string& file_name)
+    {
+        const RunLumiPartition& partition = get_run_lumi_partition();
+        if (!lumi_index_ || partition.scheme == RunLumiPartition::Scheme::NONE || not lumi_index_->Contains(file_name))
+        {
+            return OwnedEntryCursor();
+        }
+        return OwnedEntryCursor(lumi_index_->GetRanges(file_name, 0, partition), lumi_index_->GetEntries(file_name));
+    }
+
+} // namespace at
@@ -0,0 +1,13 @@
+// tools
+#include "AnalysisTools/CMS2Tools/interface/EventIndex.h"
+
+namespace at
+{
+    // build the index from the chain (reads the run and lumi of every entry of the data files)
+    template <typename NtupleClass>
+    void LumiIndex::Build(TChain& chain, NtupleClass& ntuple_class, const bool verbose)
+    {
+        BuildIndexes(chain, ntuple_class, this, NULL, verbose);
+    }
+
+} // namespace at
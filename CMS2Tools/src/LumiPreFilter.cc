@@ -0,0 +1,40 @@
+#include "AnalysisTools/CMS2Tools/interface/LumiPreFilter.h"
+
+// c++
+#include <algorithm>
+
+// ROOT
+#include "TTree.h"
+
+namespace at
+{
+    // the ranges of the tree's clusters that have at least one entry not flagged as bad
+    // (adjacent good clusters are merged)
+    std::vector<EntryRange> GetGoodClusterRanges(TTree& tree, const std::vector<bool>& bad_entries)
+    {
+        std::vector<EntryRange> result;
+        const long long num_entries = std::min(tree.GetEntriesFast(), static_cast<long long>(bad_entries.size()));
+        TTree::TClusterIterator cluster_iter = tree.GetClusterIterator(0);
+        long long begin = 0;
+        while ((begin = cluster_iter.Next()) < num_entries)
+        {
+            const long long end = std::min(cluster_iter.GetNextEntry(), num_entries);
+            const bool all_bad = std::find(bad_entries.begin() + begin, bad_entries.begin() + end, false) == bad_entries.begin() + end;
+            if (all_bad)
+            {
+                continue;
+            }
+            if (!result.empty() && result.back().end == begin)
+            {
+                result.back().end = end;
+            }
+            else
+            {
+                const EntryRange range = {0, begin, end};
+                result.push_back(range);
+            }
+        }
+        return result;
+    }
+
+} // namespace at
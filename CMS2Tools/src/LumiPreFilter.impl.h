@@ -0,0 +1,102 @@
+// c++
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+// ROOT
+#include "TTree.h"
+
+namespace at
+{
+    namespace detail
+    {
+        // picked when GetEventIdEntry(ntuple_class, entry) is found (by ADL)
+        template <typename NtupleClass>
+        auto LoadEventIdImpl(NtupleClass& ntuple_class, const long entry, int) -> decltype(GetEventIdEntry(ntuple_class, entry), bool())
+        {
+            GetEventIdEntry(ntuple_class, entry);
+            return true;
+        }
+
+        template <typename NtupleClass>
+        bool LoadEventIdImpl(NtupleClass& ntuple_class, const long entry, long)
+        {
+            GetEntry(ntuple_class, entry);
+            return false;
+        }
+
+        template <typename NtupleClass>
+        auto HasEventIdEntryImpl(int) -> decltype(GetEventIdEntry(std::declval<NtupleClass&>(), 0L), std::true_type());
+
+        template <typename NtupleClass>
+        std::false_type HasEventIdEntryImpl(long);
+
+    } // namespace detail
+
+    template <typename NtupleClass>
+    struct HasEventIdEntry : decltype(detail::HasEventIdEntryImpl<NtupleClass>(0))
+    {
+    };
+
+    template <typename NtupleClass>
+    bool LoadEventId(NtupleClass& ntuple_class, const long entry)
+    {
+        return detail::LoadEventIdImpl(ntuple_class, entry, 0);
+    }
+
+    template <typename NtupleClass>
+    OwnedEntryCursor GetGoodLumiClusters
+    (
+        TTree& tree, 
+        NtupleClass& ntuple_class, 
+        const std::string& file_name, 
+        const GoodRunList& good_runs
+    )
+    {
+        const long long num_entries = tree.GetEntriesFast();
+        if (good_runs.Empty() || num_entries == 0)
+        {
+            return OwnedEntryCursor();
+        }
+
+        // a file is either all data or all MC 
+        const LumiIndex* const lumi_index = get_lumi_index();
+        const bool indexed = lumi_index && lumi_index->Contains(file_name);
+        if (not indexed && not HasEventIdEntry<NtupleClass>::value)
+        {
+            return OwnedEntryCursor();
+        }
+        LoadEventId(ntuple_class, 0);
+        if (not IsRealData(ntuple_class))
+        {
+            return OwnedEntryCursor();
+        }
+
+        // flag the entries of the bad (run, lumi)s
+        std::vector<bool> bad_entries(num_entries, false);
+        if (indexed)
+        {
+            const std::vector<LumiIndex::Block>& blocks = lumi_index->GetBlocks(file_name);
+            for (size_t i = 0; i != blocks.size(); ++i)
+            {
+                if (good_runs.Contains(blocks[i].run, blocks[i].lumi)) continue;
+                const long long end = std::min(blocks[i].end, num_entries);
+                for (long long entry = blocks[i].begin; entry < end; ++entry)
+                {
+                    bad_entries[entry] = true;
+                }
+            }
+        }
+        else
+        {
+            for (long long entry = 0; entry != num_entries; ++entry)
+            {
+                LoadEventId(ntuple_class, entry);
+                bad_entries[entry] = not good_runs.Contains(Run(ntuple_class), LumiBlock(ntuple_class));
+            }
+        }
+
+        return OwnedEntryCursor(GetGoodClusterRanges(tree, bad_entries), num_entries);
+    }
+
+} // namespace at
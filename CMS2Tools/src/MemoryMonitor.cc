@@ -0,0 +1,230 @@
+#include "AnalysisTools/CMS2Tools/interface/MemoryMonitor.h"
+#include "AnalysisTools/CMS2Tools/interface/TreeCacheSizing.h"
+#include "AnalysisTools/CMS2Tools/interface/DorkyEventIdentifier.h"
+
+// c++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// ROOT
+#include "TString.h"
+
+namespace at
+{
+    // resident memory of the process
+    long long GetPeakResidentMemory()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return usage.ru_maxrss * 1024LL;
+#endif
+    }
+
+    long long GetResidentMemory()
+    {
+        // "size resident shared ..." in pages
+        std::ifstream statm("/proc/self/statm");
+        long long size     = 0;
+        long long resident = 0;
+        if (statm >> size >> resident)
+        {
+            return resident * sysconf(_SC_PAGESIZE);
+        }
+        return GetPeakResidentMemory();
+    }
+
+    static double to_mb(const long long bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    // the clock in ticks
+    static long long now_ticks()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    MemoryMonitor::MemoryMonitor(const size_t num_slots, const double interval, const long long soft_limit)
+        : m_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::max(interval, 0.0))).count())
+        , m_soft_limit(soft_limit)
+        , m_tree_cache_budget(get_tree_cache_budget())
+        , m_next_time(now_ticks() + m_interval)
+        , m_analyzer_bytes(num_slots, 0)
+        , m_num_samples(0)
+        , m_num_shrinks(0)
+        , m_over_limit(false)
+        , m_peak_resident(0)
+    {
+        std::fill(m_peak, m_peak + MemoryComponent::static_size, 0);
+        std::fill(m_max , m_max  + MemoryComponent::static_size, 0);
+    }
+
+    // the reduced budget is only for this job
+    MemoryMonitor::~MemoryMonitor()
+    {
+        if (m_num_shrinks > 0)
+        {
+            set_tree_cache_budget(m_tree_cache_budget);
+        }
+    }
+
+    bool MemoryMonitor::Due() const
+    {
+        return now_ticks() >= m_next_time.load(std::memory_order_relaxed);
+    }
+
+    void MemoryMonitor::SetAnalyzerMemory(const size_t slot, const size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_analyzer_bytes.at(slot) = bytes;
+    }
+
+    bool MemoryMonitor::Sample()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_next_time = now_ticks() + m_interval;
+
+        long long sample[MemoryComponent::static_size];
+        sample[MemoryComponent::TREE_CACHE] = get_tree_cache_in_use();
+        sample[MemoryComponent::DUPLICATES] = get_duplicate_filter_memory_usage();
+        sample[MemoryComponent::ANALYZER  ] = 0;
+        for (size_t i = 0; i != m_analyzer_bytes.size(); ++i)
+        {
+            sample[MemoryComponent::ANALYZER] += m_analyzer_bytes[i];
+        }
+        const long long resident = GetResidentMemory();
+        const long long known    = sample[MemoryComponent::TREE_CACHE] + sample[MemoryComponent::DUPLICATES] + sample[MemoryComponent::ANALYZER];
+        sample[MemoryComponent::OTHER] = std::max(0LL, resident - known);
+
+        ++m_num_samples;
+        for (size_t i = 0; i != MemoryComponent::static_size; ++i)
+        {
+            m_max[i] = std::max(m_max[i], sample[i]);
+        }
+        if (resident >= m_peak_resident)
+        {
+            m_peak_resident = resident;
+            std::copy(sample, sample + MemoryComponent::static_size, m_peak);
+        }
+
+        // only act when the limit is crossed (not on every sample above it)
+        if (m_soft_limit <= 0 || resident <= m_soft_limit)
+        {
+            m_over_limit = false;
+            return false;
+        }
+        if (m_over_limit)
+        {
+            return false;
+        }
+        m_over_limit = true;
+        ++m_num_shrinks;
+
+        // (a worker thread may get here: Form is not thread safe)
+        const long long budget = get_tree_cache_budget() / 2;
+        set_tree_cache_budget(budget);
+        std::ostringstream message;
+        message << std::fixed << std::setprecision(1)
+            << "Warning: resident memory " << to_mb(resident) << " MB is over the soft limit of " << to_mb(m_soft_limit)
+            << " MB (tree cache " << to_mb(sample[MemoryComponent::TREE_CACHE])
+            << " MB, duplicates " << to_mb(sample[MemoryComponent::DUPLICATES])
+            << " MB, analyzer "   << to_mb(sample[MemoryComponent::ANALYZER  ])
+            << " MB) -- TTreeCache budget reduced to " << to_mb(budget) << " MB\n";
+        std::cout << message.str() << std::flush;
+        return true;
+    }
+
+    long MemoryMonitor::NumSamples() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_num_samples;
+    }
+
+    long long MemoryMonitor::PeakResident() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peak_resident;
+    }
+
+    long long MemoryMonitor::PeakComponent(const MemoryComponent::value_type component) const
+    {
+        if (component < 0 || component >= MemoryComponent::static_size)
+        {
+            throw std::invalid_argument("[at::MemoryMonitor::PeakComponent] Error: invalid component");
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peak[component];
+    }
+
+    unsigned int MemoryMonitor::NumShrinks() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_num_shrinks;
+    }
+
+    void MemoryMonitor::Print(std::ostream& out) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out << "resident memory (MB)  = " << Form("%.1f", to_mb(m_peak_resident)) << " peak of " << m_num_samples << " samples ("
+            << Form("%.1f", to_mb(GetPeakResidentMemory())) << " process peak)\n";
+        out << "  at the peak (MB)    = tree cache " << Form("%.1f", to_mb(m_peak[MemoryComponent::TREE_CACHE]))
+            << ", duplicates " << Form("%.1f", to_mb(m_peak[MemoryComponent::DUPLICATES]))
+            << ", analyzer "   << Form("%.1f", to_mb(m_peak[MemoryComponent::ANALYZER  ]))
+            << ", other "      << Form("%.1f", to_mb(m_peak[MemoryComponent::OTHER     ])) << "\n";
+        out << "  max (MB)            = tree cache " << Form("%.1f", to_mb(m_max[MemoryComponent::TREE_CACHE]))
+            << ", duplicates " << Form("%.1f", to_mb(m_max[MemoryComponent::DUPLICATES]))
+            << ", analyzer "   << Form("%.1f", to_mb(m_max[MemoryComponent::ANALYZER  ]))
+            << ", other "      << Form("%.1f", to_mb(m_max[MemoryComponent::OTHER     ])) << "\n";
+        if (m_soft_limit > 0)
+        {
+            out << "soft limit (MB)       = " << Form("%.1f", to_mb(m_soft_limit)) << " (crossed " << m_num_shrinks << " times)\n";
+        }
+        out.flush();
+    }
+
+    void MemoryMonitor::AppendReportValues(std::vector<std::pair<std::string, double> >& values) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        values.push_back(std::make_pair("rss_peak"      , static_cast<double>(m_peak_resident                     )));
+        values.push_back(std::make_pair("mem_tree_cache", static_cast<double>(m_peak[MemoryComponent::TREE_CACHE])));
+        values.push_back(std::make_pair("mem_duplicates", static_cast<double>(m_peak[MemoryComponent::DUPLICATES])));
+        values.push_back(std::make_pair("mem_analyzer"  , static_cast<double>(m_peak[MemoryComponent::ANALYZER  ])));
+        values.push_back(std::make_pair("mem_other"     , static_cast<double>(m_peak[MemoryComponent::OTHER     ])));
+        values.push_back(std::make_pair("mem_samples"   , static_cast<double>(m_num_samples                       )));
+        values.push_back(std::make_pair("mem_shrinks"   , static_cast<double>(m_num_shrinks                       )));
+    }
+
+    // memory sampling of the ScanChain functions
+    static double memory_monitor_interval_ = 60.0;
+    static long long memory_soft_limit_    = 0;
+
+    void set_memory_monitor(const double interval, const long long soft_limit)
+    {
+        memory_monitor_interval_ = interval;
+        memory_soft_limit_       = soft_limit;
+    }
+
+    double get_memory_monitor_interval()
+    {
+        return memory_monitor_interval_;
+    }
+
+    long long get_memory_soft_limit()
+    {
+        return memory_soft_limit_;
+    }
+
+} // namespace at
@@ -0,0 +1,44 @@
+// c++
+#include <type_traits>
+#include <utility>
+
+namespace at
+{
+    namespace detail
+    {
+        template <typename Analyzer>
+        auto HasMemoryUsageHookImpl(int) -> decltype
+        (
+            static_cast<size_t>(std::declval<const Analyzer&>().MemoryUsage()),
+            std::true_type()
+        );
+
+        template <typename Analyzer>
+        std::false_type HasMemoryUsageHookImpl(long);
+
+        template <typename Analyzer>
+        size_t AnalyzerMemoryUsage(const Analyzer& analyzer, std::true_type)
+        {
+            return analyzer.MemoryUsage();
+        }
+
+        template <typename Analyzer>
+        size_t AnalyzerMemoryUsage(const Analyzer&, std::false_type)
+        {
+            return 0;
+        }
+
+    } // namespace detail
+
+    template <typename Analyzer>
+    struct HasMemoryUsageHook : decltype(detail::HasMemoryUsageHookImpl<Analyzer>(0))
+    {
+    };
+
+    template <typename Analyzer>
+    size_t GetAnalyzerMemoryUsage(const Analyzer& analyzer)
+    {
+        return detail::AnalyzerMemoryUsage(analyzer, HasMemoryUsageHook<Analyzer>());
+    }
+
+} // namespace at
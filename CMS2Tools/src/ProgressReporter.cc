@@ -0,0 +1,136 @@
+#include "AnalysisTools/CMS2Tools/interface/ProgressReporter.h"
+
+// c++
+#include <cstdio>
+#include <unistd.h>
+
+// ROOT
+#include "TFile.h"
+
+namespace at
+{
+    ProgressReporter::ProgressReporter
+    (
+        const std::atomic<long>& num_events,
+        const long num_events_chain,
+        const std::string& name,
+        const ProgressMode::value_type mode,
+        const double interval
+    )
+        : m_num_events(num_events)
+        , m_num_events_chain(num_events_chain)
+        , m_name(name)
+        , m_mode(mode)
+        , m_interval(0)
+        , m_start(std::chrono::steady_clock::now())
+        , m_start_bytes(TFile::GetFileBytesRead())
+        , m_stop(false)
+    {
+        if (m_mode == ProgressMode::AUTO)
+        {
+            m_mode = (isatty(fileno(stdout)) ? ProgressMode::TERMINAL : ProgressMode::LOG);
+        }
+        m_interval = std::chrono::duration<double>(interval > 0 ? interval : (m_mode == ProgressMode::LOG ? 60.0 : 1.0));
+        if (m_mode != ProgressMode::NONE)
+        {
+            m_thread = std::thread(&ProgressReporter::Run, this);
+        }
+    }
+
+    ProgressReporter::~ProgressReporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) {m_thread.join();}
+    }
+
+    // print the last report and stop the thread
+    void ProgressReporter::Stop()
+    {
+        if (!m_thread.joinable()) {return;}
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+        Report();
+    }
+
+    void ProgressReporter::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (not m_wake.wait_for(lock, m_interval, [this] {return m_stop;}))
+        {
+            lock.unlock();
+            Report();
+            lock.lock();
+        }
+    }
+
+    void ProgressReporter::Report()
+    {
+        const long num_events = m_num_events.load(std::memory_order_relaxed);
+        const double elapsed  = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        const double mb_read  = (TFile::GetFileBytesRead() - m_start_bytes) / (1024.0 * 1024.0);
+        const double fraction = (m_num_events_chain > 0 ? num_events / static_cast<double>(m_num_events_chain) : 1.0);
+        const double rate     = (elapsed > 0 ? num_events / elapsed : 0.0);
+        const double mb_rate  = (elapsed > 0 ? mb_read / elapsed : 0.0);
+        const double eta      = (rate > 0 ? (m_num_events_chain - num_events) / rate : -1.0);
+
+        if (m_mode == ProgressMode::TERMINAL)
+        {
+            const long eta_seconds = (eta >= 0 ? static_cast<long>(eta + 0.5) : 0);
+            printf
+            (
+                "  \015\033[32m ---> \033[1m\033[31m%4.1f%%" "\033[0m\033[32m <---\033[0m  %.0f ev/s  %.1f MB/s  ETA %ld:%02ld:%02ld  \015",
+                100.0 * fraction,
+                rate,
+                mb_rate,
+                eta_seconds / 3600,
+                (eta_seconds / 60) % 60,
+                eta_seconds % 60
+            );
+        }
+        else
+        {
+            printf
+            (
+                "[%s] progress events=%ld total=%ld fraction=%.4f events_per_s=%.1f mb_per_s=%.2f elapsed_s=%.1f eta_s=%.1f\n",
+                m_name.c_str(),
+                num_events,
+                m_num_events_chain,
+                fraction,
+                rate,
+                mb_rate,
+                elapsed,
+                eta
+            );
+        }
+        fflush(stdout);
+    }
+
+    // the progress report of the ScanChain functions
+    static ProgressMode::value_type scan_progress_mode_ = ProgressMode::AUTO;
+    static double scan_progress_interval_              = -1.0;
+
+    void set_scan_progress(const ProgressMode::value_type mode, const double interval)
+    {
+        scan_progress_mode_     = mode;
+        scan_progress_interval_ = interval;
+    }
+
+    ProgressMode::value_type get_scan_progress_mode()
+    {
+        return scan_progress_mode_;
+    }
+
+    double get_scan_progress_interval()
+    {
+        return scan_progress_interval_;
+    }
+
+} // namespace at
@@ -0,0 +1,88 @@
+#include "AnalysisTools/CMS2Tools/interface/RunLumiPartition.h"
+#include "AnalysisTools/CMS2Tools/interface/Mix64.h"
+
+// c++
+#include <stdexcept>
+#include <cstdio>
+#include <stdint.h>
+
+namespace at
+{
+    RunLumiPartition::RunLumiPartition()
+        : scheme(Scheme::NONE)
+        , shard(0)
+        , num_shards(1)
+    {
+    }
+
+    RunLumiPartition::RunLumiPartition(const Scheme::value_type scheme_, const unsigned int shard_, const unsigned int num_shards_)
+        : scheme(scheme_)
+        , shard(shard_)
+        , num_shards(num_shards_)
+    {
+        if (num_shards < 1 || shard >= num_shards)
+        {
+            throw std::invalid_argument("[at::RunLumiPartition] Error: invalid shard " + ToString());
+        }
+    }
+
+    // does this shard own the (run, lumi)?
+    bool RunLumiPartition::Owns(const unsigned int run, const unsigned int lumi) const
+    {
+        switch (scheme)
+        {
+            case Scheme::RUN : return (run % num_shards) == shard;
+            case Scheme::LUMI: return (detail::Mix64((static_cast<uint64_t>(run) << 32) | lumi) % num_shards) == shard;
+            case Scheme::NONE:
+            default:
+                return true;
+        }
+    }
+
+    std::string RunLumiPartition::ToString() const
+    {
+        char buffer[64];
+        switch (scheme)
+        {
+            case Scheme::RUN : snprintf(buffer, sizeof(buffer), "run:%u/%u" , shard, num_shards); break;
+            case Scheme::LUMI: snprintf(buffer, sizeof(buffer), "lumi:%u/%u", shard, num_shards); break;
+            case Scheme::NONE:
+            default:
+                snprintf(buffer, sizeof(buffer), "none");
+        }
+        return buffer;
+    }
+
+    // parse "none", "run:<shard>/<num_shards>" or "lumi:<shard>/<num_shards>"
+    RunLumiPartition ParseRunLumiPartition(const std::string& str)
+    {
+        if (str.empty() || str == "none")
+        {
+            return RunLumiPartition();
+        }
+        char scheme[16]         = "";
+        unsigned int shard      = 0;
+        unsigned int num_shards = 0;
+        if (sscanf(str.c_str(), "%15[a-z]:%u/%u", scheme, &shard, &num_shards) != 3)
+        {
+            throw std::invalid_argument("[at::ParseRunLumiPartition] Error: expected \"run:<shard>/<num_shards>\" or \"lumi:<shard>/<num_shards>\", got " + str);
+        }
+        const std::string scheme_name = scheme;
+        if (scheme_name == "run" ) {return RunLumiPartition(RunLumiPartition::Scheme::RUN , shard, num_shards);}
+        if (scheme_name == "lumi") {return RunLumiPartition(RunLumiPartition::Scheme::LUMI, shard, num_shards);}
+        throw std::invalid_argument("[at::ParseRunLumiPartition] Error: unknown scheme " + scheme_name);
+    }
+
+    static RunLumiPartition run_lumi_partition_;
+
+    void set_run_lumi_partition(const RunLumiPartition& partition)
+    {
+        run_lumi_partition_ = partition;
+    }
+
+    const RunLumiPartition& get_run_lumi_partition()
+    {
+        return run_lumi_partition_;
+    }
+
+} // namespace at
@@ -1,29 +1,1044 @@
 // c++
 #include <iostream>
 #include <stdexcept>
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <type_traits>
+#include <limits>
 
 // ROOT
 #include "TChain.h"
 #include "TTreeCache.h"
 #include "TBenchmark.h"
+#include "TThread.h"
 
 // CMS2
 #include "CMS2/NtupleMacrosHeader/interface/CMS2.h"
 
 // tools
 #include "AnalysisTools/CMS2Tools/interface/DorkyEventIdentifier.h"
+#include "AnalysisTools/CMS2Tools/interface/TwoTierDuplicateFilter.h"
+#include "AnalysisTools/CMS2Tools/interface/EntryRangeScheduler.h"
+#include "AnalysisTools/CMS2Tools/interface/RunLumiPartition.h"
+#include "AnalysisTools/CMS2Tools/interface/LumiIndex.h"
+#include "AnalysisTools/CMS2Tools/interface/EventIndex.h"
+#include "AnalysisTools/CMS2Tools/interface/EventBlock.h"
+#include "AnalysisTools/CMS2Tools/interface/ProgressReporter.h"
+#include "AnalysisTools/CMS2Tools/interface/LumiPreFilter.h"
+#include "AnalysisTools/CMS2Tools/interface/GoodRunList.h"
+#include "AnalysisTools/CMS2Tools/interface/FilePrefetcher.h"
+#include "AnalysisTools/CMS2Tools/interface/TreeCacheSizing.h"
+#include "AnalysisTools/CMS2Tools/interface/FileFaultPolicy.h"
+#include "AnalysisTools/CMS2Tools/interface/MemoryMonitor.h"
+#include "AnalysisTools/CMS2Tools/interface/ScanStageTimer.h"
+#include "AnalysisTools/CMS2Tools/interface/BranchUsageProfile.h"
+#include "AnalysisTools/CMS2Tools/interface/ScanCheckpoint.h"
 #include "AnalysisTools/CMS2Tools/interface/GoodRun.h"
 #include "AnalysisTools/RootTools/interface/RootTools.h"
 #include "AnalysisTools/LanguageTools/interface/LanguageTools.h"
 
 namespace at
 {
+    namespace detail
+    {
+        // only the events with the run, lumi and event (-1 --> any) pass the selection
+        struct SelectEvents
+        {
+            SelectEvents(const int run, const int lumi, const int event)
+                : m_run(run)
+                , m_lumi(lumi)
+                , m_event(event)
+            {
+            }
+
+            template <bool Verbose>
+            bool Pass(const unsigned int run, const unsigned int ls, const unsigned int evt) const
+            {
+                if (m_event >= 0 && evt != static_cast<unsigned int>(m_event)) return false;
+                if (m_lumi  >= 0 && ls  != static_cast<unsigned int>(m_lumi )) return false;
+                if (m_run   >= 0 && run != static_cast<unsigned int>(m_run  )) return false;
+                if (Verbose)
+                {
+                    if (m_event >= 0) {std::cout << "selected event:\t" << evt << std::endl;}
+                    if (m_lumi  >= 0) {std::cout << "selected lumi:\t"  << ls  << std::endl;}
+                    if (m_run   >= 0) {std::cout << "selected run:\t"   << run << std::endl;}
+                }
+                return true;
+            }
+
+            int m_run;
+            int m_lumi;
+            int m_event;
+        };
+
+        // call visit(id) for the data entries [0, num_entries) of a file that are owned and selected 
+        // (a file is either all data or all MC so an MC file stops at its first entry; returns the error 
+        // if the file can't be opened)
+        template <typename NtupleClass, typename Visitor>
+        std::string VisitDataEventIds
+        (
+            const std::string& file_name,
+            const std::string& tree_name,
+            NtupleClass& ntuple_class,
+            const long num_entries,
+            OwnedEntryCursor owned_entries,
+            OwnedEntryCursor selected_entries,
+            const SelectEvents& selection,
+            Visitor visit
+        )
+        {
+            TFile *file = NULL;
+            TTree *tree = NULL;
+            unsigned int num_attempts = 0;
+            const std::string error = OpenFileAndTree(file_name, tree_name, file, tree, num_attempts);
+            if (!error.empty())
+            {
+                return error;
+            }
+            Init(ntuple_class, tree);
+
+            const long num_events_tree = std::min(static_cast<long>(tree->GetEntriesFast()), num_entries);
+            for (long event = 0; event < num_events_tree; ++event)
+            {
+                // jump over the entries not owned or not selected (from the indexes)
+                const long next_entry = std::max(owned_entries.NextOwned(event), selected_entries.NextOwned(event));
+                if (next_entry != event)
+                {
+                    event = next_entry - 1;
+                    continue;
+                }
+
+                LoadEventId(ntuple_class, event);
+                if (not IsRealData(ntuple_class)) break;
+
+                const unsigned int run = Run(ntuple_class);
+                const unsigned int ls  = LumiBlock(ntuple_class);
+                const unsigned int evt = Event(ntuple_class);
+                if (not selection.template Pass<false>(run, ls, evt)) continue;
+
+                DorkyEventIdentifier id = {run, evt, ls};
+                visit(id);
+            }
+
+            file->Close();
+            delete file;
+            return "";
+        }
+
+    } // namespace detail
+
+    // Run the pre-scan of the TWO_TIER duplicate filter over the entries the event loop can read.
+    template <typename NtupleClass>
+    void PreScanDuplicates
+    (
+        TChain* const chain, 
+        NtupleClass& ntuple_class,
+        const bool use_goodrun,
+        const bool verbose,
+        const long num_events,
+        const int evt_run,
+        const int evt_lumi,
+        const int evt_event
+    )
+    {
+        using namespace std;
+
+        // the first num_events entries of the chain (counted the way ScanChainLoop counts them)
+        const long num_events_chain = (num_events >= 0 && num_events < chain->GetEntries()) ? num_events : chain->GetEntries();
+        if (num_events_chain <= 0)
+        {
+            return;
+        }
+
+        // the filter of the earlier ScanChain calls is extended
+        TwoTierDuplicateFilter& filter = begin_duplicate_prescan(num_events_chain);
+        const bool extending = filter.BeginPreScan();
+        if (verbose) {cout << "[at::PreScanDuplicates] pre-scanning " << num_events_chain << " events" << endl;}
+
+        // only this shard's good events are asked about
+        const RunLumiPartition& partition = get_run_lumi_partition();
+        const detail::SelectEvents selection(evt_run, evt_lumi, evt_event);
+
+        TwoTierDuplicateFilter::PreScanPass pass;
+        pass.tree_name = chain->GetName();
+        pass.evt_run   = evt_run;
+        pass.evt_lumi  = evt_lumi;
+        pass.evt_event = evt_event;
+
+        const std::vector<EntryRange> file_ranges = GetFileRanges(*chain);
+        long num_events_total = 0;
+        size_t file_index = 0;
+        TIter file_iter(chain->GetListOfFiles());
+        TFile* current_file = NULL;
+        while ((current_file = static_cast<TFile*>(file_iter.Next())) && num_events_total < num_events_chain)
+        {
+            const string file_name = current_file->GetTitle();
+            const long file_entries = file_ranges.at(file_index++).end;
+            const long num_entries  = std::min(file_entries, num_events_chain - num_events_total);
+            num_events_total += num_entries;
+            if (num_entries <= 0) continue;
+
+            // the files without owned or selected entries are skipped without opening them
+            const OwnedEntryCursor owned_entries = GetOwnedEntries(file_name);
+            if (owned_entries.Empty()) continue;
+            const OwnedEntryCursor selected_entries = GetSelectedEntries(file_name, evt_run, evt_lumi, evt_event, file_entries);
+            if (selected_entries.Empty()) continue;
+
+            const string error = detail::VisitDataEventIds(file_name, pass.tree_name, ntuple_class, num_entries, owned_entries, selected_entries, selection,
+                [&](const DorkyEventIdentifier& id)
+                {
+                    if (not partition.Owns(id.run, id.lumi)) return;
+                    if (use_goodrun && not goodrun(id.run, id.lumi)) return;
+                    filter.PreScan(id);
+                });
+
+            // a bad file is left to the event loop to skip (or fail on) 
+            if (!error.empty())
+            {
+                if (get_file_fault_policy() == FileFaultPolicy::FAIL)
+                {
+                    throw std::runtime_error(error);
+                }
+                continue;
+            }
+            pass.files.push_back(std::make_pair(file_name, num_entries));
+        }
+
+        // the second pass of an earlier call only put its candidates in the exact set: 
+        // reread the earlier pre-scans for the ids flagged for the first time now 
+        // (ownership and good runs are a function of (run, lumi) so they aren't rechecked)
+        if (extending && filter.NumToRecheck() > 0)
+        {
+            if (verbose) {cout << "[at::PreScanDuplicates] rechecking " << filter.NumToRecheck() << " ids against the earlier pre-scans" << endl;}
+            const std::vector<TwoTierDuplicateFilter::PreScanPass>& passes = filter.GetPreScanPasses();
+            for (size_t i = 0; i != passes.size(); ++i)
+            {
+                const detail::SelectEvents pass_selection(passes[i].evt_run, passes[i].evt_lumi, passes[i].evt_event);
+                for (size_t j = 0; j != passes[i].files.size(); ++j)
+                {
+                    detail::VisitDataEventIds(passes[i].files[j].first, passes[i].tree_name, ntuple_class, passes[i].files[j].second, OwnedEntryCursor(), OwnedEntryCursor(), pass_selection,
+                        [&](const DorkyEventIdentifier& id) {filter.Recheck(id);});
+                }
+            }
+        }
+        filter.EndPreScan(pass);
+    }
+
+    namespace detail
+    {
+        // Open the files of the chain with owned (and selected) entries ahead of the serial event loops
+        // (starting with the file first_file_index of the chain).
+        // The cache is left to the loop for the files where the lumi pre-filter reads the event ids.
+        template <typename NtupleClass>
+        std::unique_ptr<FilePrefetcher> MakeFilePrefetcher
+        (
+            TChain& chain, 
+            const bool fast, 
+            const bool use_goodrun, 
+            const size_t first_file_index = 0,
+            const int evt_run = -1,
+            const int evt_lumi = -1,
+            const int evt_event = -1
+        )
+        {
+            std::vector<std::string> file_names;
+            std::vector<bool> use_caches;
+            const LumiIndex* const lumi_index = get_lumi_index();
+            const std::vector<EntryRange> file_ranges = GetFileRanges(chain);
+            TIter file_iter(chain.GetListOfFiles());
+            TFile* current_file = NULL;
+            size_t file_index = 0;
+            while ((current_file = static_cast<TFile*>(file_iter.Next())))
+            {
+                const std::string file_name = current_file->GetTitle();
+                const long long num_entries = file_ranges.at(file_index).end;
+                if (file_index++ < first_file_index) continue;
+                if (GetOwnedEntries(file_name).Empty()) continue;
+                if (GetSelectedEntries(file_name, evt_run, evt_lumi, evt_event, num_entries).Empty()) continue;
+
+                const bool reads_event_ids = use_goodrun && HasEventIdEntry<NtupleClass>::value && not (lumi_index && lumi_index->Contains(file_name));
+                file_names.push_back(file_name);
+                use_caches.push_back(fast && not reads_event_ids);
+            }
+
+            const size_t depth = get_file_prefetch_depth();
+            if (fast)
+            {
+                TTreeCache::SetLearnEntries(get_tree_cache_learn_entries());
+            }
+            if (depth > 0)
+            {
+                TThread::Initialize();
+            }
+            return std::unique_ptr<FilePrefetcher>(new FilePrefetcher(file_names, chain.GetName(), use_caches, depth));
+        }
+
+        // -------------------------------------------------------------------------------------------------//
+        // Policies of the serial event loop (ScanChainLoop).
+        // Each one is a template parameter so a feature that is off costs nothing per event,
+        // and a new mode is a new policy instead of another copy of the loop.
+        // -------------------------------------------------------------------------------------------------//
+
+        // how the analyzer is called: analyzer.Analyze(entry)
+        // (BeginFile is called when a file is opened and Flush before the file is closed
+        //  or a checkpoint is written)
+        struct AnalyzeEntry
+        {
+            template <typename Analyzer>
+            explicit AnalyzeEntry(Analyzer& /*analyzer*/) {}
+
+            static const char* Name() {return "at::ScanChain";}
+
+            void BeginFile(TTree& /*tree*/, const std::string& /*file_name*/) {}
+
+            template <typename Analyzer>
+            void Analyze(Analyzer& analyzer, const long entry, TFile& /*file*/)
+            {
+                analyzer.Analyze(entry);
+            }
+
+            template <typename Analyzer>
+            void Flush(Analyzer& /*analyzer*/) {}
+        };
+
+        // how the analyzer is called: analyzer.Analyze(entry, file_name)
+        struct AnalyzeEntryWithFilename
+        {
+            template <typename Analyzer>
+            explicit AnalyzeEntryWithFilename(Analyzer& /*analyzer*/) {}
+
+            static const char* Name() {return "at::ScanChainWithFilename";}
+
+            void BeginFile(TTree& /*tree*/, const std::string& /*file_name*/) {}
+
+            template <typename Analyzer>
+            void Analyze(Analyzer& analyzer, const long entry, TFile& file)
+            {
+                analyzer.Analyze(entry, file.GetName());
+            }
+
+            template <typename Analyzer>
+            void Flush(Analyzer& /*analyzer*/) {}
+        };
+
+        // how the analyzer is called: analyzer.Analyze(const EventBlock&) once per block of accepted entries
+        // (the name is the one of the per event convention it replaces)
+        template <typename PerEventCall>
+        struct AnalyzeEventBlock
+        {
+            template <typename Analyzer>
+            explicit AnalyzeEventBlock(Analyzer& analyzer)
+                : block(analyzer.GetBlockBranchNames(), get_event_block_size())
+            {
+            }
+
+            static const char* Name() {return PerEventCall::Name();}
+
+            void BeginFile(TTree& tree, const std::string& file_name)
+            {
+                block.SetTree(tree, file_name);
+            }
+
+            template <typename Analyzer>
+            void Analyze(Analyzer& analyzer, const long entry, TFile& /*file*/)
+            {
+                block.Add(entry);
+                if (block.Full()) {Flush(analyzer);}
+            }
+
+            template <typename Analyzer>
+            void Flush(Analyzer& analyzer)
+            {
+                if (block.Empty()) {return;}
+                analyzer.Analyze(static_cast<const EventBlock&>(block));
+                block.Clear();
+            }
+
+            EventBlock block;
+        };
+
+        // the calling convention for the analyzer: blocks if it has Analyze(const EventBlock&), otherwise PerEventCall
+        template <typename PerEventCall, typename Analyzer>
+        struct SelectAnalyzeCall
+        {
+            typedef typename std::conditional<HasEventBlockAnalyze<Analyzer>::value, AnalyzeEventBlock<PerEventCall>, PerEventCall>::type type;
+        };
+
+        // every event passes the run/lumi/event selection
+        struct SelectAllEvents
+        {
+            SelectAllEvents(const int /*run*/, const int /*lumi*/, const int /*event*/) {}
+
+            template <bool Verbose>
+            bool Pass(const unsigned int /*run*/, const unsigned int /*ls*/, const unsigned int /*evt*/) const {return true;}
+        };
+
+        // report the progress from a ProgressReporter thread (see set_scan_progress):
+        // the loop only stores its count in an atomic
+        struct ThreadedProgress
+        {
+            ThreadedProgress(const long num_events_chain, const std::string& name)
+                : num_events(0)
+                , reporter(num_events, num_events_chain, name, get_scan_progress_mode(), get_scan_progress_interval())
+            {
+            }
+
+            void Update(const long num_events_total)
+            {
+                num_events.store(num_events_total, std::memory_order_relaxed);
+            }
+
+            void Stop() {reporter.Stop();}
+
+            std::atomic<long> num_events;
+            ProgressReporter reporter;
+        };
+
+        // no progress report (ProgressMode::NONE: no reporter thread and nothing to update per event)
+        struct NoProgress
+        {
+            NoProgress(const long /*num_events_chain*/, const std::string& /*name*/) {}
+            void Update(const long /*num_events_total*/) {}
+            void Stop() {}
+        };
+
+        // The serial event loop behind ScanChain and ScanChainWithFilename.
+        // AnalyzeCall: calling convention of the analyzer (AnalyzeEntry, AnalyzeEntryWithFilename, AnalyzeEventBlock)
+        // Selection  : run/lumi/event selection (SelectAllEvents, SelectEvents)
+        // Progress   : progress report (ThreadedProgress, NoProgress)
+        // Timer      : time spent in each stage (ScanStageTimer, NoStageTimer)
+        // EntryChecks: the per entry checks: checkpoints, the memory soft limit and the entries skipped without reading 
+        //              them (other shards' from the lumi index, bad lumi clusters, unselected ones from the event index)
+        //              (without them the memory is sampled once per file)
+        // Verbose    : print the files and each filtered event
+        template <typename AnalyzeCall, typename Selection, typename Progress, typename Timer, bool EntryChecks, bool Verbose, typename NtupleClass, typename Analyzer>
+        int ScanChainLoop
+        (
+            TChain* const chain,
+            Analyzer& analyzer,
+            NtupleClass& ntuple_class,
+            const long num_events,
+            const std::string& goodrun_file_name,
+            const bool fast,
+            const int evt_run,
+            const int evt_lumi,
+            const int evt_event
+        )
+        {
+            using namespace std;
+            const std::string function_name = AnalyzeCall::Name();
+
+            // test chain
+            if (!chain)
+            {
+                throw std::invalid_argument(function_name + ": chain is NULL!");
+            }
+            if (chain->GetListOfFiles()->GetEntries()<1)
+            {
+                throw std::invalid_argument(function_name + ": chain has no files!");
+            }
+            // (with SKIP or RETRY a bad first file is left to the file fault policy)
+            if (get_file_fault_policy() == FileFaultPolicy::FAIL && not chain->GetFile())
+            {
+                throw std::invalid_argument(function_name + ": chain has no files or file path is invalid!");
+            }
+            if (Verbose) {rt::PrintFilesFromTChain(chain);}
+
+            // set the "good run" list
+            if (!goodrun_file_name.empty())
+            {
+                set_goodrun_file(goodrun_file_name.c_str());
+            }
+
+            // the two tier duplicate filter needs to see every data event the loop can read first
+            if (get_duplicate_filter_mode() == DuplicateFilterMode::TWO_TIER)
+            {
+                PreScanDuplicates(chain, ntuple_class, !goodrun_file_name.empty(), Verbose, num_events, evt_run, evt_lumi, evt_event);
+            }
+
+            // set the style
+            rt::SetStyle("emruoi");
+
+            // benchmark
+            TBenchmark bmark;
+            bmark.Start("benchmark");
+
+            // events counts and max events
+            long num_events_total = 0;
+            long num_events_chain = (num_events >= 0 && num_events < chain->GetEntries()) ? num_events : chain->GetEntries();
+            TObjArray* list_of_files = chain->GetListOfFiles();
+            TIter file_iter(list_of_files);
+            TFile* current_file = NULL;
+
+            // the run/lumi/event selection
+            const Selection selection(evt_run, evt_lumi, evt_event);
+
+            // calls the analyzer
+            AnalyzeCall call(analyzer);
+
+            // count the duplicates and bad events
+            unsigned long duplicates = 0;
+            unsigned long bad_events = 0;
+
+            // events owned by other shards of the run/lumi partition
+            const RunLumiPartition& partition = get_run_lumi_partition();
+            unsigned long not_owned = 0;
+
+            // the files skipped by the fault policy (see set_file_fault_policy) and the entries the chain counted for them
+            BadFileReport bad_files;
+            const std::vector<EntryRange> file_ranges = GetFileRanges(*chain);
+
+            // checkpoints (see set_scan_checkpoint): the job resumes from the last one
+            if (!get_scan_checkpoint_file().empty() && not HasCheckpointHooks<Analyzer>::value)
+            {
+                cout << "Warning: checkpoints need the Analyzer::Checkpoint/Restore hooks -- none are written" << endl;
+            }
+            ScanCheckpointer checkpointer(HasCheckpointHooks<Analyzer>::value ? get_scan_checkpoint_file() : "", get_scan_checkpoint_interval());
+            const bool resumed = checkpointer.Begin(rt::GetFilesFromTChain(chain));
+            const size_t first_file_index = checkpointer.Last().file_index;
+
+            // time spent in each stage of the loop and the I/O of the files
+            Timer timer(get_scan_timing_histograms());
+            TreeCacheStats cache_stats;
+
+            // the memory of the job (see set_memory_monitor)
+            MemoryMonitor memory(1, get_memory_monitor_interval(), get_memory_soft_limit());
+            unsigned long num_memory_calls = 0;
+
+            // the branches the analysis reads (see set_branch_usage_profile):
+            // prune with the profile if there is one, otherwise learn it
+            BranchUsageProfile branch_usage;
+            const bool use_branch_usage   = LoadBranchUsageProfile(branch_usage);
+            const bool learn_branch_usage = !get_branch_usage_file().empty() && not use_branch_usage;
+            bool prune_branches           = use_branch_usage;
+            long num_learn_entries        = get_branch_usage_learn_entries();
+            long num_pruned_entries       = 0;
+
+            // begin job
+            analyzer.BeginJob();
+
+            // pick up where the last checkpoint left off (the analyzer restores its histograms)
+            if (resumed)
+            {
+                checkpointer.Restore(analyzer, bad_files);
+                num_events_total = checkpointer.Last().num_events_total;
+                bad_events       = checkpointer.Last().bad_events;
+                duplicates       = checkpointer.Last().duplicates;
+                not_owned        = checkpointer.Last().not_owned;
+                cout << "resuming from " << get_scan_checkpoint_file() << " at file " << first_file_index << ", entry " << checkpointer.Last().entry << endl;
+            }
+
+            // the files are opened ahead of the loop (the branches the cache learns in the first file are cached 
+            // in the ones after it), only from here on so the background opens don't run during BeginJob and Restore
+            std::unique_ptr<FilePrefetcher> prefetcher = MakeFilePrefetcher<NtupleClass>(*chain, fast, !goodrun_file_name.empty(), first_file_index, evt_run, evt_lumi, evt_event);
+            bool cached_branches_known = false;
+            size_t next_file_index = 0;
+            if (use_branch_usage)
+            {
+                prefetcher->SetCachedBranches(branch_usage.GetBranchNameList());
+                cached_branches_known = true;
+            }
+
+            // progress report
+            Progress progress(num_events_chain, function_name);
+
+            // loop over files in the chain
+            while ((current_file = static_cast<TFile*>(file_iter.Next())))
+            {
+                // skip the files done before the checkpoint
+                const size_t file_index = next_file_index++;
+                if (file_index < first_file_index) continue;
+
+                // the entries owned by this shard (skip the file if there are none)
+                OwnedEntryCursor owned_entries = GetOwnedEntries(current_file->GetTitle());
+                if (owned_entries.Empty())
+                {
+                    const long num_skipped = std::min(static_cast<long>(owned_entries.NumEntries()), num_events_chain - num_events_total);
+                    num_events_total += num_skipped;
+                    not_owned        += num_skipped;
+                    continue;
+                }
+
+                // the entries with the selected run/lumi/event (from the event index; skip the file if there are none)
+                OwnedEntryCursor selected_entries = GetSelectedEntries(current_file->GetTitle(), evt_run, evt_lumi, evt_event, file_ranges.at(file_index).end);
+                if (selected_entries.Empty())
+                {
+                    num_events_total += std::min(static_cast<long>(selected_entries.NumEntries()), num_events_chain - num_events_total);
+                    continue;
+                }
+
+                // quit if the total is >= the number in the chain
+                if (num_events_total >= num_events_chain) break;
+
+                // the next file (already opened in the background; throws if the file or tree is invalid)
+                timer.Enter(ScanStage::FILE_OPEN);
+                FilePrefetcher::PrefetchedFile prefetched_file;
+                try
+                {
+                    prefetched_file = prefetcher->Next();
+                }
+                catch (std::runtime_error& e)
+                {
+                    if (get_file_fault_policy() == FileFaultPolicy::FAIL)
+                    {
+                        throw;
+                    }
+
+                    // skip the file: the entries the chain counted for it are lost 
+                    // (a file the chain could not open has none: they come from the indexes or are unknown)
+                    const unsigned int num_attempts = 1 + (get_file_fault_policy() == FileFaultPolicy::RETRY ? get_file_fault_retries() : 0);
+                    const long num_entries = file_ranges.at(file_index).end - (file_index == first_file_index ? checkpointer.Last().entry : 0);
+                    const long num_counted = std::min(num_entries, num_events_chain - num_events_total);
+                    const long long num_lost = (file_ranges.at(file_index).end > 0 ? num_counted : GetBadFileEntries(current_file->GetTitle()));
+                    cout << "Warning: skipping file (" << e.what() << ")" << endl;
+                    bad_files.Add(current_file->GetTitle(), num_lost, num_attempts, e.what());
+                    num_events_total += num_counted;
+                    continue;
+                }
+                TFile *file = prefetched_file.file;
+                TTree *tree = prefetched_file.tree;
+
+                Init(ntuple_class, tree);
+
+                // the clusters with only bad lumis are skipped without reading them
+                // (before the cache is set up so that it doesn't learn only the event id branches)
+                OwnedEntryCursor good_clusters;
+                if (!goodrun_file_name.empty())
+                {
+                    good_clusters = GetGoodLumiClusters(*tree, ntuple_class, current_file->GetTitle(), GetDefaultGoodRunList());
+                }
+
+                if (fast && not prefetched_file.cache_ready)
+                {
+                    prefetched_file.cache_size = SetTreeCache(*tree, prune_branches ? branch_usage.GetBranchNameList() : std::vector<std::string>());
+                }
+                if (prune_branches)
+                {
+                    branch_usage.Prune(*tree);
+                }
+                call.BeginFile(*tree, current_file->GetTitle());
+
+                // Loop over Events in current file
+                long num_events_tree = tree->GetEntriesFast();
+
+                // loop over events to Analyze
+                const long first_entry = (file_index == first_file_index ? checkpointer.Last().entry : 0);
+                for (long event = first_entry; event < num_events_tree; ++event)
+                {
+                    // quit if the total is > the number in the chain
+                    if (num_events_total >= num_events_chain) continue;
+
+                    // checkpoint (a resumed job starts from this entry)
+                    if (EntryChecks && checkpointer.Due())
+                    {
+                        call.Flush(analyzer);
+                        const ScanCheckpoint position = {file_index, event, num_events_total, bad_events, duplicates, not_owned};
+                        checkpointer.Save(position, analyzer, bad_files);
+                    }
+
+                    // sample the memory (over the soft limit the cache of this file is shrunk too)
+                    if (EntryChecks && (++num_memory_calls & 0x3ff) == 0 && memory.Due())
+                    {
+                        memory.SetAnalyzerMemory(0, GetAnalyzerMemoryUsage(analyzer));
+                        if (memory.Sample() && fast)
+                        {
+                            prefetched_file.cache_size = ShrinkTreeCache(*tree, prefetched_file.cache_size);
+                        }
+                    }
+
+                    // jump over the entries owned by other shards (from the lumi index)
+                    const long next_owned = (EntryChecks ? owned_entries.NextOwned(event) : event);
+                    if (next_owned != event)
+                    {
+                        const long num_skipped = std::min(next_owned - event, num_events_chain - num_events_total);
+                        num_events_total += num_skipped;
+                        not_owned        += num_skipped;
+                        event            += num_skipped - 1;
+                        continue;
+                    }
+
+                    // jump over the clusters of bad lumis
+                    const long next_good = (EntryChecks ? good_clusters.NextOwned(event) : event);
+                    if (next_good != event)
+                    {
+                        const long num_skipped = std::min(next_good - event, num_events_chain - num_events_total);
+                        num_events_total += num_skipped;
+                        bad_events       += num_skipped;
+                        event            += num_skipped - 1;
+                        continue;
+                    }
+
+                    // jump over the entries without the selected run/lumi/event
+                    const long next_selected = (EntryChecks ? selected_entries.NextOwned(event) : event);
+                    if (next_selected != event)
+                    {
+                        const long num_skipped = std::min(next_selected - event, num_events_chain - num_events_total);
+                        num_events_total += num_skipped;
+                        event            += num_skipped - 1;
+                        continue;
+                    }
+
+                    // load the event id (the rest of the entry is only read for selected events)
+                    timer.Enter(ScanStage::READ_ID);
+                    if (fast) tree->LoadTree(event);
+                    const bool load_entry = LoadEventId(ntuple_class, event);
+                    ++num_events_total;
+                    timer.Enter(ScanStage::FILTER);
+
+                    // pogress
+                    progress.Update(num_events_total);
+
+                    unsigned int run = Run(ntuple_class);
+                    unsigned int ls  = LumiBlock(ntuple_class);
+                    unsigned int evt = Event(ntuple_class);
+
+                    // check run/ls/evt
+                    if (not selection.template Pass<Verbose>(run, ls, evt))
+                    {
+                        continue;
+                    }
+
+                    // filter out events
+                    if (IsRealData(ntuple_class))
+                    {
+                        // (run, lumi)s owned by other shards (MC is read by every shard)
+                        if (not partition.Owns(run, ls))
+                        {
+                            not_owned++;
+                            continue;
+                        }
+
+                        if (!goodrun_file_name.empty())
+                        {
+                            // check for good run and events
+                            if(!goodrun(run, ls))
+                            {
+                                if (Verbose) {cout << "Bad run and lumi:\t" << run << ", " << ls << endl;}
+                                bad_events++;
+                                continue;
+                            }
+                        }
+
+                        // check for dupiclate run and events
+                        DorkyEventIdentifier id = {run, evt, ls};
+                        if (is_duplicate(id))
+                        {
+                            if (Verbose) {cout << "Duplicate event:\t" << run << ", " << ls << ", " << evt << endl;}
+                            duplicates++;
+                            continue;
+                        }
+                    }
+
+                    // load the rest of the entry
+                    timer.Enter(ScanStage::GET_ENTRY);
+                    if (load_entry) GetEntry(ntuple_class, event);
+
+                    // analysis
+                    timer.Enter(ScanStage::ANALYZE);
+                    call.Analyze(analyzer, event, *file);
+
+                    // prune the rest of the job after the learning window
+                    if (learn_branch_usage && not prune_branches && num_learn_entries > 0 && --num_learn_entries == 0)
+                    {
+                        branch_usage.Learn(*tree);
+                        branch_usage.Prune(*tree);
+                        prefetcher->SetCachedBranches(branch_usage.GetBranchNameList());
+                        cached_branches_known = true;
+                        prune_branches = true;
+                    }
+
+                    // a branch read while pruned (not in the profile or first read after the learning window) 
+                    // was not loaded: stop rather than analyze stale values
+                    else if (prune_branches && (++num_pruned_entries & 0x3ff) == 0)
+                    {
+                        branch_usage.Verify(*tree);
+                    }
+
+                } // end event loop
+
+                // the events of the last block
+                timer.Enter(ScanStage::ANALYZE);
+                call.Flush(analyzer);
+
+                // cache what was learned in the files opened from now on
+                timer.Enter(ScanStage::FILE_CLOSE);
+                if (not EntryChecks && memory.Due())
+                {
+                    memory.SetAnalyzerMemory(0, GetAnalyzerMemoryUsage(analyzer));
+                    memory.Sample();
+                }
+                if (prune_branches)
+                {
+                    branch_usage.Verify(*tree);
+                }
+                else if (!get_branch_usage_file().empty())
+                {
+                    branch_usage.Learn(*tree);
+                }
+                if (fast && not cached_branches_known)
+                {
+                    const std::vector<std::string> cached_branches = FilePrefetcher::GetCachedBranches(*file, *tree);
+                    if (!cached_branches.empty())
+                    {
+                        prefetcher->SetCachedBranches(cached_branches);
+                        cached_branches_known = true;
+                    }
+                }
+
+                // close current file
+                cache_stats.Add(*file, *tree, prefetched_file.cache_size);
+                prefetcher->Close(prefetched_file);
+
+            } // end file loop
+            timer.Stop();
+            progress.Update(num_events_total);
+            progress.Stop();
+            memory.SetAnalyzerMemory(0, GetAnalyzerMemoryUsage(analyzer));
+            memory.Sample();
+
+            // print warning if the totals don't line up
+            if (num_events_chain != num_events_total)
+            {
+                cout << "Error: number of events from the files "
+                    << "(" << num_events_chain << ") "
+                    << "is not equal to the total number of events "
+                    << "(" << num_events_total << ")."
+                    << endl;
+            }
+
+            // save the output
+            analyzer.EndJob();
+
+            // the job finished: the checkpoint is no longer needed
+            if (checkpointer.Enabled())
+            {
+                cout << "# of checkpoints written = " << checkpointer.NumSaved() << endl;
+                checkpointer.Remove();
+            }
+
+            // the benchmark results
+            // -------------------------------------------------------------------------------------------------//
+            bmark.Stop("benchmark");
+            cout << endl;
+            cout << num_events_total << " Events Processed" << endl;
+            cout << "# of bad events filtered = " << bad_events << endl;
+            cout << "# of duplicates filtered = " << duplicates << endl;
+            if (partition.scheme != RunLumiPartition::Scheme::NONE)
+            {
+                cout << "# of events not owned    = " << not_owned << " (shard " << partition.ToString() << ")" << endl;
+            }
+            if (bad_files.Size() > 0)
+            {
+                cout << "# of events in bad files = " << bad_files.LostEntries() << " (" << bad_files.Size() << " files skipped, " 
+                    << bad_files.NumUnknownEntries() << " with an unknown number of entries)" << endl;
+                bad_files.Print(cout);
+            }
+            if (!get_bad_file_report().empty())
+            {
+                bad_files.Write(get_bad_file_report());
+                cout << "bad file report written to " << get_bad_file_report() << endl;
+            }
+            if (!get_branch_usage_file().empty())
+            {
+                branch_usage.Print(cout);
+                if (learn_branch_usage)
+                {
+                    branch_usage.Write(get_branch_usage_file());
+                    cout << "branch usage profile written to " << get_branch_usage_file() << endl;
+                }
+            }
+            if (get_duplicate_filter_mode() == DuplicateFilterMode::TWO_TIER && get_two_tier_duplicate_filter())
+            {
+                get_two_tier_duplicate_filter()->Print(cout, duplicates);
+            }
+            cout << "------------------------------" << endl;
+            cout << "CPU  Time: " << Form("%.01f", bmark.GetCpuTime("benchmark" )) << endl;
+            cout << "Real Time: " << Form("%.01f", bmark.GetRealTime("benchmark")) << endl;
+            cout << "File Wait: " << Form("%.01f", prefetcher->WaitTime()) << endl;
+            cout << "------------------------------" << endl;
+            cache_stats.Print(cout);
+            cout << "------------------------------" << endl;
+            memory.Print(cout);
+            cout << "------------------------------" << endl;
+            timer.Print(cout);
+            cout << endl;
+
+            // machine readable report
+            if (!get_scan_report_file().empty())
+            {
+                std::vector<std::pair<std::string, double> > values;
+                values.push_back(std::make_pair("events"        , num_events_total              ));
+                values.push_back(std::make_pair("bad_events"    , bad_events                    ));
+                values.push_back(std::make_pair("duplicates"    , duplicates                    ));
+                values.push_back(std::make_pair("not_owned"     , not_owned                     ));
+                values.push_back(std::make_pair("skipped_files" , bad_files.Size()              ));
+                values.push_back(std::make_pair("lost_entries"  , bad_files.LostEntries()       ));
+                values.push_back(std::make_pair("unknown_lost"  , bad_files.NumUnknownEntries() ));
+                values.push_back(std::make_pair("threads"       , 1                             ));
+                values.push_back(std::make_pair("cpu_time"      , bmark.GetCpuTime("benchmark") ));
+                values.push_back(std::make_pair("real_time"     , bmark.GetRealTime("benchmark")));
+                values.push_back(std::make_pair("file_wait_time", prefetcher->WaitTime()        ));
+                cache_stats.AppendReportValues(values);
+                memory.AppendReportValues(values);
+                WriteScanReport(get_scan_report_file(), function_name, values, timer);
+            }
+
+            // done
+            return 0;
+        }
+
+        // pick the ScanChainLoop for the per entry checks and verbosity: a job without checkpoints, memory soft limit 
+        // or entries to skip with the indexes or the good run list has no per entry checks
+        template <typename AnalyzeCall, typename Selection, typename Progress, typename Timer, typename NtupleClass, typename Analyzer>
+        int DispatchScanChainEntryChecks
+        (
+            TChain* const chain,
+            Analyzer& analyzer,
+            NtupleClass& ntuple_class,
+            const long num_events,
+            const std::string& goodrun_file_name,
+            const bool fast,
+            const bool verbose,
+            const int evt_run,
+            const int evt_lumi,
+            const int evt_event
+        )
+        {
+            const bool entry_checks = 
+            (
+                (!get_scan_checkpoint_file().empty() && HasCheckpointHooks<Analyzer>::value) ||
+                get_memory_soft_limit() > 0                                                   ||
+                (get_run_lumi_partition().scheme != RunLumiPartition::Scheme::NONE && get_lumi_index()) ||
+                !goodrun_file_name.empty()                                                    ||
+                ((evt_run >= 0 || evt_lumi >= 0 || evt_event >= 0) && get_event_index())
+            );
+            if (entry_checks)
+            {
+                return (verbose
+                    ? ScanChainLoop<AnalyzeCall, Selection, Progress, Timer, true, true >(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, evt_run, evt_lumi, evt_event)
+                    : ScanChainLoop<AnalyzeCall, Selection, Progress, Timer, true, false>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, evt_run, evt_lumi, evt_event));
+            }
+            return (verbose
+                ? ScanChainLoop<AnalyzeCall, Selection, Progress, Timer, false, true >(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, evt_run, evt_lumi, evt_event)
+                : ScanChainLoop<AnalyzeCall, Selection, Progress, Timer, false, false>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, evt_run, evt_lumi, evt_event));
+        }
+
+        // pick the stage timer (the stages are only timed for the scan report)
+        template <typename AnalyzeCall, typename Selection, typename Progress, typename NtupleClass, typename Analyzer>
+        int DispatchScanChainTimer
+        (
+            TChain* const chain,
+            Analyzer& analyzer,
+            NtupleClass& ntuple_class,
+            const long num_events,
+            const std::string& goodrun_file_name,
+            const bool fast,
+            const bool verbose,
+            const int evt_run,
+            const int evt_lumi,
+            const int evt_event
+        )
+        {
+            if (get_scan_report_file().empty())
+            {
+                return DispatchScanChainEntryChecks<AnalyzeCall, Selection, Progress, NoStageTimer>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, verbose, evt_run, evt_lumi, evt_event);
+            }
+            return DispatchScanChainEntryChecks<AnalyzeCall, Selection, Progress, ScanStageTimer>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, verbose, evt_run, evt_lumi, evt_event);
+        }
+
+        // pick the progress report (no reporter thread if the progress is off)
+        template <typename AnalyzeCall, typename Selection, typename NtupleClass, typename Analyzer>
+        int DispatchScanChainProgress
+        (
+            TChain* const chain,
+            Analyzer& analyzer,
+            NtupleClass& ntuple_class,
+            const long num_events,
+            const std::string& goodrun_file_name,
+            const bool fast,
+            const bool verbose,
+            const int evt_run,
+            const int evt_lumi,
+            const int evt_event
+        )
+        {
+            if (get_scan_progress_mode() == ProgressMode::NONE)
+            {
+                return DispatchScanChainTimer<AnalyzeCall, Selection, NoProgress>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, verbose, evt_run, evt_lumi, evt_event);
+            }
+            return DispatchScanChainTimer<AnalyzeCall, Selection, ThreadedProgress>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, verbose, evt_run, evt_lumi, evt_event);
+        }
+
+        // pick the ScanChainLoop for the runtime options (and the analyzer's calling convention)
+        template <typename PerEventCall, typename NtupleClass, typename Analyzer>
+        int DispatchScanChainLoop
+        (
+            TChain* const chain,
+            Analyzer& analyzer,
+            NtupleClass& ntuple_class,
+            const long num_events,
+            const std::string& goodrun_file_name,
+            const bool fast,
+            const bool verbose,
+            const int evt_run,
+            const int evt_lumi,
+            const int evt_event
+        )
+        {
+            typedef typename SelectAnalyzeCall<PerEventCall, Analyzer>::type AnalyzeCall;
+            const bool select_events = (evt_run >= 0 || evt_lumi >= 0 || evt_event >= 0);
+            if (select_events)
+            {
+                return DispatchScanChainProgress<AnalyzeCall, SelectEvents>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, verbose, evt_run, evt_lumi, evt_event);
+            }
+            return DispatchScanChainProgress<AnalyzeCall, SelectAllEvents>(chain, analyzer, ntuple_class, num_events, goodrun_file_name, fast, verbose, evt_run, evt_lumi, evt_event);
+        }
+
+    } // namespace detail
+
+    // Peform an analysis on a chain.
+    template <typename NtupleClass, typename Analyzer>
+    int ScanChain
+    (
+        TChain* const chain,
+        Analyzer& analyzer,
+        NtupleClass& ntuple_class,
+        const long num_events,
+        const std::string& goodrun_file_name,
+        const bool fast,
+        const bool verbose,
+        const int evt_run,
+        const int evt_lumi,
+        const int evt_event
+    )
+    {
+        return detail::DispatchScanChainLoop<detail::AnalyzeEntry>
+        (
+            chain,
+            analyzer,
+            ntuple_class,
+            num_events,
+            goodrun_file_name,
+            fast,
+            verbose,
+            evt_run,
+            evt_lumi,
+            evt_event
+        );
+    }
+
     // Peform an analysis on a chain.
+    // Same as ScanChain except we pass the file name to the analysis object
     template <typename NtupleClass, typename Analyzer>
-    int ScanChain
+    int ScanChainWithFilename
     (
-        TChain* const chain, 
-        Analyzer& analyzer, 
+        TChain* const chain,
+        Analyzer& analyzer,
         NtupleClass& ntuple_class,
         const long num_events,
         const std::string& goodrun_file_name,
@@ -34,221 +1049,413 @@ namespace at
         const int evt_event
     )
     {
-        using namespace std;
+        return detail::DispatchScanChainLoop<detail::AnalyzeEntryWithFilename>
+        (
+            chain,
+            analyzer,
+            ntuple_class,
+            num_events,
+            goodrun_file_name,
+            fast,
+            verbose,
+            evt_run,
+            evt_lumi,
+            evt_event
+        );
+    }
 
-        // test chain
-        if (!chain)
-        {
-            throw std::invalid_argument("at::ScanChain: chain is NULL!");
-        }
-        if (chain->GetListOfFiles()->GetEntries()<1)
+    namespace detail
+    {
+        // does the analyzer merge all the worker copies at once (Merge(const std::vector<const Analyzer*>&))?
+        template <typename Analyzer>
+        auto HasMergeAllImpl(int) -> decltype
+        (
+            std::declval<Analyzer&>().Merge(std::declval<const std::vector<const Analyzer*>&>()),
+            std::true_type()
+        );
+
+        template <typename Analyzer>
+        std::false_type HasMergeAllImpl(long);
+
+        template <typename Analyzer>
+        struct HasMergeAll : decltype(HasMergeAllImpl<Analyzer>(0))
         {
-            throw std::invalid_argument("at::ScanChain: chain has no files!");
-        }
-        if (not chain->GetFile())
+        };
+
+        // merge the worker copies into the analyzer
+        template <typename Analyzer>
+        void MergeAnalyzers(Analyzer& analyzer, const std::vector<std::unique_ptr<Analyzer> >& copies, std::true_type)
         {
-            throw std::invalid_argument("at::ScanChain: chain has no files or file path is invalid!");
+            std::vector<const Analyzer*> pointers;
+            for (size_t i = 0; i < copies.size(); ++i)
+            {
+                pointers.push_back(copies[i].get());
+            }
+            analyzer.Merge(pointers);
         }
 
-        // tree name
-        string tree_name = chain->GetName();
-
-        // set the "good run" list 
-        if (!goodrun_file_name.empty())
+        template <typename Analyzer>
+        void MergeAnalyzers(Analyzer& analyzer, const std::vector<std::unique_ptr<Analyzer> >& copies, std::false_type)
         {
-            set_goodrun_file(goodrun_file_name.c_str());
+            for (size_t i = 0; i < copies.size(); ++i)
+            {
+                analyzer.Merge(*copies[i]);
+            }
         }
 
-        // set the style
-        rt::SetStyle("emruoi");
-    
-        // benchmark
-        TBenchmark bmark;
-        bmark.Start("benchmark");
-    
-        // events counts and max events
-        int i_permilleOld = 0;
-        long num_events_total = 0;
-        long num_events_chain = (num_events >= 0 && num_events < chain->GetEntries()) ? num_events : chain->GetEntries();
-        TObjArray* list_of_files = chain->GetListOfFiles();
-        TIter file_iter(list_of_files);
-        TFile* current_file = NULL;
+        // the clusters with good lumis of every file (see GetGoodLumiClusters) found once before the workers
+        // start, instead of by every worker that gets a range of the file
+        // (files without the (run, lumi)s in the lumi index are not opened unless the ntuple class has GetEventIdEntry)
+        template <typename NtupleClass>
+        std::vector<OwnedEntryCursor> GetGoodLumiClustersOfFiles
+        (
+            const std::vector<std::string>& file_names, 
+            const std::string& tree_name, 
+            NtupleClass& ntuple_class
+        )
+        {
+            std::vector<OwnedEntryCursor> result(file_names.size());
+            const LumiIndex* const lumi_index = get_lumi_index();
+            for (size_t i = 0; i != file_names.size(); ++i)
+            {
+                const bool indexed = lumi_index && lumi_index->Contains(file_names[i]);
+                if (not indexed && not HasEventIdEntry<NtupleClass>::value) continue;
 
-        // count the duplicates and bad events
-        unsigned long duplicates = 0;
-        unsigned long bad_events = 0;
+                // a bad file is left to the worker that gets it
+                TFile* file = NULL;
+                TTree* tree = NULL;
+                unsigned int num_attempts = 0;
+                const std::string error = OpenFileAndTree(file_names[i], tree_name, file, tree, num_attempts);
+                if (!error.empty()) continue;
 
-        // begin job
-        analyzer.BeginJob();
+                Init(ntuple_class, tree);
+                result[i] = GetGoodLumiClusters(*tree, ntuple_class, file_names[i], GetDefaultGoodRunList());
+                file->Close();
+                delete file;
+            }
+            return result;
+        }
 
-        // loop over files in the chain
-        //while ((current_file = (TFile*)file_iter.Next()))
-        while ((current_file = static_cast<TFile*>(file_iter.Next())))
+        // add up to num_events to the shared count without going over the limit (returns the number added)
+        // (a CAS loop so two workers at the limit can't both overshoot and then over-correct)
+        inline long AddToEventCount(std::atomic<long>& num_events_total, const long num_events, const long limit)
         {
-            TFile *file = TFile::Open(current_file->GetTitle());
-            if (!file || file->IsZombie())
+            long current = num_events_total.load();
+            long added   = 0;
+            do
             {
-                //std::cout << "Skipping bad input file: " << current_file->GetTitle() << std::endl;
-                //continue;
-                throw std::runtime_error(Form("File from TChain is invalid or corrupt: %s", current_file->GetTitle()));
+                added = std::min(num_events, std::max(0L, limit - current));
             }
+            while (added > 0 && not num_events_total.compare_exchange_weak(current, current + added));
+            return added;
+        }
+
+        // state shared between the ScanChainParallel workers
+        struct ParallelScanState
+        {
+            std::vector<std::string> file_names;
+            std::vector<long long> file_entries; // as counted by the chain (0 for a file it could not open)
+            std::string tree_name;
+            std::string goodrun_file_name;
+            bool fast;
+            bool verbose;
+            int evt_run;
+            int evt_lumi;
+            int evt_event;
+            long num_events_chain;
+            RunLumiPartition partition;
+
+            // the branches to read (NULL --> all of them)
+            const BranchUsageProfile* branch_usage;
+
+            // the clusters of each file with good lumis (empty --> no good run list; each worker copies the cursor)
+            std::vector<OwnedEntryCursor> good_clusters;
+
+            std::unique_ptr<EntryRangeScheduler> scheduler;
+            std::atomic<long> num_events_total;
+            std::atomic<bool> abort;
+
+            // the files skipped by the fault policy
+            BadFileReport bad_files;
 
-            // get the trees in each file
-            TTree *tree = dynamic_cast<TTree*>(file->Get(tree_name.c_str()));
-            if (!tree || tree->IsZombie())
+            // the memory of the job (one analyzer slot per worker)
+            std::unique_ptr<MemoryMonitor> memory;
+
+            // guards TFile open/close, printing and the error message
+            std::mutex mutex;
+            std::string error;
+        };
+
+        // a worker processes EntryRanges from the scheduler until none are left
+        template <typename NtupleClass, typename Analyzer>
+        struct ParallelScanWorker
+        {
+            ParallelScanWorker(ParallelScanState& state_, const size_t worker_index_, NtupleClass& ntuple_, Analyzer& analyzer_)
+                : state(state_)
+                , worker_index(worker_index_)
+                , ntuple_class(ntuple_)
+                , analyzer(analyzer_)
+                , duplicates(0)
+                , bad_events(0)
+                , not_owned(0)
+                , timer(get_scan_timing_histograms())
+                , cache_stats()
+                , branch_usage()
             {
-                //std::cout << "Skipping bad input file (missing tree): " << current_file->GetTitle() << std::endl;
-                //continue;
-                throw std::runtime_error(Form("File from TChain has an invalid TTree or is corrupt: %s", current_file->GetTitle()));
             }
 
-            if (fast)
+            void operator()()
             {
-                TTreeCache::SetLearnEntries(10);
-                tree->SetCacheSize(128*1024*1024);
+                try
+                {
+                    Process();
+                }
+                catch (std::exception& e)
+                {
+                    std::lock_guard<std::mutex> lock(state.mutex);
+                    if (state.error.empty()) {state.error = e.what();}
+                    state.abort = true;
+                }
             }
-            Init(ntuple_class, tree);
 
-            // Loop over Events in current file
-            if (num_events_total >= num_events_chain) continue;
-            long num_events_tree = tree->GetEntriesFast();
+            void Process();
 
-            // loop over events to Analyze
-            for (long event = 0; event != num_events_tree; ++event)
-            {
-                // quit if the total is > the number in the chain
-                if (num_events_total >= num_events_chain) continue;
+            ParallelScanState& state;
+            size_t worker_index;
+            NtupleClass& ntuple_class;
+            Analyzer& analyzer;
+            unsigned long duplicates;
+            unsigned long bad_events;
+            unsigned long not_owned;
+            ScanStageTimer timer;
+            TreeCacheStats cache_stats;
+            BranchUsageProfile branch_usage;
+        };
 
-                // load the entry
-                if (fast) tree->LoadTree(event);
-                GetEntry(ntuple_class, event);
-                ++num_events_total;
+        template <typename NtupleClass, typename Analyzer>
+        void ParallelScanWorker<NtupleClass, Analyzer>::Process()
+        {
+            using namespace std;
 
-                // pogress
-                int i_permille = (int)floor(1000 * num_events_total / float(num_events_chain));
-                if (i_permille != i_permilleOld) {
-                    printf("  \015\033[32m ---> \033[1m\033[31m%4.1f%%" "\033[0m\033[32m <---\033[0m\015", i_permille/10.);
-                    fflush(stdout);
-                    i_permilleOld = i_permille;
-                }
+            // the file stays open while consecutive ranges come from it
+            TFile* file = NULL;
+            TTree* tree = NULL;
+            size_t current_file_index = state.file_names.size();
+            OwnedEntryCursor good_clusters;
+            long long cache_size = 0;
+            long num_pruned_entries = 0;
+            bool file_ready = false;
+            typename SelectAnalyzeCall<AnalyzeEntry, Analyzer>::type call(analyzer);
 
-                unsigned int run = Run(ntuple_class);
-                unsigned int ls  = LumiBlock(ntuple_class);
-                unsigned int evt = Event(ntuple_class);
+            EntryRange range;
+            while (not state.abort && state.scheduler->Next(worker_index, range))
+            {
+                if (state.num_events_total >= state.num_events_chain) break;
 
-                // check run/ls/evt
-                if (evt_event >= 0)
+                // open the file if needed 
+                // (TFile::Open and TDirectory::Get modify ROOT's global lists)
+                if (range.file_index != current_file_index)
                 {
-                    if (evt==static_cast<unsigned int>(evt_event))
+                    if (file)
                     {
-                        if (verbose) {cout << "selected event:\t" << evt << endl;}
+                        timer.Enter(ScanStage::ANALYZE);
+                        call.Flush(analyzer);
                     }
-                    else
+                    timer.Enter(ScanStage::FILE_OPEN);
+                    if (file)
                     {
-                        continue;
+                        if (state.branch_usage) {branch_usage.Verify(*tree);}
+                        else if (!get_branch_usage_file().empty()) {branch_usage.Learn(*tree);}
+                        cache_stats.Add(*file, *tree, cache_size);
+                        ReleaseTreeCache(cache_size);
+                        cache_size = 0;
+                        std::lock_guard<std::mutex> lock(state.mutex);
+                        file->Close();
+                        delete file;
+                        file = NULL;
+                        tree = NULL;
+                    }
+                    current_file_index = range.file_index;
+                    file_ready = false;
+
+                    // open the file and get its tree (retried as the fault policy says; 
+                    // the other workers don't try a file again once it was given up on)
+                    const std::string& file_name = state.file_names.at(range.file_index);
+                    if (not state.bad_files.Contains(file_name))
+                    {
+                        unsigned int num_attempts = 0;
+                        const std::string error = OpenFileAndTree(file_name, state.tree_name, file, tree, num_attempts, &state.mutex);
+                        if (!error.empty())
+                        {
+                            if (get_file_fault_policy() == FileFaultPolicy::FAIL)
+                            {
+                                throw std::runtime_error(error);
+                            }
+                            // (the entries the chain counted are added range by range below; 
+                            // a file the chain could not open has none: they come from the indexes or are unknown)
+                            const long long num_lost = (state.file_entries.at(range.file_index) > 0 ? 0 : GetBadFileEntries(file_name));
+                            std::lock_guard<std::mutex> lock(state.mutex);
+                            cout << "Warning: skipping file (" << error << ")" << endl;
+                            state.bad_files.Add(file_name, num_lost, num_attempts, error);
+                        }
                     }
                 }
-                if (evt_lumi >= 0)
+
+                // the entries of a file that was given up on are lost
+                if (!file)
+                {
+                    const long num_lost = AddToEventCount(state.num_events_total, range.end - range.begin, state.num_events_chain);
+                    state.bad_files.Add(state.file_names.at(range.file_index), num_lost, 0, "");
+                    continue;
+                }
+
+                // set up a file that was just opened
+                if (not file_ready)
                 {
-                    if (ls==static_cast<unsigned int>(evt_lumi))
+                    const std::string& file_name = state.file_names.at(range.file_index);
                     {
-                        if (verbose) {cout << "selected lumi:\t" << ls << endl;}
+                        std::lock_guard<std::mutex> lock(state.mutex);
+                        Init(ntuple_class, tree);
+                        if (state.fast)
+                        {
+                            cache_size = SetTreeCache(*tree, state.branch_usage ? state.branch_usage->GetBranchNameList() : std::vector<std::string>());
+                        }
                     }
-                    else
+
+                    // the clusters with only bad lumis are skipped without reading them (found once per file up front)
+                    good_clusters = (state.good_clusters.empty() ? OwnedEntryCursor() : state.good_clusters.at(range.file_index));
+
+                    if (state.branch_usage)
                     {
-                        continue;
+                        state.branch_usage->Prune(*tree);
                     }
+                    call.BeginFile(*tree, file_name);
+                    file_ready = true;
                 }
-                if (evt_run >= 0)
+
+                // sample the memory between ranges (over the soft limit the cache of this file is shrunk too)
+                if (state.memory->Due())
                 {
-                    if (ls==static_cast<unsigned int>(evt_run))
+                    state.memory->SetAnalyzerMemory(worker_index, GetAnalyzerMemoryUsage(analyzer));
+                    if (state.memory->Sample() && state.fast)
                     {
-                        if (verbose) {cout << "selected run:\t" << run << endl;}
+                        cache_size = ShrinkTreeCache(*tree, cache_size);
                     }
-                    else
+                }
+
+                // only cache the baskets of this range
+                if (state.fast)
+                {
+                    tree->SetCacheEntryRange(range.begin, range.end);
+                }
+
+                // loop over events to Analyze
+                for (long event = range.begin; event != range.end && not state.abort; ++event)
+                {
+                    // jump over the clusters of bad lumis (quit if the total reached the number in the chain)
+                    const long next_good = std::min(static_cast<long>(good_clusters.NextOwned(event)), static_cast<long>(range.end));
+                    if (next_good != event)
                     {
+                        const long num_skipped = AddToEventCount(state.num_events_total, next_good - event, state.num_events_chain);
+                        if (num_skipped == 0) break;
+                        bad_events += num_skipped;
+                        event      += num_skipped - 1;
                         continue;
                     }
-                }
 
-                // filter out events
-                if (IsRealData(ntuple_class))
-                {
-                    if (!goodrun_file_name.empty())
+                    // quit if the total reached the number in the chain
+                    if (AddToEventCount(state.num_events_total, 1, state.num_events_chain) == 0) break;
+
+                    // load the event id (the rest of the entry is only read for selected events)
+                    timer.Enter(ScanStage::READ_ID);
+                    if (state.fast) tree->LoadTree(event);
+                    const bool load_entry = LoadEventId(ntuple_class, event);
+                    timer.Enter(ScanStage::FILTER);
+
+                    unsigned int run = Run(ntuple_class);
+                    unsigned int ls  = LumiBlock(ntuple_class);
+                    unsigned int evt = Event(ntuple_class);
+
+                    // check run/ls/evt
+                    if (state.evt_event >= 0 && evt != static_cast<unsigned int>(state.evt_event)) continue;
+                    if (state.evt_lumi  >= 0 && ls  != static_cast<unsigned int>(state.evt_lumi )) continue;
+                    if (state.evt_run   >= 0 && run != static_cast<unsigned int>(state.evt_run  )) continue;
+
+                    // filter out events
+                    if (IsRealData(ntuple_class))
                     {
-                        // check for good run and events
-                        if(!goodrun(run, ls)) 
+                        // (run, lumi)s owned by other shards (MC is read by every shard)
+                        if (not state.partition.Owns(run, ls))
                         {
-                            if (verbose) {cout << "Bad run and lumi:\t" << run << ", " << ls << endl;}
-                            bad_events++;
+                            not_owned++;
                             continue;
                         }
-                    }
 
-                    // check for dupiclate run and events
-                    DorkyEventIdentifier id = {run, evt, ls};
-                    if (is_duplicate(id))
-                    {
-                        if (verbose) {cout << "good run file = " << goodrun_file_name << endl;}
-                        duplicates++;
-                        continue;
+                        if (!state.goodrun_file_name.empty())
+                        {
+                            // check for good run and events
+                            if(!goodrun(run, ls)) 
+                            {
+                                bad_events++;
+                                continue;
+                            }
+                        }
+
+                        // check for dupiclate run and events (is_duplicate is shared by all workers)
+                        DorkyEventIdentifier id = {run, evt, ls};
+                        if (is_duplicate(id))
+                        {
+                            duplicates++;
+                            continue;
+                        }
                     }
-                }
 
-                // print run/ls/event
-                if (verbose)
-                {
-                    //cout << Form("run %d, ls %d, evt %d", run, ls, evt) << endl;
-                }
+                    // load the rest of the entry
+                    timer.Enter(ScanStage::GET_ENTRY);
+                    if (load_entry) GetEntry(ntuple_class, event);
 
-                // analysis
-                analyzer.Analyze(event);
+                    // analysis
+                    timer.Enter(ScanStage::ANALYZE);
+                    call.Analyze(analyzer, event, *file);
 
-            } // end event loop
+                    // a branch read while pruned (not in the profile) was not loaded: stop rather than analyze stale values
+                    if (state.branch_usage && (++num_pruned_entries & 0x3ff) == 0)
+                    {
+                        branch_usage.Verify(*tree);
+                    }
 
-            // close current file
-            file->Close();
-            delete file;
+                } // end event loop
 
-        } // end file loop
-    
-        // print warning if the totals don't line up
-        if (num_events_chain != num_events_total) 
-        {
-            cout << "Error: number of events from the files " 
-                << "(" << num_events_chain << ") " 
-                << "is not equal to the total number of events "
-                << "(" << num_events_total << ")." 
-                << endl;
+            } // end range loop
+
+            // close the last file
+            if (file)
+            {
+                timer.Enter(ScanStage::ANALYZE);
+                if (not state.abort) {call.Flush(analyzer);}
+                timer.Enter(ScanStage::FILE_CLOSE);
+                if (state.branch_usage && not state.abort) {branch_usage.Verify(*tree);}
+                else if (!get_branch_usage_file().empty()) {branch_usage.Learn(*tree);}
+                cache_stats.Add(*file, *tree, cache_size);
+                ReleaseTreeCache(cache_size);
+                std::lock_guard<std::mutex> lock(state.mutex);
+                file->Close();
+                delete file;
+            }
+            timer.Stop();
         }
 
-        // save the output
-        analyzer.EndJob();
-    
-        // the benchmark results 
-        // -------------------------------------------------------------------------------------------------//
-        bmark.Stop("benchmark");
-        cout << endl;
-        cout << num_events_total << " Events Processed" << endl;
-        cout << "# of bad events filtered = " << bad_events << endl; 
-        cout << "# of duplicates filtered = " << duplicates << endl; 
-        cout << "------------------------------" << endl;
-        cout << "CPU  Time: " << Form("%.01f", bmark.GetCpuTime("benchmark" )) << endl;
-        cout << "Real Time: " << Form("%.01f", bmark.GetRealTime("benchmark")) << endl;
-        cout << endl;
-    
-        // done
-        return 0;
-    }
+    } // namespace detail
 
-    // Peform an analysis on a chain.
-    // Same as ScanChain except we pass the file name to the analysis object 
+    // Peform an analysis on a chain using a pool of worker threads.
     template <typename NtupleClass, typename Analyzer>
-    int ScanChainWithFilename
+    int ScanChainParallel
     (
         TChain* const chain, 
         Analyzer& analyzer, 
         NtupleClass& ntuple_class,
+        const unsigned int num_threads,
+        const ScanSplitMode::value_type split_mode,
         const long num_events,
         const std::string& goodrun_file_name,
         const bool fast,
@@ -263,25 +1470,38 @@ namespace at
         // test chain
         if (!chain)
         {
-            throw std::invalid_argument("at::ScanChain: chain is NULL!");
+            throw std::invalid_argument("at::ScanChainParallel: chain is NULL!");
         }
         if (chain->GetListOfFiles()->GetEntries()<1)
         {
-            throw std::invalid_argument("at::ScanChain: chain has no files!");
+            throw std::invalid_argument("at::ScanChainParallel: chain has no files!");
         }
-        if (not chain->GetFile())
+        // (with SKIP or RETRY a bad first file is left to the file fault policy)
+        if (get_file_fault_policy() == FileFaultPolicy::FAIL && not chain->GetFile())
         {
-            throw std::invalid_argument("at::ScanChain: chain has no files or file path is invalid!");
+            throw std::invalid_argument("at::ScanChainParallel: chain has no files or file path is invalid!");
         }
 
-        if (verbose) {rt::PrintFilesFromTChain(chain);}
-        string tree_name = chain->GetName();
-    
-        // set the "good run" list 
+        // make ROOT's global state safe to use from the worker threads
+        TThread::Initialize();
+
+        // the workers finish ranges out of order so there is no single position to resume from
+        if (!get_scan_checkpoint_file().empty())
+        {
+            cout << "Warning: at::ScanChainParallel does not write checkpoints (see set_scan_checkpoint)" << endl;
+        }
+
+        // set the "good run" list (loaded once here, only read by the workers)
         if (!goodrun_file_name.empty())
         {
             set_goodrun_file(goodrun_file_name.c_str());
-            //set_goodrun_file_json(goodrun_file_name.c_str());
+        }
+
+        // the two tier duplicate filter needs to see every data event first
+        // (all the entries: the workers can stop at num_events anywhere in the chain)
+        if (get_duplicate_filter_mode() == DuplicateFilterMode::TWO_TIER)
+        {
+            PreScanDuplicates(chain, ntuple_class, !goodrun_file_name.empty(), verbose, -1, evt_run, evt_lumi, evt_event);
         }
 
         // set the style
@@ -290,162 +1510,181 @@ namespace at
         // benchmark
         TBenchmark bmark;
         bmark.Start("benchmark");
-    
-        // events counts and max events
-        int i_permilleOld = 0;
-        long num_events_total = 0;
-        long num_events_chain = (num_events >= 0 && num_events < chain->GetEntries()) ? num_events : chain->GetEntries();
-        TObjArray* list_of_files = chain->GetListOfFiles();
-        TIter file_iter(list_of_files);
-        TFile* current_file = NULL;
 
-        // count the duplicates and bad events
-        unsigned long duplicates = 0;
-        unsigned long bad_events = 0;
+        // shared state
+        detail::ParallelScanState state;
+        state.file_names        = rt::GetFilesFromTChain(chain);
+        const std::vector<EntryRange> file_ranges = GetFileRanges(*chain);
+        for (size_t i = 0; i != file_ranges.size(); ++i)
+        {
+            state.file_entries.push_back(file_ranges[i].end);
+        }
+        state.tree_name         = chain->GetName();
+        state.goodrun_file_name = goodrun_file_name;
+        state.fast              = fast;
+        state.verbose           = verbose;
+        state.evt_run           = evt_run;
+        state.evt_lumi          = evt_lumi;
+        state.evt_event         = evt_event;
+        state.num_events_chain  = (num_events >= 0 && num_events < chain->GetEntries()) ? num_events : chain->GetEntries();
+        state.partition         = get_run_lumi_partition();
+        state.num_events_total  = 0;
+        state.abort             = false;
 
-        // begin job
-        analyzer.BeginJob();
+        // the branches the analysis reads (see set_branch_usage_profile):
+        // prune with the profile if there is one, otherwise the workers learn it
+        BranchUsageProfile branch_usage;
+        const bool use_branch_usage   = LoadBranchUsageProfile(branch_usage);
+        const bool learn_branch_usage = !get_branch_usage_file().empty() && not use_branch_usage;
+        state.branch_usage            = (use_branch_usage ? &branch_usage : NULL);
 
-        // loop over files in the chain
-        while ((current_file = (TFile*)file_iter.Next()))
+        // TTreeCache learning is a static setting
+        if (fast)
         {
-            TFile *file = TFile::Open(current_file->GetTitle());
-            if (!file || file->IsZombie())
-            {
-                //std::cout << "Skipping bad input file: " << current_file->GetTitle() << std::endl;
-                //continue;
-                throw std::runtime_error(Form("File from TChain is invalid or corrupt: %s", current_file->GetTitle()));
-            }
+            TTreeCache::SetLearnEntries(get_tree_cache_learn_entries());
+        }
 
-            // get the trees in each file
-            TTree *tree = dynamic_cast<TTree*>(file->Get(tree_name.c_str()));
-            if (!tree || tree->IsZombie())
-            {
-                //std::cout << "Skipping bad input file (missing tree): " << current_file->GetTitle() << std::endl;
-                //continue;
-                throw std::runtime_error(Form("File from TChain has an invalid TTree or is corrupt: %s", current_file->GetTitle()));
-            }
+        // number of workers
+        size_t num_workers = (num_threads > 0 ? num_threads : std::thread::hardware_concurrency());
+        if (num_workers < 1) {num_workers = 1;}
 
-            if (fast)
+        // split the chain into ranges of entries
+        std::vector<EntryRange> ranges;
+        switch (split_mode)
+        {
+            case ScanSplitMode::CLUSTER:
             {
-                TTreeCache::SetLearnEntries(10);
-                tree->SetCacheSize(128*1024*1024);
+                // group clusters into about 64 ranges per worker to balance the load
+                const long long min_entries = state.num_events_chain / (64 * num_workers);
+                ranges = GetClusterAlignedRanges(*chain, min_entries);
+                break;
             }
-            Init(ntuple_class, tree);
-
-            // Loop over Events in current file
-            if (num_events_total >= num_events_chain) continue;
-            long num_events_tree = tree->GetEntriesFast();
+            case ScanSplitMode::FILE:
+            default:
+                ranges = GetFileRanges(*chain);
+                break;
+        }
 
-            // loop over events to Analyze
-            for (long event = 0; event != num_events_tree; ++event)
+        // only the parts of the ranges owned by this shard in the files of the lumi index 
+        // (counted as not owned up front, the event limit then applies to the owned entries;
+        // the files missing from the index are left to the workers to check event by event)
+        unsigned long not_owned = 0;
+        const LumiIndex* const lumi_index = get_lumi_index();
+        if (lumi_index && state.partition.scheme != RunLumiPartition::Scheme::NONE)
+        {
+            std::vector<EntryRange> owned_ranges;
+            for (size_t i = 0; i != state.file_names.size(); ++i)
             {
-                // quit if the total is > the number in the chain
-                if (num_events_total >= num_events_chain) continue;
-
-                // load the entry
-                if (fast) tree->LoadTree(event);
-                GetEntry(ntuple_class, event);
-                ++num_events_total;
-
-                // pogress
-                int i_permille = (int)floor(1000 * num_events_total / float(num_events_chain));
-                if (i_permille != i_permilleOld) {
-                    printf("  \015\033[32m ---> \033[1m\033[31m%4.1f%%" "\033[0m\033[32m <---\033[0m\015", i_permille/10.);
-                    fflush(stdout);
-                    i_permilleOld = i_permille;
-                }
-
-                unsigned int run = Run(ntuple_class);
-                unsigned int ls  = LumiBlock(ntuple_class);
-                unsigned int evt = Event(ntuple_class);
-
-                // check run/ls/evt
-                if (evt_event >= 0)
+                if (lumi_index->Contains(state.file_names[i]))
                 {
-                    if (evt==static_cast<unsigned int>(evt_event))
-                    {
-                        if (verbose) {cout << "selected event:\t" << evt << endl;}
-                    }
-                    else
-                    {
-                        continue;
-                    }
-                }
-                if (evt_lumi >= 0)
-                {
-                    if (ls==static_cast<unsigned int>(evt_lumi))
-                    {
-                        if (verbose) {cout << "selected lumi:\t" << ls << endl;}
-                    }
-                    else
-                    {
-                        continue;
-                    }
+                    const std::vector<EntryRange> file_ranges = lumi_index->GetRanges(state.file_names[i], i, state.partition);
+                    owned_ranges.insert(owned_ranges.end(), file_ranges.begin(), file_ranges.end());
                 }
-                if (evt_run >= 0)
+                else
                 {
-                    if (ls==static_cast<unsigned int>(evt_run))
-                    {
-                        if (verbose) {cout << "selected run:\t" << run << endl;}
-                    }
-                    else
-                    {
-                        continue;
-                    }
+                    const EntryRange file_range = {i, 0, std::numeric_limits<long long>::max()};
+                    owned_ranges.push_back(file_range);
                 }
+            }
 
-                // filter out events
-                if (IsRealData(ntuple_class))
-                {
-                    if (!goodrun_file_name.empty())
-                    {
-                        // check for good run and events
-                        if(!goodrun(run, ls)) 
-                        {
-                            if (verbose) {cout << "Bad run and lumi:\t" << run << ", " << ls << endl;}
-                            bad_events++;
-                            continue;
-                        }
-                    }
+            long num_entries = 0;
+            for (size_t i = 0; i != ranges.size(); ++i)
+            {
+                num_entries += ranges[i].end - ranges[i].begin;
+            }
+            ranges = IntersectRanges(ranges, owned_ranges);
+            long num_owned = 0;
+            for (size_t i = 0; i != ranges.size(); ++i)
+            {
+                num_owned += ranges[i].end - ranges[i].begin;
+            }
+            not_owned = num_entries - num_owned;
+            if (state.num_events_chain > num_owned) {state.num_events_chain = num_owned;}
+        }
 
-                    // check for dupiclate run and events
-                    DorkyEventIdentifier id = {run, evt, ls};
-                    if (is_duplicate(id))
-                    {
-                        if (verbose) {cout << "Duplicate event:\t" << run << ", " << ls << ", " << evt << endl;}
-                        duplicates++;
-                        continue;
-                    }
-                }
+        // the clusters with only bad lumis (skipped by the workers without reading them)
+        if (!goodrun_file_name.empty())
+        {
+            state.good_clusters = detail::GetGoodLumiClustersOfFiles(state.file_names, state.tree_name, ntuple_class);
+        }
 
-                // print run/ls/event
-                if (verbose)
-                {
-                    //cout << Form("run %d, ls %d, evt %d", run, ls, evt) << endl;
-                }
+        // no point in more workers than ranges
+        if (num_workers > ranges.size()) {num_workers = (ranges.empty() ? 1 : ranges.size());}
+        state.scheduler.reset(new EntryRangeScheduler(ranges, num_workers));
+        state.memory.reset(new MemoryMonitor(num_workers, get_memory_monitor_interval(), get_memory_soft_limit()));
+        if (verbose) {cout << "[at::ScanChainParallel] using " << num_workers << " worker threads on " << ranges.size() << " ranges" << endl;}
 
-                // analysis
-                analyzer.Analyze(event, file->GetName());
+        // begin job
+        analyzer.BeginJob();
 
-            } // end event loop
+        // the workers (the first uses analyzer and ntuple_class, the rest get copies)
+        typedef detail::ParallelScanWorker<NtupleClass, Analyzer> Worker;
+        std::vector<std::unique_ptr<NtupleClass> > ntuples;
+        std::vector<std::unique_ptr<Analyzer> > analyzers;
+        std::vector<std::unique_ptr<Worker> > workers;
+        workers.emplace_back(new Worker(state, 0, ntuple_class, analyzer));
+        for (size_t i = 1; i < num_workers; ++i)
+        {
+            ntuples.emplace_back(new NtupleClass());
+            analyzers.emplace_back(new Analyzer(analyzer));
+            workers.emplace_back(new Worker(state, i, *ntuples.back(), *analyzers.back()));
+        }
 
-            // close current file
-            file->Close();
-            delete file;
+        // run the workers (this thread runs the first one) 
+        // while the reporter thread prints the progress of the shared count
+        ProgressReporter progress(state.num_events_total, state.num_events_chain, "at::ScanChainParallel", get_scan_progress_mode(), get_scan_progress_interval());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workers.size(); ++i)
+        {
+            threads.emplace_back(std::ref(*workers[i]));
+        }
+        (*workers.front())();
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            threads[i].join();
+        }
+        progress.Stop();
+        if (not state.error.empty())
+        {
+            throw std::runtime_error(state.error);
+        }
+
+        // the last memory sample (before the copies are merged)
+        state.memory->SetAnalyzerMemory(0, GetAnalyzerMemoryUsage(analyzer));
+        for (size_t i = 0; i < analyzers.size(); ++i)
+        {
+            state.memory->SetAnalyzerMemory(i + 1, GetAnalyzerMemoryUsage(*analyzers[i]));
+        }
+        state.memory->Sample();
+
+        // merge the copies into the analyzer
+        const RunLumiPartition& partition = state.partition;
+        unsigned long duplicates = 0;
+        unsigned long bad_events = 0;
+        ScanStageTimer timer(get_scan_timing_histograms());
+        TreeCacheStats cache_stats;
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            duplicates += workers[i]->duplicates;
+            bad_events += workers[i]->bad_events;
+            not_owned  += workers[i]->not_owned;
+            timer.Merge(workers[i]->timer);
+            cache_stats.Merge(workers[i]->cache_stats);
+            branch_usage.Merge(workers[i]->branch_usage);
+        }
+        detail::MergeAnalyzers(analyzer, analyzers, detail::HasMergeAll<Analyzer>());
 
-        } // end file loop
-    
         // print warning if the totals don't line up
-        if (num_events_chain != num_events_total) 
+        const long num_events_total = state.num_events_total;
+        if (state.num_events_chain != num_events_total) 
         {
             cout << "Error: number of events from the files " 
-                << "(" << num_events_chain << ") " 
+                << "(" << state.num_events_chain << ") " 
                 << "is not equal to the total number of events "
                 << "(" << num_events_total << ")." 
                 << endl;
         }
-    
+
         // save the output
         analyzer.EndJob();
     
@@ -454,15 +1693,72 @@ namespace at
         bmark.Stop("benchmark");
         cout << endl;
         cout << num_events_total << " Events Processed" << endl;
+        cout << "# of worker threads      = " << num_workers << endl; 
+        cout << "# of ranges (stolen)     = " << ranges.size() << " (" << state.scheduler->NumSteals() << ")" << endl; 
         cout << "# of bad events filtered = " << bad_events << endl; 
         cout << "# of duplicates filtered = " << duplicates << endl; 
+        if (partition.scheme != RunLumiPartition::Scheme::NONE)
+        {
+            cout << "# of events not owned    = " << not_owned << " (shard " << partition.ToString() << ")" << endl; 
+        }
+        if (state.bad_files.Size() > 0)
+        {
+            cout << "# of events in bad files = " << state.bad_files.LostEntries() << " (" << state.bad_files.Size() << " files skipped, " 
+                << state.bad_files.NumUnknownEntries() << " with an unknown number of entries)" << endl;
+            state.bad_files.Print(cout);
+        }
+        if (!get_bad_file_report().empty())
+        {
+            state.bad_files.Write(get_bad_file_report());
+            cout << "bad file report written to " << get_bad_file_report() << endl;
+        }
+        if (!get_branch_usage_file().empty())
+        {
+            branch_usage.Print(cout);
+            if (learn_branch_usage)
+            {
+                branch_usage.Write(get_branch_usage_file());
+                cout << "branch usage profile written to " << get_branch_usage_file() << endl;
+            }
+        }
+        if (get_duplicate_filter_mode() == DuplicateFilterMode::TWO_TIER && get_two_tier_duplicate_filter())
+        {
+            get_two_tier_duplicate_filter()->Print(cout, duplicates);
+        }
         cout << "------------------------------" << endl;
         cout << "CPU  Time: " << Form("%.01f", bmark.GetCpuTime("benchmark" )) << endl;
         cout << "Real Time: " << Form("%.01f", bmark.GetRealTime("benchmark")) << endl;
+        cout << "------------------------------" << endl;
+        cache_stats.Print(cout);
+        cout << "------------------------------" << endl;
+        state.memory->Print(cout);
+        cout << "------------------------------ (summed over the workers)" << endl;
+        timer.Print(cout);
         cout << endl;
+
+        // machine readable report
+        if (!get_scan_report_file().empty())
+        {
+            std::vector<std::pair<std::string, double> > values;
+            values.push_back(std::make_pair("events"        , num_events_total              ));
+            values.push_back(std::make_pair("bad_events"    , bad_events                    ));
+            values.push_back(std::make_pair("duplicates"    , duplicates                    ));
+            values.push_back(std::make_pair("not_owned"     , not_owned                     ));
+            values.push_back(std::make_pair("skipped_files" , state.bad_files.Size()        ));
+            values.push_back(std::make_pair("lost_entries"  , state.bad_files.LostEntries() ));
+            values.push_back(std::make_pair("unknown_lost"  , state.bad_files.NumUnknownEntries()));
+            values.push_back(std::make_pair("threads"       , num_workers                   ));
+            values.push_back(std::make_pair("ranges"        , ranges.size()                 ));
+            values.push_back(std::make_pair("steals"        , state.scheduler->NumSteals()  ));
+            values.push_back(std::make_pair("cpu_time"      , bmark.GetCpuTime("benchmark") ));
+            values.push_back(std::make_pair("real_time"     , bmark.GetRealTime("benchmark")));
+            cache_stats.AppendReportValues(values);
+            state.memory->AppendReportValues(values);
+            WriteScanReport(get_scan_report_file(), "at::ScanChainParallel", values, timer);
+        }
     
         // done
         return 0;
     }
-} // namespace at
 
+} // namespace at
@@ -0,0 +1,220 @@
+#include "AnalysisTools/CMS2Tools/interface/ScanCheckpoint.h"
+#include "AnalysisTools/CMS2Tools/interface/DorkyEventIdentifier.h"
+#include "AnalysisTools/CMS2Tools/interface/FileFaultPolicy.h"
+
+// c++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cstdio>
+
+namespace at
+{
+    ScanCheckpointer::ScanCheckpointer(const std::string& file_name, const double interval)
+        : m_file_name(file_name)
+        , m_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval)))
+        , m_next_time(std::chrono::steady_clock::now() + m_interval)
+        , m_num_calls(0)
+        , m_num_saved(0)
+        , m_generation(0)
+        , m_file_names()
+    {
+        const ScanCheckpoint start = {0, 0, 0, 0, 0, 0};
+        m_last = start;
+    }
+
+    std::string ScanCheckpointer::AnalyzerFileName(const unsigned int generation) const
+    {
+        std::ostringstream file_name;
+        file_name << m_file_name << "." << generation << ".analyzer";
+        return file_name.str();
+    }
+
+    std::string ScanCheckpointer::DuplicatesFileName(const unsigned int generation) const
+    {
+        std::ostringstream file_name;
+        file_name << m_file_name << "." << generation << ".duplicates";
+        return file_name.str();
+    }
+
+    std::string ScanCheckpointer::BadFilesFileName(const unsigned int generation) const
+    {
+        std::ostringstream file_name;
+        file_name << m_file_name << "." << generation << ".bad_files";
+        return file_name.str();
+    }
+
+    bool ScanCheckpointer::Begin(const std::vector<std::string>& file_names)
+    {
+        m_file_names = file_names;
+        if (m_file_name.empty())
+        {
+            return false;
+        }
+        std::ifstream in(m_file_name.c_str());
+        if (!in)
+        {
+            return false;
+        }
+
+        // "key value" lines ('#' comments) followed by the file names of the chain
+        std::map<std::string, long long> values;
+        std::vector<std::string> checkpoint_files;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream line_stream(line);
+            std::string key;
+            if (!(line_stream >> key) || key[0] == '#')
+            {
+                continue;
+            }
+            if (key == "file")
+            {
+                std::string name;
+                std::getline(line_stream >> std::ws, name);
+                checkpoint_files.push_back(name);
+                continue;
+            }
+            long long value = 0;
+            if (!(line_stream >> value))
+            {
+                throw std::runtime_error("[at::ScanCheckpointer::Begin] Error: bad line in " + m_file_name + ": " + line);
+            }
+            values[key] = value;
+        }
+
+        const char* const keys[] = {"generation", "file_index", "entry", "num_events_total", "bad_events", "duplicates", "not_owned"};
+        for (size_t i = 0; i != sizeof(keys) / sizeof(keys[0]); ++i)
+        {
+            if (values.find(keys[i]) == values.end())
+            {
+                throw std::runtime_error("[at::ScanCheckpointer::Begin] Error: " + m_file_name + " has no " + keys[i]);
+            }
+        }
+        if (checkpoint_files != m_file_names)
+        {
+            throw std::runtime_error("[at::ScanCheckpointer::Begin] Error: " + m_file_name + " was made for a different chain (remove it to start over)");
+        }
+
+        m_generation            = values["generation"];
+        m_last.file_index       = values["file_index"];
+        m_last.entry            = values["entry"];
+        m_last.num_events_total = values["num_events_total"];
+        m_last.bad_events       = values["bad_events"];
+        m_last.duplicates       = values["duplicates"];
+        m_last.not_owned        = values["not_owned"];
+        return true;
+    }
+
+    void ScanCheckpointer::SaveDuplicates(const unsigned int generation) const
+    {
+        const std::string file_name = DuplicatesFileName(generation);
+        std::ofstream out(file_name.c_str(), std::ios::binary);
+        if (!out)
+        {
+            throw std::runtime_error("[at::ScanCheckpointer::Save] Error: unable to open " + file_name);
+        }
+        save_duplicate_state(out);
+    }
+
+    void ScanCheckpointer::RestoreDuplicates() const
+    {
+        const std::string file_name = DuplicatesFileName(m_generation);
+        std::ifstream in(file_name.c_str(), std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("[at::ScanCheckpointer::Restore] Error: unable to open " + file_name);
+        }
+        load_duplicate_state(in);
+    }
+
+    // (the files skipped before the checkpoint are not read again by the resumed job)
+    void ScanCheckpointer::SaveBadFiles(const unsigned int generation, const BadFileReport& bad_files) const
+    {
+        bad_files.Write(BadFilesFileName(generation));
+    }
+
+    void ScanCheckpointer::RestoreBadFiles(BadFileReport& bad_files) const
+    {
+        bad_files.Read(BadFilesFileName(m_generation));
+    }
+
+    void ScanCheckpointer::Commit(const ScanCheckpoint& position, const unsigned int generation)
+    {
+        // write the new text file next to the old one and swap them
+        const std::string tmp_file_name = m_file_name + ".tmp";
+        {
+            std::ofstream out(tmp_file_name.c_str());
+            out << "# at::ScanChain checkpoint (remove it and the files it names to start over)" << std::endl;
+            out << "generation "       << generation                << std::endl;
+            out << "file_index "       << position.file_index       << std::endl;
+            out << "entry "            << position.entry            << std::endl;
+            out << "num_events_total " << position.num_events_total << std::endl;
+            out << "bad_events "       << position.bad_events       << std::endl;
+            out << "duplicates "       << position.duplicates       << std::endl;
+            out << "not_owned "        << position.not_owned        << std::endl;
+            for (size_t i = 0; i != m_file_names.size(); ++i)
+            {
+                out << "file " << m_file_names[i] << std::endl;
+            }
+            if (!out)
+            {
+                throw std::runtime_error("[at::ScanCheckpointer::Save] Error: writing " + tmp_file_name + " failed");
+            }
+        }
+        if (std::rename(tmp_file_name.c_str(), m_file_name.c_str()) != 0)
+        {
+            throw std::runtime_error("[at::ScanCheckpointer::Save] Error: unable to rename " + tmp_file_name + " to " + m_file_name);
+        }
+
+        // the previous state is no longer needed
+        if (m_generation > 0)
+        {
+            std::remove(AnalyzerFileName(m_generation).c_str());
+            std::remove(DuplicatesFileName(m_generation).c_str());
+            std::remove(BadFilesFileName(m_generation).c_str());
+        }
+        m_generation = generation;
+        m_num_saved++;
+        m_next_time = std::chrono::steady_clock::now() + m_interval;
+    }
+
+    void ScanCheckpointer::Remove()
+    {
+        if (m_file_name.empty())
+        {
+            return;
+        }
+        std::remove(m_file_name.c_str());
+        if (m_generation > 0)
+        {
+            std::remove(AnalyzerFileName(m_generation).c_str());
+            std::remove(DuplicatesFileName(m_generation).c_str());
+            std::remove(BadFilesFileName(m_generation).c_str());
+        }
+        m_generation = 0;
+    }
+
+    // checkpoints of the serial ScanChain functions
+    static std::string scan_checkpoint_file_;
+    static double scan_checkpoint_interval_ = 600.0;
+
+    void set_scan_checkpoint(const std::string& file_name, const double interval)
+    {
+        scan_checkpoint_file_     = file_name;
+        scan_checkpoint_interval_ = interval;
+    }
+
+    const std::string& get_scan_checkpoint_file()
+    {
+        return scan_checkpoint_file_;
+    }
+
+    double get_scan_checkpoint_interval()
+    {
+        return scan_checkpoint_interval_;
+    }
+
+} // namespace at
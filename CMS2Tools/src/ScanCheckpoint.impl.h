@@ -0,0 +1,70 @@
+// c++
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace at
+{
+    namespace detail
+    {
+        template <typename Analyzer>
+        auto HasCheckpointHooksImpl(int) -> decltype
+        (
+            std::declval<Analyzer&>().Checkpoint(std::string()),
+            std::declval<Analyzer&>().Restore(std::string()),
+            std::true_type()
+        );
+
+        template <typename Analyzer>
+        std::false_type HasCheckpointHooksImpl(long);
+
+        template <typename Analyzer>
+        void CheckpointAnalyzer(Analyzer& analyzer, const std::string& file_name, std::true_type)
+        {
+            analyzer.Checkpoint(file_name);
+        }
+
+        template <typename Analyzer>
+        void CheckpointAnalyzer(Analyzer&, const std::string&, std::false_type)
+        {
+            throw std::logic_error("[at::ScanCheckpointer] Error: the analyzer has no Checkpoint/Restore hooks");
+        }
+
+        template <typename Analyzer>
+        void RestoreAnalyzer(Analyzer& analyzer, const std::string& file_name, std::true_type)
+        {
+            analyzer.Restore(file_name);
+        }
+
+        template <typename Analyzer>
+        void RestoreAnalyzer(Analyzer&, const std::string&, std::false_type)
+        {
+            throw std::logic_error("[at::ScanCheckpointer] Error: the analyzer has no Checkpoint/Restore hooks");
+        }
+
+    } // namespace detail
+
+    template <typename Analyzer>
+    struct HasCheckpointHooks : decltype(detail::HasCheckpointHooksImpl<Analyzer>(0))
+    {
+    };
+
+    template <typename Analyzer>
+    void ScanCheckpointer::Save(const ScanCheckpoint& position, Analyzer& analyzer, const BadFileReport& bad_files)
+    {
+        const unsigned int generation = m_generation + 1;
+        detail::CheckpointAnalyzer(analyzer, AnalyzerFileName(generation), HasCheckpointHooks<Analyzer>());
+        SaveDuplicates(generation);
+        SaveBadFiles(generation, bad_files);
+        Commit(position, generation);
+    }
+
+    template <typename Analyzer>
+    void ScanCheckpointer::Restore(Analyzer& analyzer, BadFileReport& bad_files) const
+    {
+        detail::RestoreAnalyzer(analyzer, AnalyzerFileName(m_generation), HasCheckpointHooks<Analyzer>());
+        RestoreDuplicates();
+        RestoreBadFiles(bad_files);
+    }
+
+} // namespace at
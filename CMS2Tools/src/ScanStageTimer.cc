@@ -0,0 +1,227 @@
+#include "AnalysisTools/CMS2Tools/interface/ScanStageTimer.h"
+
+// c++
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace at
+{
+    const char* GetScanStageName(const ScanStage::value_type stage)
+    {
+        switch (stage)
+        {
+            case ScanStage::FILE_OPEN : return "file_open";
+            case ScanStage::READ_ID   : return "read_id";
+            case ScanStage::FILTER    : return "filter";
+            case ScanStage::GET_ENTRY : return "get_entry";
+            case ScanStage::ANALYZE   : return "analyze";
+            case ScanStage::FILE_CLOSE: return "file_close";
+            default: throw std::invalid_argument("[at::GetScanStageName] Error: stage out of range");
+        }
+    }
+
+    ScanStageTimer::ScanStageTimer(const bool histograms)
+        : m_histograms(histograms)
+        , m_current(ScanStage::static_size)
+        , m_mark()
+        , m_durations(ScanStage::static_size, clock_type::duration::zero())
+        , m_counts(ScanStage::static_size, 0)
+        , m_histogram_bins(histograms ? ScanStage::static_size * num_histogram_bins : 0, 0)
+    {
+    }
+
+    void ScanStageTimer::Add(const ScanStage::value_type stage, const clock_type::duration& duration)
+    {
+        m_durations[stage] += duration;
+        m_counts[stage]++;
+        if (m_histograms)
+        {
+            // floor(log2(ns))
+            unsigned long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            size_t bin = 0;
+            while (ns > 1 && bin + 1 < num_histogram_bins)
+            {
+                ns >>= 1;
+                ++bin;
+            }
+            m_histogram_bins[stage * num_histogram_bins + bin]++;
+        }
+    }
+
+    void ScanStageTimer::Stop()
+    {
+        if (m_current != ScanStage::static_size)
+        {
+            Add(m_current, clock_type::now() - m_mark);
+        }
+        m_current = ScanStage::static_size;
+    }
+
+    void ScanStageTimer::Merge(const ScanStageTimer& other)
+    {
+        for (size_t stage = 0; stage != ScanStage::static_size; ++stage)
+        {
+            m_durations[stage] += other.m_durations[stage];
+            m_counts[stage]    += other.m_counts[stage];
+        }
+        if (m_histograms && other.m_histograms)
+        {
+            for (size_t i = 0; i != m_histogram_bins.size(); ++i)
+            {
+                m_histogram_bins[i] += other.m_histogram_bins[i];
+            }
+        }
+    }
+
+    double ScanStageTimer::Seconds(const ScanStage::value_type stage) const
+    {
+        return std::chrono::duration<double>(m_durations.at(stage)).count();
+    }
+
+    unsigned long ScanStageTimer::Count(const ScanStage::value_type stage) const
+    {
+        return m_counts.at(stage);
+    }
+
+    double ScanStageTimer::TotalSeconds() const
+    {
+        double result = 0.0;
+        for (size_t stage = 0; stage != ScanStage::static_size; ++stage)
+        {
+            result += Seconds(static_cast<ScanStage::value_type>(stage));
+        }
+        return result;
+    }
+
+    std::vector<unsigned long> ScanStageTimer::Histogram(const ScanStage::value_type stage) const
+    {
+        if (!m_histograms)
+        {
+            return std::vector<unsigned long>();
+        }
+        const std::vector<unsigned long>::const_iterator begin = m_histogram_bins.begin() + stage * num_histogram_bins;
+        return std::vector<unsigned long>(begin, begin + num_histogram_bins);
+    }
+
+    void ScanStageTimer::Print(std::ostream& out) const
+    {
+        const double total = TotalSeconds();
+        out << "stage          time (s)   fraction   mean (us)" << std::endl;
+        for (size_t i = 0; i != ScanStage::static_size; ++i)
+        {
+            const ScanStage::value_type stage = static_cast<ScanStage::value_type>(i);
+            const double seconds = Seconds(stage);
+            out << std::left  << std::setw(12) << GetScanStageName(stage) << std::right << std::fixed
+                << std::setw(11) << std::setprecision(2) << seconds
+                << std::setw(10) << std::setprecision(1) << (total > 0 ? 100.0 * seconds / total : 0.0) << "%"
+                << std::setw(12) << std::setprecision(2) << (Count(stage) ? 1e6 * seconds / Count(stage) : 0.0)
+                << std::endl;
+        }
+        out.unsetf(std::ios::fixed);
+        out << std::setprecision(6);
+    }
+
+    void ScanStageTimer::WriteJson(std::ostream& out) const
+    {
+        out << "{";
+        for (size_t i = 0; i != ScanStage::static_size; ++i)
+        {
+            const ScanStage::value_type stage = static_cast<ScanStage::value_type>(i);
+            out << (i ? ", " : "") << "\"" << GetScanStageName(stage) << "\": {"
+                << "\"seconds\": " << std::setprecision(9) << Seconds(stage) << ", "
+                << "\"count\": " << Count(stage);
+            if (m_histograms)
+            {
+                const std::vector<unsigned long> bins = Histogram(stage);
+                out << ", \"log2_ns_histogram\": [";
+                for (size_t bin = 0; bin != bins.size(); ++bin)
+                {
+                    out << (bin ? ", " : "") << bins[bin];
+                }
+                out << "]";
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+
+    void NoStageTimer::Print(std::ostream& out) const
+    {
+        out << "stages not timed (only with a scan report, see set_scan_report_file)" << std::endl;
+    }
+
+    // the report up to the stages
+    static void WriteScanReportValues
+    (
+        std::ofstream& out,
+        const std::string& file_name, 
+        const std::string& function_name,
+        const std::vector<std::pair<std::string, double> >& values
+    )
+    {
+        if (!out)
+        {
+            throw std::runtime_error("[at::WriteScanReport] Error: unable to open " + file_name);
+        }
+        out << "{\"function\": \"" << function_name << "\"";
+        for (size_t i = 0; i != values.size(); ++i)
+        {
+            out << ", \"" << values[i].first << "\": " << std::setprecision(12) << values[i].second;
+        }
+    }
+
+    void WriteScanReport
+    (
+        const std::string& file_name, 
+        const std::string& function_name,
+        const std::vector<std::pair<std::string, double> >& values,
+        const ScanStageTimer& timer
+    )
+    {
+        std::ofstream out(file_name.c_str());
+        WriteScanReportValues(out, file_name, function_name, values);
+        out << ", \"stages\": ";
+        timer.WriteJson(out);
+        out << "}" << std::endl;
+    }
+
+    void WriteScanReport
+    (
+        const std::string& file_name, 
+        const std::string& function_name,
+        const std::vector<std::pair<std::string, double> >& values,
+        const NoStageTimer& /*timer*/
+    )
+    {
+        std::ofstream out(file_name.c_str());
+        WriteScanReportValues(out, file_name, function_name, values);
+        out << "}" << std::endl;
+    }
+
+    // the report written by the ScanChain functions
+    static std::string scan_report_file_;
+    static bool scan_timing_histograms_ = false;
+
+    void set_scan_report_file(const std::string& file_name)
+    {
+        scan_report_file_ = file_name;
+    }
+
+    const std::string& get_scan_report_file()
+    {
+        return scan_report_file_;
+    }
+
+    void set_scan_timing_histograms(const bool histograms)
+    {
+        scan_timing_histograms_ = histograms;
+    }
+
+    bool get_scan_timing_histograms()
+    {
+        return scan_timing_histograms_;
+    }
+
+} // namespace at
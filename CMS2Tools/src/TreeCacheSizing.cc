@@ -0,0 +1,241 @@
+#include "AnalysisTools/CMS2Tools/interface/TreeCacheSizing.h"
+
+// c++
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+
+// ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TTreeCache.h"
+#include "TObjArray.h"
+#include "TString.h"
+
+namespace at
+{
+    // smallest cache worth having
+    static const long long min_tree_cache_size_ = 1024*1024;
+
+    // the baskets don't end on entry boundaries
+    static const double tree_cache_margin_ = 1.1;
+
+    // compressed bytes per entry of the branches that will be read
+    double GetBytesPerEntry(TTree& tree, const std::vector<std::string>& branch_names)
+    {
+        const double num_entries = tree.GetEntries();
+        if (num_entries <= 0)
+        {
+            return 0.0;
+        }
+
+        double bytes = 0.0;
+        if (branch_names.empty())
+        {
+            TObjArray* const branches = tree.GetListOfBranches();
+            for (int i = 0; branches && i < branches->GetEntries(); ++i)
+            {
+                TBranch* const branch = static_cast<TBranch*>(branches->At(i));
+                if (tree.GetBranchStatus(branch->GetName()))
+                {
+                    bytes += branch->GetZipBytes("*");
+                }
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i != branch_names.size(); ++i)
+            {
+                TBranch* const branch = tree.GetBranch(branch_names[i].c_str());
+                if (branch)
+                {
+                    bytes += branch->GetZipBytes("*");
+                }
+            }
+        }
+        return bytes / num_entries;
+    }
+
+    // number of entries in a cluster of the tree
+    long long GetClusterEntries(TTree& tree)
+    {
+        const long long num_entries = tree.GetEntries();
+        const long long auto_flush  = tree.GetAutoFlush();
+        if (auto_flush > 0)
+        {
+            return std::min(auto_flush, num_entries);
+        }
+
+        // auto flush < 0 --> a cluster is about -auto_flush bytes of the whole tree
+        const long long zip_bytes = tree.GetZipBytes();
+        if (auto_flush < 0 && zip_bytes > 0 && num_entries > 0)
+        {
+            const long long entries = static_cast<long long>(-auto_flush / (zip_bytes / static_cast<double>(num_entries)));
+            return std::max(1LL, std::min(entries, num_entries));
+        }
+        return num_entries;
+    }
+
+    // the clusters a TTreeCache holds
+    static int tree_cache_clusters_ = 1;
+
+    void set_tree_cache_clusters(const int clusters)
+    {
+        tree_cache_clusters_ = std::max(1, clusters);
+    }
+
+    int get_tree_cache_clusters()
+    {
+        return tree_cache_clusters_;
+    }
+
+    // the TTreeCache size the tree wants (the cache is refilled cluster by cluster so more buys nothing)
+    long long GetTreeCacheSize(TTree& tree, const std::vector<std::string>& branch_names)
+    {
+        const long long num_entries  = std::min(tree_cache_clusters_ * GetClusterEntries(tree), tree.GetEntries());
+        const long long cluster_size = static_cast<long long>(tree_cache_margin_ * GetBytesPerEntry(tree, branch_names) * num_entries);
+        return std::max(cluster_size, min_tree_cache_size_);
+    }
+
+    // the budget shared by the open files
+    static std::mutex tree_cache_mutex_;
+    static long long tree_cache_budget_ = 512*1024*1024LL;
+    static long long tree_cache_in_use_ = 0;
+
+    long long SetTreeCache(TTree& tree, const std::vector<std::string>& branch_names)
+    {
+        const long long wanted  = GetTreeCacheSize(tree, branch_names);
+        const long long cluster = std::max(static_cast<long long>(tree_cache_margin_ * GetBytesPerEntry(tree, branch_names) * GetClusterEntries(tree)), min_tree_cache_size_);
+
+        long long cache_size = 0;
+        {
+            // one cluster only if it fits in the budget
+            std::lock_guard<std::mutex> lock(tree_cache_mutex_);
+            const long long left = std::max(0LL, tree_cache_budget_ - tree_cache_in_use_);
+            cache_size = std::max(min_tree_cache_size_, std::min(wanted, std::max(std::min(cluster, left), left / 2)));
+            tree_cache_in_use_ += cache_size;
+        }
+        tree.SetCacheSize(cache_size);
+        return cache_size;
+    }
+
+    void ReleaseTreeCache(const long long cache_size)
+    {
+        std::lock_guard<std::mutex> lock(tree_cache_mutex_);
+        tree_cache_in_use_ = std::max(0LL, tree_cache_in_use_ - cache_size);
+    }
+
+    long long ShrinkTreeCache(TTree& tree, const long long cache_size)
+    {
+        const long long new_size = std::max(cache_size / 2, min_tree_cache_size_);
+        if (new_size >= cache_size)
+        {
+            return cache_size;
+        }
+        tree.SetCacheSize(new_size);
+        ReleaseTreeCache(cache_size - new_size);
+        return new_size;
+    }
+
+    void set_tree_cache_budget(const long long bytes)
+    {
+        std::lock_guard<std::mutex> lock(tree_cache_mutex_);
+        tree_cache_budget_ = bytes;
+    }
+
+    long long get_tree_cache_budget()
+    {
+        std::lock_guard<std::mutex> lock(tree_cache_mutex_);
+        return tree_cache_budget_;
+    }
+
+    long long get_tree_cache_in_use()
+    {
+        std::lock_guard<std::mutex> lock(tree_cache_mutex_);
+        return tree_cache_in_use_;
+    }
+
+    // the entries the TTreeCache learns from
+    static int tree_cache_learn_entries_ = 10;
+
+    void set_tree_cache_learn_entries(const int entries)
+    {
+        tree_cache_learn_entries_ = entries;
+    }
+
+    int get_tree_cache_learn_entries()
+    {
+        return tree_cache_learn_entries_;
+    }
+
+    // I/O statistics of the files read by a job
+    TreeCacheStats::TreeCacheStats()
+        : m_num_files(0)
+        , m_num_cached_files(0)
+        , m_read_calls(0)
+        , m_bytes_read(0)
+        , m_max_cache_size(0)
+        , m_sum_cache_size(0.0)
+        , m_sum_efficiency(0.0)
+    {
+    }
+
+    void TreeCacheStats::Add(TFile& file, TTree& tree, const long long cache_size)
+    {
+        ++m_num_files;
+        m_read_calls += file.GetReadCalls();
+        m_bytes_read += file.GetBytesRead();
+
+        TTreeCache* const cache = dynamic_cast<TTreeCache*>(file.GetCacheRead(&tree));
+        if (cache)
+        {
+            const long long size = (cache_size > 0 ? cache_size : cache->GetBufferSize());
+            ++m_num_cached_files;
+            m_sum_cache_size += size;
+            m_sum_efficiency += cache->GetEfficiency();
+            m_max_cache_size  = std::max(m_max_cache_size, size);
+        }
+    }
+
+    void TreeCacheStats::Merge(const TreeCacheStats& other)
+    {
+        m_num_files        += other.m_num_files;
+        m_num_cached_files += other.m_num_cached_files;
+        m_read_calls       += other.m_read_calls;
+        m_bytes_read       += other.m_bytes_read;
+        m_max_cache_size    = std::max(m_max_cache_size, other.m_max_cache_size);
+        m_sum_cache_size   += other.m_sum_cache_size;
+        m_sum_efficiency   += other.m_sum_efficiency;
+    }
+
+    double TreeCacheStats::MeanCacheSize() const
+    {
+        return (m_num_cached_files > 0 ? m_sum_cache_size / m_num_cached_files : 0.0);
+    }
+
+    double TreeCacheStats::MeanEfficiency() const
+    {
+        return (m_num_cached_files > 0 ? m_sum_efficiency / m_num_cached_files : 0.0);
+    }
+
+    void TreeCacheStats::Print(std::ostream& out) const
+    {
+        const double mb = 1024.0 * 1024.0;
+        out << "files read            = " << m_num_files << "\n";
+        out << "read calls            = " << m_read_calls << " (" << Form("%.1f", m_num_files > 0 ? m_read_calls / static_cast<double>(m_num_files) : 0.0) << " per file)\n";
+        out << "MB read               = " << Form("%.1f", m_bytes_read / mb) << "\n";
+        out << "TTreeCache size (MB)  = " << Form("%.1f", MeanCacheSize() / mb) << " mean, " << Form("%.1f", m_max_cache_size / mb) << " max\n";
+        out << "TTreeCache efficiency = " << Form("%.3f", MeanEfficiency()) << std::endl;
+    }
+
+    void TreeCacheStats::AppendReportValues(std::vector<std::pair<std::string, double> >& values) const
+    {
+        values.push_back(std::make_pair("read_calls"      , static_cast<double>(m_read_calls)    ));
+        values.push_back(std::make_pair("bytes_read"      , static_cast<double>(m_bytes_read)    ));
+        values.push_back(std::make_pair("cache_size_mean" , MeanCacheSize()                      ));
+        values.push_back(std::make_pair("cache_size_max"  , static_cast<double>(m_max_cache_size)));
+        values.push_back(std::make_pair("cache_efficiency", MeanEfficiency()                     ));
+    }
+
+} // namespace at
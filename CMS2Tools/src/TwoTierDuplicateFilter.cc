@@ -0,0 +1,146 @@
+#include "AnalysisTools/CMS2Tools/interface/TwoTierDuplicateFilter.h"
+#include "AnalysisTools/CMS2Tools/interface/DorkyEventIdentifier.h"
+#include "AnalysisTools/CMS2Tools/interface/Mix64.h"
+
+// c++
+#include <iostream>
+#include <iomanip>
+
+namespace at
+{
+    namespace
+    {
+        inline uint64_t hash(const DorkyEventIdentifier& id)
+        {
+            return detail::Mix64(detail::Mix64((static_cast<uint64_t>(id.run) << 32) ^ id.lumi) ^ id.event);
+        }
+
+    } // anonymous namespace
+
+    TwoTierDuplicateFilter::TwoTierDuplicateFilter(const size_t expected_size, const double false_positive_rate)
+        : m_bloom(expected_size, false_positive_rate)
+        , m_candidates()
+        , m_exact()
+        , m_recheck()
+        , m_passes()
+        , m_extending(false)
+        , m_num_prescanned(0)
+        , m_num_flagged(0)
+    {
+    }
+
+    bool TwoTierDuplicateFilter::BeginPreScan()
+    {
+        m_extending = not m_passes.empty();
+        return m_extending;
+    }
+
+    // first pass: put the id through the Bloom filter 
+    // (a new candidate of a later pre-scan may be in the earlier ones: it's rechecked) 
+    void TwoTierDuplicateFilter::PreScan(const DorkyEventIdentifier& id)
+    {
+        ++m_num_prescanned;
+        if (m_bloom.Insert(hash(id)))
+        {
+            ++m_num_flagged;
+            if (not m_candidates.Insert(id) && m_extending)
+            {
+                m_recheck.Insert(id);
+            }
+        }
+    }
+
+    size_t TwoTierDuplicateFilter::NumToRecheck() const
+    {
+        return m_recheck.Size();
+    }
+
+    // the second pass has passed the id as a non-candidate: add it to the exact set now
+    void TwoTierDuplicateFilter::Recheck(const DorkyEventIdentifier& id)
+    {
+        if (m_recheck.Contains(id))
+        {
+            m_exact.Insert(id);
+        }
+    }
+
+    void TwoTierDuplicateFilter::EndPreScan(const PreScanPass& pass)
+    {
+        m_passes.push_back(pass);
+        m_recheck.Clear();
+        m_extending = false;
+    }
+
+    const std::vector<TwoTierDuplicateFilter::PreScanPass>& TwoTierDuplicateFilter::GetPreScanPasses() const
+    {
+        return m_passes;
+    }
+
+    // second pass: returns true if the id has been seen before
+    bool TwoTierDuplicateFilter::IsDuplicate(const DorkyEventIdentifier& id)
+    {
+        if (not m_candidates.Contains(id))
+        {
+            return false;
+        }
+        return m_exact.Insert(id);
+    }
+
+    void TwoTierDuplicateFilter::SaveSecondPass(std::ostream& out) const
+    {
+        m_exact.Save(out);
+    }
+
+    void TwoTierDuplicateFilter::LoadSecondPass(std::istream& in)
+    {
+        m_exact.Load(in);
+    }
+
+    size_t TwoTierDuplicateFilter::NumPreScanned() const
+    {
+        return m_num_prescanned;
+    }
+
+    size_t TwoTierDuplicateFilter::NumFlagged() const
+    {
+        return m_num_flagged;
+    }
+
+    size_t TwoTierDuplicateFilter::NumCandidates() const
+    {
+        return m_candidates.Size();
+    }
+
+    double TwoTierDuplicateFilter::EstimatedFalsePositiveRate() const
+    {
+        return m_bloom.EstimatedFalsePositiveRate();
+    }
+
+    double TwoTierDuplicateFilter::MeasuredFalsePositiveRate(const size_t num_duplicates) const
+    {
+        const size_t num_prescanned = m_num_prescanned;
+        const size_t num_flagged    = m_num_flagged;
+        if (num_prescanned <= num_duplicates || num_flagged < num_duplicates)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(num_flagged - num_duplicates) / (num_prescanned - num_duplicates);
+    }
+
+    size_t TwoTierDuplicateFilter::MemoryUsage() const
+    {
+        return m_bloom.MemoryUsage() + m_candidates.MemoryUsage() + m_exact.MemoryUsage() + m_recheck.MemoryUsage();
+    }
+
+    void TwoTierDuplicateFilter::Print(std::ostream& out, const size_t num_duplicates) const
+    {
+        out << "duplicate filter (two tier):" << std::endl;
+        out << "  # of events pre-scanned  = " << NumPreScanned() << " (" << m_passes.size() << " pre-scans)" << std::endl; 
+        out << "  # of candidates          = " << NumCandidates() << " (" << NumFlagged() << " flagged)" << std::endl; 
+        out << "  Bloom filter             = " << m_bloom.NumBits() << " bits, " << m_bloom.NumHashes() << " hashes" << std::endl;
+        out << "  false positive rate      = " << std::setprecision(3) << MeasuredFalsePositiveRate(num_duplicates) 
+            << " (estimated " << std::setprecision(3) << EstimatedFalsePositiveRate() << ")" << std::endl;
+        out << "  memory                   = " << std::setprecision(3) << MemoryUsage()/(1024.0*1024.0) << " MB" << std::endl;
+    }
+
+} // namespace at
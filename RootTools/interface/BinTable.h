@@ -0,0 +1,96 @@
+#ifndef RT_BINTABLE_H
+#define RT_BINTABLE_H
+
+// c++ includes
+#include <cstddef>
+
+// Bin lookup tables that can be made at compile time (e.g. the pt and eta bins of a scale factor):
+//
+//     static constexpr double pt_edges[] = {10, 20, 30, 50, 100};
+//     constexpr rt::BinTable<double> pt_bins(pt_edges);       // variable bins --> binary search
+//     constexpr rt::BinTable<double> eta_bins(5, -2.5, 2.5);  // uniform bins  --> arithmetic
+//     const unsigned int i = pt_bins.find_bin(lep_pt);
+//
+// Same convention as rt::find_bin: bin i is [edges[i], edges[i+1]) and a value outside the
+// edges (or NaN) gives 0. A variable table only points at the edges so they have to outlive it.
+// (C++11: not for CINT)
+
+namespace rt
+{
+    template <typename T>
+    class BinTable
+    {
+        public:
+
+            // uniform bins
+            constexpr BinTable(const unsigned int num_bins, const T low, const T high)
+                : m_edges(NULL)
+                , m_num_bins(num_bins)
+                , m_low(low)
+                , m_high(high)
+            {
+            }
+
+            // variable bins (N edges in increasing order)
+            template <unsigned int N>
+            constexpr BinTable(const T (&edges)[N])
+                : m_edges(edges)
+                , m_num_bins(N - 1)
+                , m_low(edges[0])
+                , m_high(edges[N - 1])
+            {
+            }
+
+            constexpr unsigned int num_bins() const {return m_num_bins;}
+            constexpr bool is_uniform() const {return m_edges == NULL;}
+            constexpr T low() const {return m_low;}
+            constexpr T high() const {return m_high;}
+
+            // the low edge of bin i (i = num_bins --> high)
+            constexpr T low_edge(const unsigned int i) const
+            {
+                return (m_edges ? m_edges[i] : m_low + i * (m_high - m_low) / m_num_bins);
+            }
+
+            // the bin of the value (0 if it's outside)
+            constexpr unsigned int find_bin(const T value) const
+            {
+                return (!(m_low <= value && value < m_high) ? 0 : (m_edges ? search(value, 0, m_num_bins) : uniform_bin(value)));
+            }
+
+        private:
+
+            // same arithmetic as TAxis::FindFixBin (rounding can put a value just under high past the last bin)
+            constexpr unsigned int uniform_bin(const T value) const
+            {
+                return min_bin(static_cast<unsigned int>(m_num_bins * (value - m_low) / (m_high - m_low)));
+            }
+
+            constexpr unsigned int min_bin(const unsigned int i) const
+            {
+                return (i < m_num_bins ? i : m_num_bins - 1);
+            }
+
+            // binary search of [edges[begin], edges[end]) (tail recursive so it's a loop at run time)
+            constexpr unsigned int search(const T value, const unsigned int begin, const unsigned int end) const
+            {
+                return (end - begin <= 1 ? begin :
+                        value < m_edges[(begin + end) / 2] ? search(value, begin, (begin + end) / 2) : search(value, (begin + end) / 2, end));
+            }
+
+            const T* m_edges; // NULL for uniform bins
+            unsigned int m_num_bins;
+            T m_low;
+            T m_high;
+    };
+
+    // find a "bin" in a bin table given a value
+    template <typename T>
+    constexpr unsigned int find_bin(const T value, const BinTable<T>& bins)
+    {
+        return bins.find_bin(value);
+    }
+
+} // namespace rt
+
+#endif // RT_BINTABLE_H
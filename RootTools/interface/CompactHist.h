@@ -0,0 +1,227 @@
+#ifndef RT_COMPACTHIST_H
+#define RT_COMPACTHIST_H
+
+// c++ includes
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// ROOT includes
+class TAxis;
+class TH1;
+class TH2;
+class TH1D;
+class TH2D;
+
+// Compact histograms for filling in the event loop (not TObjects).
+// The bins (with the under/overflow bins, in ROOT's order) and the sum of the squared weights
+// are contiguous arrays and a fill is an axis lookup (arithmetic for uniform bins, a binary
+// search otherwise) and two adds: there are no virtual calls and no running statistics
+// (the mean and RMS of the TH1 made from it come from the bin contents).
+// Fill them in the event loop and convert them to TH1D/TH2D (MakeTH1/MakeTH2) at the end
+// of the job for TH1Container, TH1Overlay and the other rt:: functions.
+
+namespace rt
+{
+    // the bins of one axis
+    class CompactAxis
+    {
+        public:
+
+            // uniform bins
+            CompactAxis(const int num_bins = 1, const double low = 0.0, const double high = 1.0);
+
+            // variable bins (num_bins + 1 edges in increasing order)
+            explicit CompactAxis(const std::vector<double>& edges);
+
+            // same bins as a TAxis
+            explicit CompactAxis(const TAxis& axis);
+
+            // the bin of the value (0 --> underflow, num_bins + 1 --> overflow)
+            int FindBin(const double value) const
+            {
+                if (!(value >= m_low)) {return 0;} // also NaN
+                if (value >= m_high  ) {return m_num_bins + 1;}
+                if (m_uniform)
+                {
+                    const int bin = 1 + static_cast<int>((value - m_low) * m_inv_width);
+                    return (bin > m_num_bins ? m_num_bins : bin);
+                }
+                return static_cast<int>(std::upper_bound(m_edges.begin(), m_edges.end(), value) - m_edges.begin());
+            }
+
+            // the bins of n values (in a separate pass for uniform bins so it vectorizes)
+            void FindBins(const size_t n, const double* const values, int* const bins) const;
+
+            int GetNbins() const {return m_num_bins;}
+            double GetXmin() const {return m_low;}
+            double GetXmax() const {return m_high;}
+            bool IsUniform() const {return m_uniform;}
+            double GetBinLowEdge(const int bin) const;
+            double GetBinUpEdge(const int bin) const {return GetBinLowEdge(bin + 1);}
+
+            // the edges (num_bins + 1)
+            std::vector<double> GetEdges() const;
+
+            bool operator == (const CompactAxis& rhs) const;
+            bool operator != (const CompactAxis& rhs) const {return !(*this == rhs);}
+
+        private:
+
+            int m_num_bins;
+            double m_low;
+            double m_high;
+            double m_inv_width;
+            bool m_uniform;
+            std::vector<double> m_edges; // only for variable bins
+    };
+
+    // a 1D histogram of doubles
+    class CompactHist1D
+    {
+        public:
+
+            CompactHist1D();
+            CompactHist1D(const std::string& name, const std::string& title, const int num_bins, const double low, const double high);
+            CompactHist1D(const std::string& name, const std::string& title, const std::vector<double>& edges);
+
+            // same name, title, bins and contents as the histogram
+            explicit CompactHist1D(const TH1& hist);
+
+            // fill
+            void Fill(const double x)
+            {
+                const int bin = m_axis.FindBin(x);
+                m_sumw[bin]  += 1.0;
+                m_sumw2[bin] += 1.0;
+                ++m_entries;
+            }
+
+            void Fill(const double x, const double w)
+            {
+                const int bin = m_axis.FindBin(x);
+                m_sumw[bin]  += w;
+                m_sumw2[bin] += w * w;
+                ++m_entries;
+            }
+
+            // fill n values (weights = NULL --> 1)
+            void FillN(const size_t n, const double* const x, const double* const weights = NULL);
+            void FillN(const std::vector<double>& x);
+            void FillN(const std::vector<double>& x, const std::vector<double>& weights);
+
+            // contents
+            const std::string& GetName() const {return m_name;}
+            const std::string& GetTitle() const {return m_title;}
+            const CompactAxis& GetXaxis() const {return m_axis;}
+            int GetNbinsX() const {return m_axis.GetNbins();}
+            int FindBin(const double x) const {return m_axis.FindBin(x);}
+            double GetBinContent(const int bin) const {return m_sumw.at(bin);}
+            double GetBinError(const int bin) const;
+            double GetEntries() const {return m_entries;}
+            double Integral() const; // without the under/overflow
+
+            // the arrays (num_bins + 2)
+            const std::vector<double>& GetSumw() const {return m_sumw;}
+            const std::vector<double>& GetSumw2() const {return m_sumw2;}
+
+            // empty the bins
+            void Reset();
+
+            // add the bins of a histogram with the same binning (throws if it isn't)
+            void Add(const CompactHist1D& hist, const double scale = 1.0);
+            void Scale(const double scale);
+
+            // a TH1D with the same bins, errors (Sumw2) and entries (not in a directory; client is the owner)
+            TH1D* MakeTH1() const;
+
+        private:
+
+            std::string m_name;
+            std::string m_title;
+            CompactAxis m_axis;
+            std::vector<double> m_sumw;
+            std::vector<double> m_sumw2;
+            double m_entries;
+    };
+
+    // a 2D histogram of doubles (bin = binx + (nbinsx + 2) * biny as in ROOT)
+    class CompactHist2D
+    {
+        public:
+
+            CompactHist2D();
+            CompactHist2D
+            (
+                const std::string& name,
+                const std::string& title,
+                const int num_bins_x,
+                const double low_x,
+                const double high_x,
+                const int num_bins_y,
+                const double low_y,
+                const double high_y
+            );
+            CompactHist2D(const std::string& name, const std::string& title, const std::vector<double>& edges_x, const std::vector<double>& edges_y);
+
+            // same name, title, bins and contents as the histogram
+            explicit CompactHist2D(const TH2& hist);
+
+            // fill
+            void Fill(const double x, const double y, const double w = 1.0)
+            {
+                const int bin = m_xaxis.FindBin(x) + m_stride * m_yaxis.FindBin(y);
+                m_sumw[bin]  += w;
+                m_sumw2[bin] += w * w;
+                ++m_entries;
+            }
+
+            // fill n values (weights = NULL --> 1)
+            void FillN(const size_t n, const double* const x, const double* const y, const double* const weights = NULL);
+            void FillN(const std::vector<double>& x, const std::vector<double>& y);
+            void FillN(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& weights);
+
+            // contents
+            const std::string& GetName() const {return m_name;}
+            const std::string& GetTitle() const {return m_title;}
+            const CompactAxis& GetXaxis() const {return m_xaxis;}
+            const CompactAxis& GetYaxis() const {return m_yaxis;}
+            int GetNbinsX() const {return m_xaxis.GetNbins();}
+            int GetNbinsY() const {return m_yaxis.GetNbins();}
+            int GetBin(const int binx, const int biny) const {return binx + m_stride * biny;}
+            int FindBin(const double x, const double y) const {return GetBin(m_xaxis.FindBin(x), m_yaxis.FindBin(y));}
+            double GetBinContent(const int binx, const int biny) const {return m_sumw.at(GetBin(binx, biny));}
+            double GetBinError(const int binx, const int biny) const;
+            double GetEntries() const {return m_entries;}
+            double Integral() const; // without the under/overflow
+
+            // the arrays ((nbinsx + 2) * (nbinsy + 2))
+            const std::vector<double>& GetSumw() const {return m_sumw;}
+            const std::vector<double>& GetSumw2() const {return m_sumw2;}
+
+            // empty the bins
+            void Reset();
+
+            // add the bins of a histogram with the same binning (throws if it isn't)
+            void Add(const CompactHist2D& hist, const double scale = 1.0);
+            void Scale(const double scale);
+
+            // a TH2D with the same bins, errors (Sumw2) and entries (not in a directory; client is the owner)
+            TH2D* MakeTH2() const;
+
+        private:
+
+            std::string m_name;
+            std::string m_title;
+            CompactAxis m_xaxis;
+            CompactAxis m_yaxis;
+            int m_stride;
+            std::vector<double> m_sumw;
+            std::vector<double> m_sumw2;
+            double m_entries;
+    };
+
+} // namespace rt
+
+#endif // RT_COMPACTHIST_H
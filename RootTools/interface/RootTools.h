@@ -7,6 +7,14 @@
 // TH1Container
 #include "AnalysisTools/RootTools/interface/TH1Container.h"
 
+// compact histograms for the event loop
+#include "AnalysisTools/RootTools/interface/CompactHist.h"
+
+// compile time bin tables (C++11)
+#ifndef __CINT__
+#include "AnalysisTools/RootTools/interface/BinTable.h"
+#endif
+
 // TH1Overlay
 #include "AnalysisTools/RootTools/interface/TH1Overlay.h"
 
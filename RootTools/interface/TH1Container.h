@@ -3,6 +3,7 @@
 
 // c++ includes
 #include <string>
+#include <vector>
 #include <memory>
 
 // ROOT includes
@@ -17,6 +18,30 @@ namespace rt
     {
         public:
 
+            // A histogram looked up once (e.g. in BeginJob) to fill it without the name lookup:
+            //   TH1Container::Handle h_pt = hc.GetHandle("h_pt");
+            //   h_pt->Fill(pt);
+            // It stays valid as long as the histogram is in the container (Remove, Clear, Load, 
+            // assignment or an Add that overwrites it invalidate it); a copy of the container has its own.
+            class Handle
+            {
+                public:
+                    Handle() : m_hist(NULL) {}
+
+                    TH1* operator -> () const {return m_hist;}
+                    TH1& operator * () const {return *m_hist;}
+                    TH1* Get() const {return m_hist;}
+                    bool IsValid() const {return m_hist != NULL;}
+
+                    template <typename THType>
+                    THType& as() const {return *static_cast<THType*>(m_hist);}
+
+                private:
+                    friend class TH1Container;
+                    explicit Handle(TH1* const hist) : m_hist(hist) {}
+                    TH1* m_hist;
+            };
+
             // constructors
             TH1Container();
             ~TH1Container();
@@ -29,6 +54,17 @@ namespace rt
             TH1Container& operator-=(const TH1Container& rhs);
             void Swap(TH1Container& other);
 
+            // Replicas for multi-threaded filling (TH1::Fill is not thread safe): make one replica 
+            // per worker thread (before the threads start, Clone uses ROOT's global state), let each
+            // worker fill its own, then merge them back into this container (e.g. in EndJob).
+            // MakeReplica: a copy with the same histograms and binning but no entries.
+            // Merge: add the replicas bin by bin (with the Sumw2 errors) into the histograms of the
+            // same name; the histograms are split over num_threads threads (0 --> one per core) so 
+            // each thread only writes to its own.  Histograms only in a replica are added as copies.
+            TH1Container MakeReplica() const;
+            void Merge(const std::vector<const TH1Container*>& replicas, const unsigned int num_threads = 0);
+            void Merge(const TH1Container& replica);
+
             // add a histogram to the container 
             // (default is to skip duplicates, set overwite to write over)
             // WARNING: This take ownership of the hist pointer and will delete when the TH1Container goes out of scope! 
@@ -62,6 +98,11 @@ namespace rt
             template <typename THType>
             THType& as(const std::string& hist_name) const {TH1* const h = Hist(hist_name); return *static_cast<THType*>(h);}
 
+            // return a handle to a histogram (throws if not found)
+            Handle GetHandle(const std::string& hist_name) const;
+            Handle GetHandle(const char* hist_name) const;
+            Handle GetHandle(const TString& hist_name) const;
+
             // contains a hist?
             bool Contains(const std::string& hist_name) const;
 
@@ -77,6 +118,9 @@ namespace rt
             // get a list of all the histograms
             std::vector<std::string> GetListOfHistograms() const;
 
+            // approximate memory held by the histograms in bytes (bins, errors and the objects)
+            size_t MemoryUsage() const;
+
             // a simple viewer function (only interactive version -- not ported over yet)
             //void View();
 
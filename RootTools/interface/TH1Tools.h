@@ -285,16 +285,40 @@ namespace rt
     void Fill3D(TH3& hist, double x, double y, double z, double w = 1.0);
     void Fill3D(TH3* hist, double x, double y, double z, double w = 1.0);
     void Fill3D(TH1* hist, double x, double y, double z, double w = 1.0);
-    
+
+    // fill n values in one pass (same as calling Fill1D/Fill2D/Fill3D on each; weights = NULL --> 1)
+    // (for collections like all the jets in the event: the clamping limits are found once
+    // and the bins of uniform axes in a loop that vectorizes)
+    void Fill1D(TH1& hist, const size_t n, const double* const x, const double* const weights = NULL);
+    void Fill1D(TH1& hist, const std::vector<double>& x);
+    void Fill1D(TH1& hist, const std::vector<double>& x, const std::vector<double>& weights);
+    void Fill1D(TH1* hist, const std::vector<double>& x);
+    void Fill1D(TH1* hist, const std::vector<double>& x, const std::vector<double>& weights);
+
+    void Fill2D(TH2& hist, const size_t n, const double* const x, const double* const y, const double* const weights = NULL);
+    void Fill2D(TH2& hist, const std::vector<double>& x, const std::vector<double>& y);
+    void Fill2D(TH2& hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& weights);
+    void Fill2D(TH2* hist, const std::vector<double>& x, const std::vector<double>& y);
+    void Fill2D(TH2* hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& weights);
+
+    void Fill3D(TH3& hist, const size_t n, const double* const x, const double* const y, const double* const z, const double* const weights = NULL);
+    void Fill3D(TH3& hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z);
+    void Fill3D(TH3& hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& weights);
+    void Fill3D(TH3* hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z);
+    void Fill3D(TH3* hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& weights);
+
     // helper for low level objects 
     // -------------------------------------------------------------------------------------------------//
     
-    // find a "bin" in an const array given a value
+    // find a "bin" given a value: bin i is [bins[i], bins[i+1]) and a value outside the bins gives 0
+    // (see BinTable.h for bins made at compile time)
+
+    // find a "bin" in an const array given a value (unrolled, no branches)
     // only works on compile time arrays (e.g. float bins[] = {1,2,3};)
     template <int N> unsigned int find_bin(const float value, const float (&bins)[N]);
     template <int N> unsigned int find_bin(const double value, const double (&bins)[N]);
 
-    // find a "bin" in a vector given a value
+    // find a "bin" in a vector given a value (binary search)
     unsigned int find_bin(const float value, const std::vector<float>& bins);
     unsigned int find_bin(const double value, const std::vector<double>& bins);
 
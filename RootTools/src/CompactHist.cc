@@ -0,0 +1,466 @@
+#include "AnalysisTools/RootTools/interface/CompactHist.h"
+
+// c++ includes
+#include <cmath>
+#include <stdexcept>
+
+// ROOT includes
+#include "TAxis.h"
+#include "TArrayD.h"
+#include "TH1.h"
+#include "TH2.h"
+
+namespace rt
+{
+    // number of values FillN finds the bins of in one pass
+    static const size_t fill_chunk_size = 256;
+
+    // axis
+    // ---------------------------------------------------------------------------------------- //
+
+    CompactAxis::CompactAxis(const int num_bins, const double low, const double high)
+        : m_num_bins(num_bins)
+        , m_low(low)
+        , m_high(high)
+        , m_inv_width(0.0)
+        , m_uniform(true)
+    {
+        if (num_bins < 1 || !(low < high))
+        {
+            throw std::invalid_argument("[rt::CompactAxis] Error: needs at least one bin and low < high");
+        }
+        m_inv_width = num_bins / (high - low);
+    }
+
+    CompactAxis::CompactAxis(const std::vector<double>& edges)
+        : m_num_bins(static_cast<int>(edges.size()) - 1)
+        , m_low(edges.empty() ? 0.0 : edges.front())
+        , m_high(edges.empty() ? 0.0 : edges.back())
+        , m_inv_width(0.0)
+        , m_uniform(false)
+        , m_edges(edges)
+    {
+        if (m_num_bins < 1)
+        {
+            throw std::invalid_argument("[rt::CompactAxis] Error: needs at least two edges");
+        }
+        for (int i = 0; i != m_num_bins; ++i)
+        {
+            if (!(edges[i] < edges[i + 1]))
+            {
+                throw std::invalid_argument("[rt::CompactAxis] Error: the edges are not in increasing order");
+            }
+        }
+    }
+
+    CompactAxis::CompactAxis(const TAxis& axis)
+        : m_num_bins(axis.GetNbins())
+        , m_low(axis.GetXmin())
+        , m_high(axis.GetXmax())
+        , m_inv_width(0.0)
+        , m_uniform(axis.GetXbins()->GetSize() == 0)
+    {
+        if (m_uniform)
+        {
+            m_inv_width = m_num_bins / (m_high - m_low);
+        }
+        else
+        {
+            m_edges.assign(axis.GetXbins()->GetArray(), axis.GetXbins()->GetArray() + axis.GetXbins()->GetSize());
+        }
+    }
+
+    void CompactAxis::FindBins(const size_t n, const double* const values, int* const bins) const
+    {
+        if (not m_uniform)
+        {
+            for (size_t i = 0; i != n; ++i)
+            {
+                bins[i] = FindBin(values[i]);
+            }
+            return;
+        }
+
+        // no branches so the loop vectorizes: the position is clamped to [0, num_bins] 
+        // (NaN --> 0) before it is converted and the under/overflow are picked after
+        const double low       = m_low;
+        const double high      = m_high;
+        const double inv_width = m_inv_width;
+        const int num_bins     = m_num_bins;
+        for (size_t i = 0; i != n; ++i)
+        {
+            const double value    = values[i];
+            const double position = std::min(static_cast<double>(num_bins), std::max(0.0, (value - low) * inv_width));
+            const int bin         = std::min(1 + static_cast<int>(position), num_bins);
+            bins[i] = (value >= high ? num_bins + 1 : (value >= low ? bin : 0));
+        }
+    }
+
+    double CompactAxis::GetBinLowEdge(const int bin) const
+    {
+        if (m_uniform)
+        {
+            return m_low + (bin - 1) * (m_high - m_low) / m_num_bins;
+        }
+        if (bin < 1             ) {return -HUGE_VAL;}
+        if (bin > m_num_bins + 1) {return HUGE_VAL; }
+        return m_edges[bin - 1];
+    }
+
+    std::vector<double> CompactAxis::GetEdges() const
+    {
+        if (not m_uniform)
+        {
+            return m_edges;
+        }
+        std::vector<double> result(m_num_bins + 1);
+        for (int bin = 1; bin <= m_num_bins + 1; ++bin)
+        {
+            result[bin - 1] = GetBinLowEdge(bin);
+        }
+        return result;
+    }
+
+    bool CompactAxis::operator == (const CompactAxis& rhs) const
+    {
+        return m_num_bins == rhs.m_num_bins && m_low == rhs.m_low && m_high == rhs.m_high && m_uniform == rhs.m_uniform && m_edges == rhs.m_edges;
+    }
+
+    // helpers
+    // ---------------------------------------------------------------------------------------- //
+
+    // a TH1 is not in a directory when the client owns it
+    template <typename TH1Type>
+    static TH1Type* Detach(TH1Type* const hist)
+    {
+        hist->SetDirectory(NULL);
+        return hist;
+    }
+
+    // copy the bins, errors and entries into a new TH1D/TH2D
+    // (the mean and RMS are computed from the bins)
+    static void CopyBins(TH1& hist, TArrayD& bins, const std::vector<double>& sumw, const std::vector<double>& sumw2, const double entries)
+    {
+        hist.Sumw2();
+        bins.Set(static_cast<int>(sumw.size()), &sumw[0]);
+        hist.GetSumw2()->Set(static_cast<int>(sumw2.size()), &sumw2[0]);
+        hist.ResetStats();
+        hist.SetEntries(entries);
+    }
+
+    // 1D
+    // ---------------------------------------------------------------------------------------- //
+
+    CompactHist1D::CompactHist1D()
+        : m_axis()
+        , m_sumw(3, 0.0)
+        , m_sumw2(3, 0.0)
+        , m_entries(0.0)
+    {
+    }
+
+    CompactHist1D::CompactHist1D(const std::string& name, const std::string& title, const int num_bins, const double low, const double high)
+        : m_name(name)
+        , m_title(title)
+        , m_axis(num_bins, low, high)
+        , m_sumw(num_bins + 2, 0.0)
+        , m_sumw2(num_bins + 2, 0.0)
+        , m_entries(0.0)
+    {
+    }
+
+    CompactHist1D::CompactHist1D(const std::string& name, const std::string& title, const std::vector<double>& edges)
+        : m_name(name)
+        , m_title(title)
+        , m_axis(edges)
+        , m_sumw(m_axis.GetNbins() + 2, 0.0)
+        , m_sumw2(m_axis.GetNbins() + 2, 0.0)
+        , m_entries(0.0)
+    {
+    }
+
+    CompactHist1D::CompactHist1D(const TH1& hist)
+        : m_name(hist.GetName())
+        , m_title(hist.GetTitle())
+        , m_axis(*hist.GetXaxis())
+        , m_sumw(m_axis.GetNbins() + 2, 0.0)
+        , m_sumw2(m_axis.GetNbins() + 2, 0.0)
+        , m_entries(hist.GetEntries())
+    {
+        for (int bin = 0; bin != static_cast<int>(m_sumw.size()); ++bin)
+        {
+            const double error = hist.GetBinError(bin);
+            m_sumw[bin]  = hist.GetBinContent(bin);
+            m_sumw2[bin] = error * error;
+        }
+    }
+
+    void CompactHist1D::FillN(const size_t n, const double* const x, const double* const weights)
+    {
+        int bins[fill_chunk_size];
+        for (size_t begin = 0; begin < n; begin += fill_chunk_size)
+        {
+            const size_t size = std::min(fill_chunk_size, n - begin);
+            m_axis.FindBins(size, x + begin, bins);
+            if (weights)
+            {
+                for (size_t i = 0; i != size; ++i)
+                {
+                    const double w = weights[begin + i];
+                    m_sumw[bins[i]]  += w;
+                    m_sumw2[bins[i]] += w * w;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i != size; ++i)
+                {
+                    m_sumw[bins[i]]  += 1.0;
+                    m_sumw2[bins[i]] += 1.0;
+                }
+            }
+        }
+        m_entries += n;
+    }
+
+    void CompactHist1D::FillN(const std::vector<double>& x)
+    {
+        if (x.empty()) {return;}
+        FillN(x.size(), &x[0]);
+    }
+
+    void CompactHist1D::FillN(const std::vector<double>& x, const std::vector<double>& weights)
+    {
+        if (x.size() != weights.size())
+        {
+            throw std::invalid_argument("[rt::CompactHist1D::FillN] Error: " + m_name + ": the values and weights have different sizes");
+        }
+        if (x.empty()) {return;}
+        FillN(x.size(), &x[0], &weights[0]);
+    }
+
+    double CompactHist1D::GetBinError(const int bin) const
+    {
+        return std::sqrt(m_sumw2.at(bin));
+    }
+
+    double CompactHist1D::Integral() const
+    {
+        double result = 0.0;
+        for (size_t bin = 1; bin + 1 < m_sumw.size(); ++bin)
+        {
+            result += m_sumw[bin];
+        }
+        return result;
+    }
+
+    void CompactHist1D::Reset()
+    {
+        std::fill(m_sumw.begin() , m_sumw.end() , 0.0);
+        std::fill(m_sumw2.begin(), m_sumw2.end(), 0.0);
+        m_entries = 0.0;
+    }
+
+    void CompactHist1D::Add(const CompactHist1D& hist, const double scale)
+    {
+        if (m_axis != hist.m_axis)
+        {
+            throw std::invalid_argument("[rt::CompactHist1D::Add] Error: " + m_name + " and " + hist.m_name + " have different bins");
+        }
+        for (size_t bin = 0; bin != m_sumw.size(); ++bin)
+        {
+            m_sumw[bin]  += scale * hist.m_sumw[bin];
+            m_sumw2[bin] += scale * scale * hist.m_sumw2[bin];
+        }
+        m_entries += hist.m_entries;
+    }
+
+    void CompactHist1D::Scale(const double scale)
+    {
+        for (size_t bin = 0; bin != m_sumw.size(); ++bin)
+        {
+            m_sumw[bin]  *= scale;
+            m_sumw2[bin] *= scale * scale;
+        }
+    }
+
+    TH1D* CompactHist1D::MakeTH1() const
+    {
+        TH1D* const hist = (m_axis.IsUniform() ?
+            Detach(new TH1D(m_name.c_str(), m_title.c_str(), m_axis.GetNbins(), m_axis.GetXmin(), m_axis.GetXmax())) :
+            Detach(new TH1D(m_name.c_str(), m_title.c_str(), m_axis.GetNbins(), &m_axis.GetEdges()[0])));
+        CopyBins(*hist, *hist, m_sumw, m_sumw2, m_entries);
+        return hist;
+    }
+
+    // 2D
+    // ---------------------------------------------------------------------------------------- //
+
+    CompactHist2D::CompactHist2D()
+        : m_xaxis()
+        , m_yaxis()
+        , m_stride(3)
+        , m_sumw(9, 0.0)
+        , m_sumw2(9, 0.0)
+        , m_entries(0.0)
+    {
+    }
+
+    CompactHist2D::CompactHist2D
+    (
+        const std::string& name,
+        const std::string& title,
+        const int num_bins_x,
+        const double low_x,
+        const double high_x,
+        const int num_bins_y,
+        const double low_y,
+        const double high_y
+    )
+        : m_name(name)
+        , m_title(title)
+        , m_xaxis(num_bins_x, low_x, high_x)
+        , m_yaxis(num_bins_y, low_y, high_y)
+        , m_stride(num_bins_x + 2)
+        , m_sumw((num_bins_x + 2) * (num_bins_y + 2), 0.0)
+        , m_sumw2((num_bins_x + 2) * (num_bins_y + 2), 0.0)
+        , m_entries(0.0)
+    {
+    }
+
+    CompactHist2D::CompactHist2D(const std::string& name, const std::string& title, const std::vector<double>& edges_x, const std::vector<double>& edges_y)
+        : m_name(name)
+        , m_title(title)
+        , m_xaxis(edges_x)
+        , m_yaxis(edges_y)
+        , m_stride(m_xaxis.GetNbins() + 2)
+        , m_sumw((m_xaxis.GetNbins() + 2) * (m_yaxis.GetNbins() + 2), 0.0)
+        , m_sumw2((m_xaxis.GetNbins() + 2) * (m_yaxis.GetNbins() + 2), 0.0)
+        , m_entries(0.0)
+    {
+    }
+
+    CompactHist2D::CompactHist2D(const TH2& hist)
+        : m_name(hist.GetName())
+        , m_title(hist.GetTitle())
+        , m_xaxis(*hist.GetXaxis())
+        , m_yaxis(*hist.GetYaxis())
+        , m_stride(m_xaxis.GetNbins() + 2)
+        , m_sumw((m_xaxis.GetNbins() + 2) * (m_yaxis.GetNbins() + 2), 0.0)
+        , m_sumw2((m_xaxis.GetNbins() + 2) * (m_yaxis.GetNbins() + 2), 0.0)
+        , m_entries(hist.GetEntries())
+    {
+        for (int bin = 0; bin != static_cast<int>(m_sumw.size()); ++bin)
+        {
+            const double error = hist.GetBinError(bin);
+            m_sumw[bin]  = hist.GetBinContent(bin);
+            m_sumw2[bin] = error * error;
+        }
+    }
+
+    void CompactHist2D::FillN(const size_t n, const double* const x, const double* const y, const double* const weights)
+    {
+        int bins_x[fill_chunk_size];
+        int bins_y[fill_chunk_size];
+        for (size_t begin = 0; begin < n; begin += fill_chunk_size)
+        {
+            const size_t size = std::min(fill_chunk_size, n - begin);
+            m_xaxis.FindBins(size, x + begin, bins_x);
+            m_yaxis.FindBins(size, y + begin, bins_y);
+            for (size_t i = 0; i != size; ++i)
+            {
+                const int bin  = bins_x[i] + m_stride * bins_y[i];
+                const double w = (weights ? weights[begin + i] : 1.0);
+                m_sumw[bin]  += w;
+                m_sumw2[bin] += w * w;
+            }
+        }
+        m_entries += n;
+    }
+
+    void CompactHist2D::FillN(const std::vector<double>& x, const std::vector<double>& y)
+    {
+        if (x.size() != y.size())
+        {
+            throw std::invalid_argument("[rt::CompactHist2D::FillN] Error: " + m_name + ": the x and y values have different sizes");
+        }
+        if (x.empty()) {return;}
+        FillN(x.size(), &x[0], &y[0]);
+    }
+
+    void CompactHist2D::FillN(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& weights)
+    {
+        if (x.size() != y.size() || x.size() != weights.size())
+        {
+            throw std::invalid_argument("[rt::CompactHist2D::FillN] Error: " + m_name + ": the values and weights have different sizes");
+        }
+        if (x.empty()) {return;}
+        FillN(x.size(), &x[0], &y[0], &weights[0]);
+    }
+
+    double CompactHist2D::GetBinError(const int binx, const int biny) const
+    {
+        return std::sqrt(m_sumw2.at(GetBin(binx, biny)));
+    }
+
+    double CompactHist2D::Integral() const
+    {
+        double result = 0.0;
+        for (int biny = 1; biny <= m_yaxis.GetNbins(); ++biny)
+        {
+            for (int binx = 1; binx <= m_xaxis.GetNbins(); ++binx)
+            {
+                result += m_sumw[GetBin(binx, biny)];
+            }
+        }
+        return result;
+    }
+
+    void CompactHist2D::Reset()
+    {
+        std::fill(m_sumw.begin() , m_sumw.end() , 0.0);
+        std::fill(m_sumw2.begin(), m_sumw2.end(), 0.0);
+        m_entries = 0.0;
+    }
+
+    void CompactHist2D::Add(const CompactHist2D& hist, const double scale)
+    {
+        if (m_xaxis != hist.m_xaxis || m_yaxis != hist.m_yaxis)
+        {
+            throw std::invalid_argument("[rt::CompactHist2D::Add] Error: " + m_name + " and " + hist.m_name + " have different bins");
+        }
+        for (size_t bin = 0; bin != m_sumw.size(); ++bin)
+        {
+            m_sumw[bin]  += scale * hist.m_sumw[bin];
+            m_sumw2[bin] += scale * scale * hist.m_sumw2[bin];
+        }
+        m_entries += hist.m_entries;
+    }
+
+    void CompactHist2D::Scale(const double scale)
+    {
+        for (size_t bin = 0; bin != m_sumw.size(); ++bin)
+        {
+            m_sumw[bin]  *= scale;
+            m_sumw2[bin] *= scale * scale;
+        }
+    }
+
+    TH2D* CompactHist2D::MakeTH2() const
+    {
+        TH2D* hist = NULL;
+        if (m_xaxis.IsUniform() && m_yaxis.IsUniform())
+        {
+            hist = Detach(new TH2D(m_name.c_str(), m_title.c_str(), m_xaxis.GetNbins(), m_xaxis.GetXmin(), m_xaxis.GetXmax(), m_yaxis.GetNbins(), m_yaxis.GetXmin(), m_yaxis.GetXmax()));
+        }
+        else
+        {
+            const std::vector<double> edges_x = m_xaxis.GetEdges();
+            const std::vector<double> edges_y = m_yaxis.GetEdges();
+            hist = Detach(new TH2D(m_name.c_str(), m_title.c_str(), m_xaxis.GetNbins(), &edges_x[0], m_yaxis.GetNbins(), &edges_y[0]));
+        }
+        CopyBins(*hist, *hist, m_sumw, m_sumw2, m_entries);
+        return hist;
+    }
+
+} // namespace rt
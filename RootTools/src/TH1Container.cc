@@ -8,12 +8,24 @@
 #include <iomanip>
 #include <string>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+#include <functional>
 
 // Root includes
 #include "TClass.h"
 #include "TDirectory.h"
 #include "TPad.h"
 #include "TCanvas.h"
+#include "TArrayD.h"
+#include "TArrayF.h"
+#include "TArrayI.h"
+#include "TArrayS.h"
+#include "TArrayC.h"
 
 // boost includes
 #include <boost/shared_ptr.hpp>
@@ -34,12 +46,125 @@ namespace rt
     // declare data struct
     // ---------------------------------------------------------------------------------------- //
 
+    // The histograms in the order they were added and an open addressing hash table of
+    // their names (a lookup hashes the name once and compares one or two of them).
     struct TH1Container::impl
     {
         static bool verbose;
-        map<string, TH1Ptr> hist_map;
+
+        struct Entry
+        {
+            string name;
+            size_t hash;
+            TH1Ptr hist;
+        };
+        vector<Entry> hists;
+
+        // index into hists (-1 --> empty); the size is a power of 2 and at most half of it is used
+        vector<int> slots;
+
+        static size_t Hash(const char* name, const size_t length);
+        int Find(const char* name, const size_t length) const;
+        int Find(const string& name) const {return Find(name.c_str(), name.size());}
+        TH1* Get(const char* name, const size_t length) const;
+        void Insert(const string& name, const TH1Ptr& hist);
+        void Erase(const string& name);
+        void Clear();
+        void Rehash(const size_t num_slots);
+
+        // the indices of hists sorted by name (the order of the outputs)
+        vector<size_t> SortedIndices() const;
+        struct NameLess
+        {
+            explicit NameLess(const vector<Entry>& hists_) : hists(hists_) {}
+            bool operator () (const size_t lhs, const size_t rhs) const {return hists[lhs].name < hists[rhs].name;}
+            const vector<Entry>& hists;
+        };
     };
 
+    // FNV-1a
+    size_t TH1Container::impl::Hash(const char* const name, const size_t length)
+    {
+        uint64_t result = 14695981039346656037ull;
+        for (size_t i = 0; i != length; ++i)
+        {
+            result ^= static_cast<unsigned char>(name[i]);
+            result *= 1099511628211ull;
+        }
+        return static_cast<size_t>(result);
+    }
+
+    int TH1Container::impl::Find(const char* const name, const size_t length) const
+    {
+        if (slots.empty())
+        {
+            return -1;
+        }
+        const size_t hash = Hash(name, length);
+        const size_t mask = slots.size() - 1;
+        for (size_t index = hash & mask; slots[index] >= 0; index = (index + 1) & mask)
+        {
+            const Entry& entry = hists[slots[index]];
+            if (entry.hash == hash && entry.name.size() == length && entry.name.compare(0, length, name, length) == 0)
+            {
+                return slots[index];
+            }
+        }
+        return -1;
+    }
+
+    void TH1Container::impl::Insert(const string& name, const TH1Ptr& hist)
+    {
+        if (2 * (hists.size() + 1) > slots.size())
+        {
+            Rehash(std::max<size_t>(16, 2 * slots.size()));
+        }
+        const Entry entry = {name, Hash(name.c_str(), name.size()), hist};
+        hists.push_back(entry);
+        const size_t mask = slots.size() - 1;
+        size_t index = entry.hash & mask;
+        while (slots[index] >= 0) {index = (index + 1) & mask;}
+        slots[index] = static_cast<int>(hists.size() - 1);
+    }
+
+    void TH1Container::impl::Erase(const string& name)
+    {
+        const int index = Find(name);
+        if (index < 0)
+        {
+            return;
+        }
+        // removing is rare: take it out of the list and index the rest again
+        hists.erase(hists.begin() + index);
+        Rehash(slots.size());
+    }
+
+    void TH1Container::impl::Clear()
+    {
+        hists.clear();
+        slots.clear();
+    }
+
+    void TH1Container::impl::Rehash(const size_t num_slots)
+    {
+        slots.assign(num_slots, -1);
+        const size_t mask = num_slots - 1;
+        for (size_t i = 0; i != hists.size(); ++i)
+        {
+            size_t index = hists[i].hash & mask;
+            while (slots[index] >= 0) {index = (index + 1) & mask;}
+            slots[index] = static_cast<int>(i);
+        }
+    }
+
+    vector<size_t> TH1Container::impl::SortedIndices() const
+    {
+        vector<size_t> result(hists.size());
+        for (size_t i = 0; i != result.size(); ++i) {result[i] = i;}
+        std::sort(result.begin(), result.end(), NameLess(hists));
+        return result;
+    }
+
 
     // constructor
     // ---------------------------------------------------------------------------------------- //
@@ -70,9 +195,10 @@ namespace rt
     TH1Container::TH1Container(const TH1Container& rhs)
         : m_pimpl(new TH1Container::impl)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = rhs.m_pimpl->hist_map.begin(); iter != rhs.m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != rhs.m_pimpl->hists.size(); ++i)
         {
-            m_pimpl->hist_map[iter->first] = TH1Ptr(dynamic_cast<TH1*>(iter->second->Clone()));   
+            const impl::Entry& entry = rhs.m_pimpl->hists[i];
+            m_pimpl->Insert(entry.name, TH1Ptr(dynamic_cast<TH1*>(entry.hist->Clone())));
         }
         return;
     }
@@ -80,7 +206,8 @@ namespace rt
     void TH1Container::Swap(TH1Container& rhs)
     {
         std::swap(m_pimpl->verbose , rhs.m_pimpl->verbose );
-        std::swap(m_pimpl->hist_map, rhs.m_pimpl->hist_map);
+        std::swap(m_pimpl->hists   , rhs.m_pimpl->hists   );
+        std::swap(m_pimpl->slots   , rhs.m_pimpl->slots   );
         return;
     }
 
@@ -92,21 +219,109 @@ namespace rt
     }
 
 
+    // replicas
+    // ---------------------------------------------------------------------------------------- //
+
+    TH1Container TH1Container::MakeReplica() const
+    {
+        TH1Container result(*this);
+        for (size_t i = 0; i != result.m_pimpl->hists.size(); ++i)
+        {
+            result.m_pimpl->hists[i].hist->Reset();
+        }
+        return result;
+    }
+
+    void TH1Container::Merge(const std::vector<const TH1Container*>& replicas, const unsigned int num_threads)
+    {
+        const vector<impl::Entry>& hists = m_pimpl->hists;
+
+        // the histograms of the replicas to add to each of ours (a replica usually has the 
+        // same order so the names are only looked up when it doesn't) 
+        vector<vector<const TH1*> > sources(hists.size());
+        vector<const TH1*> missing;
+        for (size_t r = 0; r != replicas.size(); ++r)
+        {
+            if (!replicas[r] || replicas[r] == this) {continue;}
+            const vector<impl::Entry>& replica_hists = replicas[r]->m_pimpl->hists;
+            for (size_t j = 0; j != replica_hists.size(); ++j)
+            {
+                const impl::Entry& entry = replica_hists[j];
+                const int index = (j < hists.size() && hists[j].hash == entry.hash && hists[j].name == entry.name ? static_cast<int>(j) : m_pimpl->Find(entry.name));
+                if (index < 0)
+                {
+                    missing.push_back(entry.hist.get());
+                }
+                else
+                {
+                    sources[index].push_back(entry.hist.get());
+                }
+            }
+        }
+
+        // each thread takes the next histogram and adds all the replicas into it
+        // (no two threads write to the same histogram so there are no locks)
+        size_t num_workers = (num_threads > 0 ? num_threads : std::thread::hardware_concurrency());
+        num_workers = std::max<size_t>(1, std::min(num_workers, hists.size()));
+        std::atomic<size_t> next_hist(0);
+        const std::function<void()> add_replicas = [&hists, &sources, &next_hist]()
+        {
+            for (size_t i = next_hist++; i < hists.size(); i = next_hist++)
+            {
+                for (size_t k = 0; k != sources[i].size(); ++k)
+                {
+                    hists[i].hist->Add(sources[i][k]);
+                }
+            }
+        };
+        vector<std::thread> threads;
+        for (size_t t = 1; t < num_workers; ++t)
+        {
+            threads.push_back(std::thread(add_replicas));
+        }
+        add_replicas();
+        for (size_t t = 0; t != threads.size(); ++t)
+        {
+            threads[t].join();
+        }
+
+        // the histograms we don't have
+        for (size_t i = 0; i != missing.size(); ++i)
+        {
+            const int index = m_pimpl->Find(missing[i]->GetName());
+            if (index < 0)
+            {
+                Add(*missing[i]);
+            }
+            else
+            {
+                m_pimpl->hists[index].hist->Add(missing[i]);
+            }
+        }
+    }
+
+    void TH1Container::Merge(const TH1Container& replica)
+    {
+        Merge(std::vector<const TH1Container*>(1, &replica), /*num_threads=*/1);
+    }
+
+
     // members
     // ---------------------------------------------------------------------------------------- //
 
     TH1Container TH1Container::operator+(const TH1Container& rhs)
     {
         TH1Container temp(*this);
-        for (map<string, TH1Ptr>::const_iterator iter = rhs.m_pimpl->hist_map.begin(); iter != rhs.m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != rhs.m_pimpl->hists.size(); ++i)
         {
-            if (temp.Contains(iter->first))
+            const impl::Entry& entry = rhs.m_pimpl->hists[i];
+            if (temp.Contains(entry.name))
             {
-                temp[iter->first]->Add(iter->second.get());
+                temp[entry.name]->Add(entry.hist.get());
             }
             else
             {
-                temp.Add(iter->second.get());
+                temp.Add(entry.hist.get());
             }
         }
         return temp;
@@ -122,15 +337,16 @@ namespace rt
     TH1Container TH1Container::operator-(const TH1Container& rhs)
     {
         TH1Container temp(*this);
-        for (map<string, TH1Ptr>::const_iterator iter = rhs.m_pimpl->hist_map.begin(); iter != rhs.m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != rhs.m_pimpl->hists.size(); ++i)
         {
-            if (temp.Contains(iter->first))
+            const impl::Entry& entry = rhs.m_pimpl->hists[i];
+            if (temp.Contains(entry.name))
             {
-                temp[iter->first]->Add(iter->second.get(), -1.0);
+                temp[entry.name]->Add(entry.hist.get(), -1.0);
             }
             else
             {
-                temp.Add(iter->second.get());
+                temp.Add(entry.hist.get());
             }
         }
         return temp;
@@ -147,12 +363,13 @@ namespace rt
     {
         // do we already have the histogram?
         string name = hist_ptr->GetName();
-        bool hist_name_used = m_pimpl->hist_map.end() != m_pimpl->hist_map.find(name);
+        const int index = m_pimpl->Find(name);
+        bool hist_name_used = (index >= 0);
         if (hist_name_used)
         {
             try
             {
-                bool same_pointer = (hist_ptr == m_pimpl->hist_map.at(name).get());
+                bool same_pointer = (hist_ptr == m_pimpl->hists.at(index).hist.get());
                 if (overwrite && !same_pointer)
                 {
                     cout << "[TH1Container::add()] Warning: '" << name << "' already exists.  Overwriting!" << endl;
@@ -180,7 +397,14 @@ namespace rt
 
         // I want to be in charge of deleting
         hist_ptr->SetDirectory(0);
-        m_pimpl->hist_map.insert(pair<string, TH1Ptr>(name, TH1Ptr(hist_ptr)));
+        if (hist_name_used)
+        {
+            m_pimpl->hists[index].hist = TH1Ptr(hist_ptr);
+        }
+        else
+        {
+            m_pimpl->Insert(name, TH1Ptr(hist_ptr));
+        }
         return;
     }
 
@@ -203,9 +427,9 @@ namespace rt
     // set the directory of the hists (needed for draw)
     void TH1Container::SetDirectory(TDirectory* const dir)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetDirectory(dir);
+            m_pimpl->hists[i].hist->SetDirectory(dir);
         }
     }
 
@@ -218,7 +442,7 @@ namespace rt
     // remove a histogram
     void TH1Container::Remove(const string& hist_name)
     {
-        m_pimpl->hist_map.erase(hist_name);
+        m_pimpl->Erase(hist_name);
     }
 
     void TH1Container::Remove(const char* hist_name)
@@ -237,28 +461,32 @@ namespace rt
     }
 
     // return a histogram (throws if not found)
-    TH1* TH1Container::Hist(const std::string& hist_name) const
+    // (the name is only copied into a std::string for the error message)
+    TH1* TH1Container::impl::Get(const char* const name, const size_t length) const
     {
-        try
-        {
-            return m_pimpl->hist_map.at(hist_name).get();
-        }
-        catch(exception& e)
+        const int index = Find(name, length);
+        if (index < 0)
         {
-            throw(std::domain_error("[rt::TH1Container::hist()] Error: " + hist_name + " not found!  Aborting."));
+            throw(std::domain_error("[rt::TH1Container::hist()] Error: " + string(name, length) + " not found!  Aborting."));
         }
+        return hists[index].hist.get();
+    }
+
+    TH1* TH1Container::Hist(const std::string& hist_name) const
+    {
+        return m_pimpl->Get(hist_name.c_str(), hist_name.size());
     }
 
 
     TH1* TH1Container::Hist(const char* hist_name) const
     {
-        return Hist(static_cast<string>(hist_name));
+        return m_pimpl->Get(hist_name, strlen(hist_name));
     }
 
 
     TH1* TH1Container::Hist(const TString& hist_name) const
     {
-        return Hist(static_cast<string>(hist_name.Data()));
+        return m_pimpl->Get(hist_name.Data(), hist_name.Length());
     }
 
 
@@ -270,23 +498,39 @@ namespace rt
 
     TH1* TH1Container::operator [] (const char* hist_name) const
     {
-        return Hist(static_cast<string>(hist_name));
+        return Hist(hist_name);
     }
 
 
     TH1* TH1Container::operator [] (const TString& hist_name) const
     {
-        return Hist(static_cast<string>(hist_name.Data()));
+        return Hist(hist_name);
+    }
+
+    // a handle to a histogram (throws if not found)
+    TH1Container::Handle TH1Container::GetHandle(const std::string& hist_name) const
+    {
+        return Handle(Hist(hist_name));
+    }
+
+    TH1Container::Handle TH1Container::GetHandle(const char* hist_name) const
+    {
+        return Handle(Hist(hist_name));
+    }
+
+    TH1Container::Handle TH1Container::GetHandle(const TString& hist_name) const
+    {
+        return Handle(Hist(hist_name));
     }
 
     bool TH1Container::Contains(const std::string& hist_name) const
     {
-        return m_pimpl->hist_map.find(hist_name) != m_pimpl->hist_map.end();
+        return m_pimpl->Find(hist_name) >= 0;
     }
 
     void TH1Container::Clear()
     {
-        m_pimpl->hist_map.clear();
+        m_pimpl->Clear();
         return;
     }
 
@@ -316,7 +560,14 @@ namespace rt
                 // I want to be in charge of deleting
                 hist_ptr->SetDirectory(0);
                 string name(hist_ptr->GetName());
-                m_pimpl->hist_map.insert(pair<string, TH1Ptr>(name, TH1Ptr(hist_ptr)));
+                if (m_pimpl->Find(name) < 0)
+                {
+                    m_pimpl->Insert(name, TH1Ptr(hist_ptr));
+                }
+                else
+                {
+                    delete hist_ptr;
+                }
             }
         }
         file->Close();
@@ -328,10 +579,12 @@ namespace rt
         cout << "[TH1Container::List()]: listing all histograms in the container" << endl;
         cout <<  "  " << setw(15) << left << "Hist Type" << "\t" << setw(15) << left << "Hist Name" << "\t" << "Hist Title" << endl; 
         cout <<  "-----------------------------------------------------------------------" << endl; 
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        const vector<size_t> order = m_pimpl->SortedIndices();
+        for (size_t i = 0; i != order.size(); ++i)
         {
-            cout <<  "  " << setw(15) << left << iter->second->ClassName() << "\t" << setw(15) << left << iter->first 
-                << "\t" << iter->second->GetTitle() << endl;
+            const impl::Entry& entry = m_pimpl->hists[order[i]];
+            cout <<  "  " << setw(15) << left << entry.hist->ClassName() << "\t" << setw(15) << left << entry.name 
+                << "\t" << entry.hist->GetTitle() << endl;
         }
     }
 
@@ -339,9 +592,34 @@ namespace rt
     std::vector<string> TH1Container::GetListOfHistograms() const
     {
         std::vector<std::string> result;
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        const vector<size_t> order = m_pimpl->SortedIndices();
+        for (size_t i = 0; i != order.size(); ++i)
+        {
+            result.push_back(m_pimpl->hists[order[i]].name);
+        }
+        return result;
+    }
+
+    // approximate memory held by the histograms
+    static size_t BinContentSize(const TH1& hist)
+    {
+        if (dynamic_cast<const TArrayD*>(&hist)) {return sizeof(Double_t);}
+        if (dynamic_cast<const TArrayF*>(&hist)) {return sizeof(Float_t); }
+        if (dynamic_cast<const TArrayI*>(&hist)) {return sizeof(Int_t);   }
+        if (dynamic_cast<const TArrayS*>(&hist)) {return sizeof(Short_t); }
+        if (dynamic_cast<const TArrayC*>(&hist)) {return sizeof(Char_t);  }
+        return sizeof(Double_t);
+    }
+
+    size_t TH1Container::MemoryUsage() const
+    {
+        size_t result = 0;
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            result.push_back(iter->first);
+            const TH1& hist = *m_pimpl->hists[i].hist;
+            result += hist.IsA()->Size();
+            result += hist.GetNcells() * BinContentSize(hist);
+            result += hist.GetSumw2N() * sizeof(Double_t);
         }
         return result;
     }
@@ -414,125 +692,125 @@ namespace rt
 
     void TH1Container::Scale(const double scale, const std::string& option)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->Scale(scale, option.c_str());
+            m_pimpl->hists[i].hist->Scale(scale, option.c_str());
         }
     }
 
     void TH1Container::Normalize(const double value)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            rt::Normalize(iter->second.get(), value);
+            rt::Normalize(m_pimpl->hists[i].hist.get(), value);
         }
     }
 
     void TH1Container::Sumw2()
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            if (!iter->second->GetSumw2N())
+            if (!m_pimpl->hists[i].hist->GetSumw2N())
             {
-                iter->second->Sumw2();
+                m_pimpl->hists[i].hist->Sumw2();
             }
         }
     }
 
     void TH1Container::SetLineColor(const Color_t color)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetLineColor(color);
+            m_pimpl->hists[i].hist->SetLineColor(color);
         }
     }
 
     void TH1Container::SetLineStyle(const Style_t style)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetLineStyle(style);
+            m_pimpl->hists[i].hist->SetLineStyle(style);
         }
     }
 
     void TH1Container::SetFillColor(const Color_t color)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetFillColor(color);
+            m_pimpl->hists[i].hist->SetFillColor(color);
         }
     }
 
     void TH1Container::SetFillStyle(const Style_t style)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetFillStyle(style);
+            m_pimpl->hists[i].hist->SetFillStyle(style);
         }
     }
 
     void TH1Container::SetLineWidth(const Width_t width)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetLineWidth(width);
+            m_pimpl->hists[i].hist->SetLineWidth(width);
         }
     }
 
     void TH1Container::SetMarkerColor(const Color_t color)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetMarkerColor(color);
+            m_pimpl->hists[i].hist->SetMarkerColor(color);
         }
     }
 
     void TH1Container::SetMarkerSize(const Size_t size)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetMarkerSize(size);
+            m_pimpl->hists[i].hist->SetMarkerSize(size);
         }
     }
 
     void TH1Container::SetMarkerStyle(const Style_t style)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetMarkerStyle(style);
+            m_pimpl->hists[i].hist->SetMarkerStyle(style);
         }
     }
 
     void TH1Container::SetOption(const std::string& option)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetOption(option.c_str());
+            m_pimpl->hists[i].hist->SetOption(option.c_str());
         }
     }
 
     void TH1Container::SetDrawOption(const std::string& option)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetDrawOption(option.c_str());
+            m_pimpl->hists[i].hist->SetDrawOption(option.c_str());
         }
     }
 
     void TH1Container::SetStats(const bool stats)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetStats(stats);
+            m_pimpl->hists[i].hist->SetStats(stats);
         }
     }
 
     void TH1Container::SetMinMax(const float min, const float max)
     {
-        for (map<string, TH1Ptr>::const_iterator iter = m_pimpl->hist_map.begin(); iter != m_pimpl->hist_map.end(); iter++)
+        for (size_t i = 0; i != m_pimpl->hists.size(); ++i)
         {
-            iter->second->SetMinimum(min);
-            iter->second->SetMaximum(max);
+            m_pimpl->hists[i].hist->SetMinimum(min);
+            m_pimpl->hists[i].hist->SetMaximum(max);
         }
     }
 
@@ -553,9 +831,11 @@ namespace rt
         }
         root_file->cd(root_file_dir.c_str());
 
-        for (std::map<std::string, boost::shared_ptr<TH1> >::iterator itr = m_pimpl->hist_map.begin(); itr != m_pimpl->hist_map.end(); itr++)
+        const vector<size_t> order = m_pimpl->SortedIndices();
+        for (size_t i = 0; i != order.size(); ++i)
         {
-            itr->second->Write(itr->first.c_str(), TObject::kOverwrite);
+            const impl::Entry& entry = m_pimpl->hists[order[i]];
+            entry.hist->Write(entry.name.c_str(), TObject::kOverwrite);
         }
         root_file->Close();
     }
@@ -576,16 +856,18 @@ namespace rt
 
         lt::mkdir(dir_name, /*recursive=*/true);
 
-        for (std::map<std::string, boost::shared_ptr<TH1> >::iterator itr = m_pimpl->hist_map.begin(); itr != m_pimpl->hist_map.end(); itr++)
+        const vector<size_t> order = m_pimpl->SortedIndices();
+        for (size_t i = 0; i != order.size(); ++i)
         {
-            if (!itr->second)
+            const impl::Entry& entry = m_pimpl->hists[order[i]];
+            if (!entry.hist)
             {
                 cout << "rt::Print() Warning: Object associated to " 
-                    << itr->first << " is NULL -- skipping!" << endl;
+                    << entry.name << " is NULL -- skipping!" << endl;
                 continue;
             }
-            itr->second->Draw(option.c_str());
-            c1.Print((dir_name + "/" + itr->first + "." + suffix).c_str());
+            entry.hist->Draw(option.c_str());
+            c1.Print((dir_name + "/" + entry.name + "." + suffix).c_str());
         }
         rt::CopyIndexPhp(dir_name);
         return;
@@ -13,6 +13,7 @@
 #include <iostream>
 #include <cmath>
 #include <map>
+#include <algorithm>
 
 // ROOT includes
 #include "TCanvas.h"
@@ -1252,33 +1253,26 @@ namespace rt
     }
 
     // find a "bin" in a vector given a value
-    unsigned int find_bin(const float value, const std::vector<float>& bins)
+    // (binary search: bin i is [bins[i], bins[i+1]) and a value outside the bins gives 0)
+    template <typename T>
+    static unsigned int FindBinInVector(const T value, const std::vector<T>& bins)
     {
-        unsigned int index = 0;
-        for (size_t i=0; i != bins.size()-1; i++)
+        if (bins.empty() || !(bins.front() <= value && value < bins.back()))
         {
-            if (bins[i] < value && value < bins[i+1]) 
-            {
-                index=i;
-                break;
-            }
+            return 0;
         }
-        return index;
+        return static_cast<unsigned int>(std::upper_bound(bins.begin(), bins.end(), value) - bins.begin()) - 1;
+    }
+
+    unsigned int find_bin(const float value, const std::vector<float>& bins)
+    {
+        return FindBinInVector(value, bins);
     }
 
     // find a "bin" in a vector given a value
     unsigned int find_bin(const double value, const std::vector<double>& bins)
     {
-        unsigned int index = 0;
-        for (size_t i=0; i != bins.size()-1; i++)
-        {
-            if (bins[i] < value && value < bins[i+1]) 
-            {
-                index=i;
-                break;
-            }
-        }
-        return index;
+        return FindBinInVector(value, bins);
     }
 
     // fill the hist with overflow bins
@@ -1347,7 +1341,7 @@ namespace rt
         y = std::max(hist.GetYaxis()->GetBinCenter(hist.GetYaxis()->GetFirst()), y);
         z = std::min(hist.GetZaxis()->GetBinCenter(hist.GetZaxis()->GetLast()) , z);
         z = std::max(hist.GetZaxis()->GetBinCenter(hist.GetZaxis()->GetFirst()), z);
-        Fill3D(hist, x, y, z, w);
+        hist.Fill(x, y, z, w);
     }
 
     void Fill3D(TH3* hist_ptr, double x, double y, double z, double w)
@@ -1379,4 +1373,292 @@ namespace rt
         return;
     }
 
+    // fill n values in one pass
+    // -------------------------------------------------------------------------------------------------//
+
+    // values are done in chunks so the bins fit on the stack
+    static const size_t fill_chunk_size = 256;
+
+    // clamp the values to the centres of the first and last bins (as Fill1D does) and find their bins
+    // (same bins as TAxis::FindBin; for uniform bins the loop has no branches so it vectorizes)
+    static void ClampAndFindBins(const TAxis& axis, const size_t n, const double* const values, double* const clamped, int* const bins)
+    {
+        const int first   = axis.GetFirst();
+        const int last    = axis.GetLast();
+        const double low  = axis.GetBinCenter(first);
+        const double high = axis.GetBinCenter(last);
+        if (axis.GetXbins()->GetSize() != 0)
+        {
+            for (size_t i = 0; i != n; ++i)
+            {
+                clamped[i] = std::max(low, std::min(high, values[i]));
+                bins[i]    = axis.FindFixBin(clamped[i]);
+            }
+            return;
+        }
+
+        const double num_bins = axis.GetNbins();
+        const double xmin     = axis.GetXmin();
+        const double width    = axis.GetXmax() - axis.GetXmin();
+        for (size_t i = 0; i != n; ++i)
+        {
+            const double value = std::max(low, std::min(high, values[i]));
+            const int bin      = 1 + static_cast<int>(num_bins * (value - xmin) / width);
+            clamped[i] = value;
+            bins[i]    = std::max(first, std::min(last, bin));
+        }
+    }
+
+    // can the bins and statistics be filled directly (as TH1::Fill does) or does it have to go through Fill?
+    // (profiles and TH2Poly fill differently, a buffer is filled first and the statistics of an axis
+    // with a range are recomputed from the bins)
+    static bool CanFillBins(TH1& hist, const int dimension)
+    {
+        if (hist.GetDimension() != dimension || hist.GetBufferSize() != 0)
+        {
+            return false;
+        }
+        if (hist.InheritsFrom("TProfile") || hist.InheritsFrom("TProfile2D") || hist.InheritsFrom("TProfile3D") || hist.InheritsFrom("TH2Poly"))
+        {
+            return false;
+        }
+        const TAxis* const axes[3] = {hist.GetXaxis(), hist.GetYaxis(), hist.GetZaxis()};
+        for (int i = 0; i != dimension; ++i)
+        {
+            if (axes[i]->TestBit(TAxis::kAxisRange))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // values[d] are the values of the axis d (d < dimension)
+    static void FillN(TH1& hist, const int dimension, const size_t n, const double* const values[3], const double* const weights)
+    {
+        const TAxis* const axes[3] = {hist.GetXaxis(), hist.GetYaxis(), hist.GetZaxis()};
+        double clamped[3][fill_chunk_size];
+        int bins[3][fill_chunk_size];
+
+        if (not CanFillBins(hist, dimension))
+        {
+            for (size_t begin = 0; begin < n; begin += fill_chunk_size)
+            {
+                const size_t size = std::min(fill_chunk_size, n - begin);
+                for (int d = 0; d != dimension; ++d)
+                {
+                    ClampAndFindBins(*axes[d], size, values[d] + begin, clamped[d], bins[d]);
+                }
+                for (size_t i = 0; i != size; ++i)
+                {
+                    const double w = (weights ? weights[begin + i] : 1.0);
+                    switch (dimension)
+                    {
+                        case 1: hist.Fill(clamped[0][i], w); break;
+                        case 2: static_cast<TH2&>(hist).Fill(clamped[0][i], clamped[1][i], w); break;
+                        case 3: static_cast<TH3&>(hist).Fill(clamped[0][i], clamped[1][i], clamped[2][i], w); break;
+                    }
+                }
+            }
+            return;
+        }
+
+        // TH1::Fill switches to Sumw2 at the first weight that isn't 1
+        if (weights && hist.GetSumw2N() == 0 && not hist.TestBit(TH1::kIsNotW))
+        {
+            for (size_t i = 0; i != n; ++i)
+            {
+                if (weights[i] != 1.0)
+                {
+                    hist.Sumw2();
+                    break;
+                }
+            }
+        }
+        TArrayD& sumw2 = *hist.GetSumw2();
+
+        // sumw, sumw2, sumwx, sumwx2, sumwy, sumwy2, sumwxy, sumwz, sumwz2, sumwxz, sumwyz
+        double stats[11] = {0};
+        hist.GetStats(stats);
+
+        const int stride_x = axes[0]->GetNbins() + 2;
+        const int stride_y = axes[1]->GetNbins() + 2;
+        for (size_t begin = 0; begin < n; begin += fill_chunk_size)
+        {
+            const size_t size = std::min(fill_chunk_size, n - begin);
+            for (int d = 0; d != dimension; ++d)
+            {
+                ClampAndFindBins(*axes[d], size, values[d] + begin, clamped[d], bins[d]);
+            }
+            for (size_t i = 0; i != size; ++i)
+            {
+                const double w = (weights ? weights[begin + i] : 1.0);
+                const double x = clamped[0][i];
+                int bin = bins[0][i];
+                stats[0] += w;
+                stats[1] += w * w;
+                stats[2] += w * x;
+                stats[3] += w * x * x;
+                if (dimension > 1)
+                {
+                    const double y = clamped[1][i];
+                    bin += stride_x * bins[1][i];
+                    stats[4] += w * y;
+                    stats[5] += w * y * y;
+                    stats[6] += w * x * y;
+                    if (dimension > 2)
+                    {
+                        const double z = clamped[2][i];
+                        bin += stride_x * stride_y * bins[2][i];
+                        stats[7]  += w * z;
+                        stats[8]  += w * z * z;
+                        stats[9]  += w * x * z;
+                        stats[10] += w * y * z;
+                    }
+                }
+                if (sumw2.fN)
+                {
+                    sumw2.fArray[bin] += w * w;
+                }
+                hist.AddBinContent(bin, w);
+            }
+        }
+        hist.PutStats(stats);
+        hist.SetEntries(hist.GetEntries() + n);
+    }
+
+    void Fill1D(TH1& hist, const size_t n, const double* const x, const double* const weights)
+    {
+        const double* const values[3] = {x, NULL, NULL};
+        FillN(hist, 1, n, values, weights);
+    }
+
+    void Fill1D(TH1& hist, const std::vector<double>& x)
+    {
+        if (x.empty()) {return;}
+        Fill1D(hist, x.size(), &x[0]);
+    }
+
+    void Fill1D(TH1& hist, const std::vector<double>& x, const std::vector<double>& weights)
+    {
+        if (x.size() != weights.size())
+        {
+            throw std::invalid_argument("[rt::Fill1D] Error: the values and weights have different sizes");
+        }
+        if (x.empty()) {return;}
+        Fill1D(hist, x.size(), &x[0], &weights[0]);
+    }
+
+    void Fill1D(TH1* hist_ptr, const std::vector<double>& x)
+    {
+        if (!hist_ptr)
+        {
+            std::cerr << "[rt::Fill1D] Warning: -- hist pointer is NULL! Doing nothing." << std::endl;
+            return;
+        }
+        Fill1D(*hist_ptr, x);
+    }
+
+    void Fill1D(TH1* hist_ptr, const std::vector<double>& x, const std::vector<double>& weights)
+    {
+        if (!hist_ptr)
+        {
+            std::cerr << "[rt::Fill1D] Warning: -- hist pointer is NULL! Doing nothing." << std::endl;
+            return;
+        }
+        Fill1D(*hist_ptr, x, weights);
+    }
+
+    void Fill2D(TH2& hist, const size_t n, const double* const x, const double* const y, const double* const weights)
+    {
+        const double* const values[3] = {x, y, NULL};
+        FillN(hist, 2, n, values, weights);
+    }
+
+    void Fill2D(TH2& hist, const std::vector<double>& x, const std::vector<double>& y)
+    {
+        if (x.size() != y.size())
+        {
+            throw std::invalid_argument("[rt::Fill2D] Error: the x and y values have different sizes");
+        }
+        if (x.empty()) {return;}
+        Fill2D(hist, x.size(), &x[0], &y[0]);
+    }
+
+    void Fill2D(TH2& hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& weights)
+    {
+        if (x.size() != y.size() || x.size() != weights.size())
+        {
+            throw std::invalid_argument("[rt::Fill2D] Error: the x and y values and weights have different sizes");
+        }
+        if (x.empty()) {return;}
+        Fill2D(hist, x.size(), &x[0], &y[0], &weights[0]);
+    }
+
+    void Fill2D(TH2* hist_ptr, const std::vector<double>& x, const std::vector<double>& y)
+    {
+        if (!hist_ptr)
+        {
+            std::cerr << "[rt::Fill2D] Warning: -- hist pointer is NULL! Doing nothing." << std::endl;
+            return;
+        }
+        Fill2D(*hist_ptr, x, y);
+    }
+
+    void Fill2D(TH2* hist_ptr, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& weights)
+    {
+        if (!hist_ptr)
+        {
+            std::cerr << "[rt::Fill2D] Warning: -- hist pointer is NULL! Doing nothing." << std::endl;
+            return;
+        }
+        Fill2D(*hist_ptr, x, y, weights);
+    }
+
+    void Fill3D(TH3& hist, const size_t n, const double* const x, const double* const y, const double* const z, const double* const weights)
+    {
+        const double* const values[3] = {x, y, z};
+        FillN(hist, 3, n, values, weights);
+    }
+
+    void Fill3D(TH3& hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z)
+    {
+        if (x.size() != y.size() || x.size() != z.size())
+        {
+            throw std::invalid_argument("[rt::Fill3D] Error: the x, y and z values have different sizes");
+        }
+        if (x.empty()) {return;}
+        Fill3D(hist, x.size(), &x[0], &y[0], &z[0]);
+    }
+
+    void Fill3D(TH3& hist, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& weights)
+    {
+        if (x.size() != y.size() || x.size() != z.size() || x.size() != weights.size())
+        {
+            throw std::invalid_argument("[rt::Fill3D] Error: the x, y and z values and weights have different sizes");
+        }
+        if (x.empty()) {return;}
+        Fill3D(hist, x.size(), &x[0], &y[0], &z[0], &weights[0]);
+    }
+
+    void Fill3D(TH3* hist_ptr, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z)
+    {
+        if (!hist_ptr)
+        {
+            std::cerr << "[rt::Fill3D] Warning: -- hist pointer is NULL! Doing nothing." << std::endl;
+            return;
+        }
+        Fill3D(*hist_ptr, x, y, z);
+    }
+
+    void Fill3D(TH3* hist_ptr, const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& weights)
+    {
+        if (!hist_ptr)
+        {
+            std::cerr << "[rt::Fill3D] Warning: -- hist pointer is NULL! Doing nothing." << std::endl;
+            return;
+        }
+        Fill3D(*hist_ptr, x, y, z, weights);
+    }
+
 } // namespace rt
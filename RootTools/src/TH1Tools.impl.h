@@ -25,33 +25,46 @@ namespace rt
         return hist_ptr;
     }
 
-    // only works on compile time arrays (e.g. float bins[] = {1,2,3};)
-    template <int N> unsigned int find_bin(const float value, const float (&bins)[N])
+    namespace detail
     {
-        int index = 0;
-        for (size_t i=0; i != N-1; i++)
+        // number of bins[1..I] <= value (unrolled at compile time, no branches)
+        template <typename T, int I>
+        struct CountEdgesBelow
         {
-            if (bins[i] < value && value < bins[i+1]) 
+            static unsigned int apply(const T value, const T* const bins)
             {
-                index=i;
-                break;
+                return static_cast<unsigned int>(bins[I] <= value) + CountEdgesBelow<T, I - 1>::apply(value, bins);
             }
-        }
-        return index;
-    }
+        };
 
-    template <int N> unsigned int find_bin(const double value, const double (&bins)[N])
-    {
-        int index = 0;
-        for (size_t i=0; i != N-1; i++)
+        template <typename T>
+        struct CountEdgesBelow<T, 0>
         {
-            if (bins[i] < value && value < bins[i+1]) 
+            static unsigned int apply(const T, const T* const)
             {
-                index=i;
-                break;
+                return 0;
             }
+        };
+
+        template <typename T, int N>
+        unsigned int find_bin(const T value, const T (&bins)[N])
+        {
+            const unsigned int index = CountEdgesBelow<T, (N > 2 ? N - 2 : 0)>::apply(value, bins);
+            const bool inside        = (bins[0] <= value) & (value < bins[N - 1]);
+            return (inside ? index : 0);
         }
-        return index;
+
+    } // namespace detail
+
+    // only works on compile time arrays (e.g. float bins[] = {1,2,3};)
+    template <int N> unsigned int find_bin(const float value, const float (&bins)[N])
+    {
+        return detail::find_bin(value, bins);
+    }
+
+    template <int N> unsigned int find_bin(const double value, const double (&bins)[N])
+    {
+        return detail::find_bin(value, bins);
     }
 
 } // namespace rt